@@ -0,0 +1,243 @@
+#ifndef FLT_IO_ARCHIVE_SEARCH_HPP
+#define FLT_IO_ARCHIVE_SEARCH_HPP
+
+#include <flt/io/template_archive.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace flt::io {
+enum class compare_op {
+  equal,
+  not_equal,
+  less,
+  less_equal,
+  greater,
+  greater_equal
+};
+
+// Compares the parameter at a slot of a template with a value. Parameters and
+// values that are both integers are compared as numbers, else as strings.
+struct param_predicate {
+  std::size_t slot;
+  compare_op op;
+  std::string value;
+};
+
+// Searches archive blocks for lines containing a text, optionally restricted
+// to templates containing a pattern and to parameter values. The templates of
+// a block are checked first: lines of templates that can't contain the text
+// are skipped without decoding their parameters, and lines of templates
+// containing the text in their static pieces match without being searched.
+class archive_query {
+public:
+  // Parameters are written as <*> in template patterns
+  static constexpr std::string_view wildcard{"<*>"};
+
+  explicit archive_query(std::string text = {}) : text_(std::move(text)) {}
+
+  archive_query& template_contains(std::string pattern) {
+    template_pattern_ = std::move(pattern);
+    return *this;
+  }
+
+  archive_query& where(std::size_t slot, compare_op op, std::string value) {
+    predicates_.push_back({slot, op, std::move(value)});
+    predicate_integers_.push_back(parse_any_integer(predicates_.back().value));
+    return *this;
+  }
+
+  // Appends the matching lines of the block to lines if given, returns the
+  // number of matching lines.
+  std::size_t search(const archive_block& block,
+                     std::vector<std::string>* lines = nullptr) const {
+    const auto& templates = block.templates();
+    auto states = std::vector<template_state>(templates.size());
+    auto any_candidates = false;
+    for (auto t = std::size_t{0}; t < templates.size(); ++t) {
+      states[t] = classify(templates[t]);
+      any_candidates |= states[t] != template_state::skip;
+    }
+    if (!any_candidates)
+      return 0;
+
+    // Columns are decoded on first use, only for candidate templates
+    auto columns = std::vector<std::vector<std::optional<archive_column>>>(
+        templates.size());
+    const auto column = [&](std::size_t t,
+                            std::size_t slot) -> const archive_column& {
+      auto& template_columns = columns[t];
+      if (template_columns.empty())
+        template_columns.resize(templates[t].num_slots());
+      auto& cached = template_columns[slot];
+      if (!cached)
+        cached = block.column(t, slot);
+      return *cached;
+    };
+
+    const auto ids = block.template_ids();
+    auto positions = std::vector<std::size_t>(templates.size(), 0);
+    auto line = std::string{};
+    auto num_matches = std::size_t{0};
+    for (auto id : ids) {
+      const auto state = states[id];
+      const auto pos = positions[id]++;
+      if (state == template_state::skip)
+        continue;
+      auto accepted = true;
+      for (auto p = std::size_t{0}; p < predicates_.size() && accepted; ++p)
+        accepted = compare(column(id, predicates_[p].slot), pos, p);
+      if (!accepted)
+        continue;
+      if (lines || state == template_state::check) {
+        const auto& pieces = templates[id].pieces;
+        line = pieces[0];
+        for (auto slot = std::size_t{0}; slot + 1 < pieces.size(); ++slot) {
+          const auto& values = column(id, slot);
+          if (pos >= values.size())
+            detail::throw_corrupt_archive();
+          line += values[pos];
+          line += pieces[slot + 1];
+        }
+        if (state == template_state::check &&
+            line.find(text_) == std::string::npos)
+          continue;
+        if (lines)
+          lines->push_back(line);
+      }
+      ++num_matches;
+    }
+    return num_matches;
+  }
+
+  // Text of a template with its parameters written as wildcards
+  static std::string template_text(const archive_template& templ) {
+    auto text = templ.pieces[0];
+    for (auto i = std::size_t{1}; i < templ.pieces.size(); ++i) {
+      text += wildcard;
+      text += templ.pieces[i];
+    }
+    return text;
+  }
+
+private:
+  // Lines of a template are skipped, all contain the text or need checking
+  enum class template_state { skip, all, check };
+
+  template_state classify(const archive_template& templ) const {
+    if (!template_pattern_.empty() &&
+        template_text(templ).find(template_pattern_) == std::string::npos)
+      return template_state::skip;
+    for (const auto& predicate : predicates_)
+      if (predicate.slot >= templ.num_slots())
+        return template_state::skip;
+    if (text_.empty())
+      return template_state::all;
+    for (const auto& piece : templ.pieces)
+      if (piece.find(text_) != std::string::npos)
+        return template_state::all;
+    return may_contain_text(templ) ? template_state::check
+                                   : template_state::skip;
+  }
+
+  // Whether the text can occur in a line of the template, where parameters
+  // are runs of non-separator characters. Matches the text against the
+  // template with a set of template positions as states.
+  bool may_contain_text(const archive_template& templ) const {
+    auto items = std::string{};
+    auto is_slot = std::vector<bool>{};
+    for (auto i = std::size_t{0}; i < templ.pieces.size(); ++i) {
+      if (i > 0) {
+        items.push_back('\0');
+        is_slot.push_back(true);
+      }
+      items += templ.pieces[i];
+      is_slot.resize(items.size(), false);
+    }
+    const auto size = items.size();
+    // The text may start anywhere, also within a parameter
+    auto states = std::vector<bool>(size + 1, true);
+    auto next = std::vector<bool>(size + 1);
+    for (auto c : text_) {
+      const auto is_param_char =
+          !detail::archive_separators[static_cast<unsigned char>(c)];
+      std::fill(next.begin(), next.end(), false);
+      auto any = false;
+      for (auto p = std::size_t{0}; p < size; ++p) {
+        if (!states[p])
+          continue;
+        if (is_slot[p]) {
+          // The parameter goes on, or ends and the next item follows
+          if (is_param_char)
+            any = next[p] = true;
+          states[p + 1] = true;
+        } else if (items[p] == c) {
+          any = next[p + 1] = true;
+        }
+      }
+      if (!any)
+        return false;
+      std::swap(states, next);
+    }
+    return true;
+  }
+
+  static std::optional<std::int64_t> parse_any_integer(std::string_view text) {
+    auto value = std::int64_t{0};
+    const auto [end, error] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != std::errc{} ||
+        end != text.data() + text.size())
+      return std::nullopt;
+    return value;
+  }
+
+  bool compare(const archive_column& column, std::size_t pos,
+               std::size_t predicate) const {
+    if (pos >= column.size())
+      detail::throw_corrupt_archive();
+    const auto& value = predicates_[predicate].value;
+    auto order = 0;
+    const auto& integer = predicate_integers_[predicate];
+    auto param = std::optional<std::int64_t>{};
+    if (integer)
+      param = column.kind() == column_kind::integers
+                  ? std::optional{column.integers()[pos]}
+                  : parse_any_integer(column[pos]);
+    if (param)
+      order = *param < *integer ? -1 : *param > *integer;
+    else
+      order = column[pos].compare(value);
+    switch (predicates_[predicate].op) {
+    case compare_op::equal:
+      return order == 0;
+    case compare_op::not_equal:
+      return order != 0;
+    case compare_op::less:
+      return order < 0;
+    case compare_op::less_equal:
+      return order <= 0;
+    case compare_op::greater:
+      return order > 0;
+    default:
+      return order >= 0;
+    }
+  }
+
+  std::string text_;
+  std::string template_pattern_;
+  std::vector<param_predicate> predicates_;
+  std::vector<std::optional<std::int64_t>> predicate_integers_;
+};
+} // namespace flt::io
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef FLT_IO_COMPRESSED_INPUT_HPP
+#define FLT_IO_COMPRESSED_INPUT_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef FLT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FLT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace flt::io {
+enum class compression { none, gzip, zstd };
+
+// Only needs the first four bytes of the input
+inline compression detect_compression(std::string_view head) {
+  if (head.size() >= 2 && head[0] == '\x1f' && head[1] == '\x8b')
+    return compression::gzip;
+  if (head.size() >= 4 && head.substr(0, 4) == "\x28\xb5\x2f\xfd")
+    return compression::zstd;
+  return compression::none;
+}
+
+inline bool is_supported(compression format) {
+  switch (format) {
+  case compression::gzip:
+#ifdef FLT_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+  case compression::zstd:
+#ifdef FLT_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  default:
+    return true;
+  }
+}
+
+namespace detail {
+// Decompresses on a separate thread into a fixed set of reusable chunks. The
+// input function returns the next piece of compressed input, an empty view
+// at its end, and is only called on the decompression thread.
+class threaded_decompressor {
+public:
+  using input_function = std::function<std::string_view()>;
+
+  threaded_decompressor(compression format, input_function input,
+                        std::size_t chunk_size = 4 << 20,
+                        std::size_t num_chunks = 4)
+      : format_(format), input_(std::move(input)) {
+    if (!is_supported(format_))
+      throw std::runtime_error{format_ == compression::gzip
+                                   ? "gzip input needs zlib support"
+                                   : "zstd input needs libzstd support"};
+    for (auto i = std::size_t{0}; i < num_chunks; ++i)
+      free_chunks_.emplace_back(chunk_size);
+    thread_ = std::thread{[this] { run(); }};
+  }
+
+  threaded_decompressor(const threaded_decompressor&) = delete;
+  threaded_decompressor& operator=(const threaded_decompressor&) = delete;
+
+  // Waits for a pending call of the input function to return
+  ~threaded_decompressor() {
+    {
+      auto lock = std::lock_guard{mutex_};
+      stop_ = true;
+    }
+    free_cv_.notify_all();
+    thread_.join();
+  }
+
+  // Copies up to size decompressed bytes, returns 0 at the end of the input
+  std::size_t read(char* data, std::size_t size) {
+    if (current_pos_ == current_.size && !next_chunk())
+      return 0;
+    const auto num_read = std::min(size, current_.size - current_pos_);
+    std::memcpy(data, current_.data.data() + current_pos_, num_read);
+    current_pos_ += num_read;
+    return num_read;
+  }
+
+private:
+  struct chunk {
+    explicit chunk(std::size_t capacity = 0) : data(capacity) {}
+    std::vector<char> data;
+    std::size_t size{0};
+  };
+
+  bool next_chunk() {
+    auto lock = std::unique_lock{mutex_};
+    if (!current_.data.empty()) {
+      free_chunks_.push_back(std::move(current_));
+      free_cv_.notify_one();
+    }
+    full_cv_.wait(lock, [this] { return !full_chunks_.empty() || done_; });
+    if (full_chunks_.empty()) {
+      current_ = chunk{};
+      current_pos_ = 0;
+      if (error_)
+        std::rethrow_exception(error_);
+      return false;
+    }
+    current_ = std::move(full_chunks_.front());
+    full_chunks_.pop_front();
+    current_pos_ = 0;
+    return true;
+  }
+
+  // Returns false if the decompressor was stopped
+  bool get_free_chunk(chunk& free_chunk) {
+    auto lock = std::unique_lock{mutex_};
+    free_cv_.wait(lock, [this] { return !free_chunks_.empty() || stop_; });
+    if (stop_)
+      return false;
+    free_chunk = std::move(free_chunks_.front());
+    free_chunks_.pop_front();
+    return true;
+  }
+
+  void push_full_chunk(chunk&& full_chunk) {
+    {
+      auto lock = std::lock_guard{mutex_};
+      full_chunks_.push_back(std::move(full_chunk));
+    }
+    full_cv_.notify_one();
+  }
+
+  void run() {
+    try {
+      if (format_ == compression::gzip)
+        run_gzip();
+      else
+        run_zstd();
+    } catch (...) {
+      auto lock = std::lock_guard{mutex_};
+      error_ = std::current_exception();
+    }
+    {
+      auto lock = std::lock_guard{mutex_};
+      done_ = true;
+    }
+    full_cv_.notify_one();
+  }
+
+  // Concatenated gzip members, as produced by appending to a .gz file, are
+  // decompressed one after the other. Input ending within a member or frame
+  // is reported as truncated.
+  void run_gzip() {
+#ifdef FLT_HAVE_ZLIB
+    auto stream = z_stream{};
+    if (inflateInit2(&stream, 15 + 16) != Z_OK)
+      throw std::runtime_error{"Couldn't initialize zlib"};
+    auto input = std::string_view{};
+    auto input_done = false;
+    // Whether a member was started but not finished yet
+    auto in_member = false;
+    auto at_end = false;
+    auto out = chunk{};
+    while (!at_end && get_free_chunk(out)) {
+      out.size = 0;
+      while (out.size < out.data.size()) {
+        if (input.empty() && !input_done) {
+          input = input_();
+          input_done = input.empty();
+        }
+        if (input_done && !in_member) {
+          at_end = true;
+          break;
+        }
+        const auto avail_in = std::min<std::size_t>(input.size(), 1u << 30);
+        stream.next_in =
+            reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+        stream.avail_in = uInt(avail_in);
+        stream.next_out = reinterpret_cast<Bytef*>(out.data.data() + out.size);
+        stream.avail_out = uInt(out.data.size() - out.size);
+        in_member = true;
+        const auto result = inflate(&stream, Z_NO_FLUSH);
+        input.remove_prefix(avail_in - stream.avail_in);
+        out.size = out.data.size() - stream.avail_out;
+        if (result == Z_STREAM_END) {
+          in_member = false;
+          inflateReset(&stream);
+        } else if (result == Z_BUF_ERROR && input_done) {
+          inflateEnd(&stream);
+          throw std::runtime_error{"Truncated gzip input"};
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+          inflateEnd(&stream);
+          throw std::runtime_error{"Corrupt gzip input"};
+        }
+      }
+      if (out.size > 0)
+        push_full_chunk(std::move(out));
+    }
+    inflateEnd(&stream);
+#endif
+  }
+
+  void run_zstd() {
+#ifdef FLT_HAVE_ZSTD
+    auto* stream = ZSTD_createDStream();
+    if (!stream)
+      throw std::runtime_error{"Couldn't initialize libzstd"};
+    auto input = ZSTD_inBuffer{nullptr, 0, 0};
+    auto input_done = false;
+    // Whether a frame was started but not finished and flushed yet
+    auto in_frame = false;
+    auto at_end = false;
+    auto out = chunk{};
+    while (!at_end && get_free_chunk(out)) {
+      auto output = ZSTD_outBuffer{out.data.data(), out.data.size(), 0};
+      while (output.pos < output.size) {
+        if (input.pos == input.size && !input_done) {
+          const auto next_input = input_();
+          input_done = next_input.empty();
+          if (!input_done)
+            input = ZSTD_inBuffer{next_input.data(), next_input.size(), 0};
+        }
+        if (input_done && !in_frame) {
+          at_end = true;
+          break;
+        }
+        const auto output_pos = output.pos;
+        const auto result = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(result)) {
+          ZSTD_freeDStream(stream);
+          throw std::runtime_error{"Corrupt zstd input"};
+        }
+        in_frame = result != 0;
+        if (in_frame && input_done && output.pos == output_pos) {
+          ZSTD_freeDStream(stream);
+          throw std::runtime_error{"Truncated zstd input"};
+        }
+      }
+      out.size = output.pos;
+      if (out.size > 0)
+        push_full_chunk(std::move(out));
+    }
+    ZSTD_freeDStream(stream);
+#endif
+  }
+
+  compression format_;
+  input_function input_;
+  std::mutex mutex_;
+  std::condition_variable free_cv_;
+  std::condition_variable full_cv_;
+  std::deque<chunk> free_chunks_;
+  std::deque<chunk> full_chunks_;
+  bool stop_{false};
+  bool done_{false};
+  std::exception_ptr error_;
+  // Only accessed by the reading thread
+  chunk current_;
+  std::size_t current_pos_{0};
+  std::thread thread_;
+};
+} // namespace detail
+} // namespace flt::io
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef FLT_IO_FILE_FOLLOWER_HPP
+#define FLT_IO_FILE_FOLLOWER_HPP
+
+#include <flt/io/line_reader.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#if __has_include(<unistd.h>) && __has_include(<sys/stat.h>)
+#define FLT_IO_HAVE_FILE_FOLLOWER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(FLT_IO_HAVE_FILE_FOLLOWER) && __has_include(<sys/inotify.h>) &&  \
+    __has_include(<poll.h>)
+#define FLT_IO_HAVE_INOTIFY
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace flt::io {
+#ifdef FLT_IO_HAVE_FILE_FOLLOWER
+// Reads the lines appended to a growing file, like tail -F. When the file is
+// replaced, e.g. by log rotation, the rest of the old file is read before
+// the new one, which is read from its start. A file truncated in place is
+// read again from its start. Changes are waited for with inotify on the
+// directory of the file, or by polling where inotify isn't available. The
+// poll interval also bounds the wait for changes inotify doesn't report,
+// e.g. on network file systems.
+class file_follower {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  explicit file_follower(
+      std::string filename, bool from_start = true,
+      std::chrono::milliseconds poll_interval = std::chrono::milliseconds{250},
+      std::size_t buffer_size = 1 << 16)
+      : filename_(std::move(filename)), poll_interval_(poll_interval),
+        buffer_(buffer_size) {
+    fd_ = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0)
+      throw std::system_error{errno, std::generic_category(),
+                              "Couldn't open " + filename_};
+    if (!from_start)
+      offset_ = std::max(::lseek(fd_, 0, SEEK_END), off_t{0});
+#ifdef FLT_IO_HAVE_INOTIFY
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0) {
+      const auto slash = filename_.rfind('/');
+      const auto directory = slash == std::string::npos ? std::string{"."}
+                             : slash == 0 ? std::string{"/"}
+                                          : filename_.substr(0, slash);
+      if (::inotify_add_watch(inotify_fd_, directory.c_str(),
+                              IN_MODIFY | IN_CREATE | IN_DELETE |
+                                  IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) <
+          0) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+      }
+    }
+#endif
+  }
+
+  file_follower(const file_follower&) = delete;
+  file_follower& operator=(const file_follower&) = delete;
+
+  ~file_follower() {
+    ::close(fd_);
+#ifdef FLT_IO_HAVE_INOTIFY
+    if (inotify_fd_ >= 0)
+      ::close(inotify_fd_);
+#endif
+  }
+
+  // Returns false if no complete line was appended within the timeout. A
+  // partial line is only returned once it is completed, or when its file
+  // was replaced. Lines stay valid until the next call.
+  bool next(std::string_view& line, std::chrono::milliseconds timeout) {
+    const auto deadline = clock_type::now() + timeout;
+    for (;;) {
+      if (buffer_.next_line(line))
+        return true;
+      if (flush_rest_) {
+        flush_rest_ = false;
+        if (buffer_.take_rest(line))
+          return true;
+      }
+      if (read_file() > 0 || check_file())
+        continue;
+      const auto now = clock_type::now();
+      if (now >= deadline)
+        return false;
+      wait_for_change(
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                now) +
+          std::chrono::milliseconds{1});
+    }
+  }
+
+  bool uses_inotify() const { return inotify_fd_ >= 0; }
+  std::uint64_t num_rotations() const { return num_rotations_; }
+  std::uint64_t num_truncations() const { return num_truncations_; }
+
+private:
+  std::size_t read_file() {
+    return buffer_.fill([this](char* data, std::size_t size) {
+      for (;;) {
+        const auto num_read = ::read(fd_, data, size);
+        if (num_read >= 0) {
+          offset_ += num_read;
+          return std::size_t(num_read);
+        }
+        if (errno != EINTR)
+          throw std::system_error{errno, std::generic_category(),
+                                  "Couldn't read " + filename_};
+      }
+    });
+  }
+
+  // Called at the end of the file, returns whether it was truncated or
+  // replaced.
+  bool check_file() {
+    struct stat file_stat;
+    if (::fstat(fd_, &file_stat) != 0)
+      return false;
+    if (file_stat.st_size < offset_) {
+      ::lseek(fd_, 0, SEEK_SET);
+      offset_ = 0;
+      buffer_.clear();
+      ++num_truncations_;
+      return true;
+    }
+    // The file is kept open while its name doesn't exist
+    struct stat path_stat;
+    if (::stat(filename_.c_str(), &path_stat) != 0 ||
+        (path_stat.st_dev == file_stat.st_dev &&
+         path_stat.st_ino == file_stat.st_ino))
+      return false;
+    const auto fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    // Lines written to the old file until it was replaced aren't lost
+    while (read_file() > 0) {
+    }
+    ::close(fd_);
+    fd_ = fd;
+    offset_ = 0;
+    flush_rest_ = true;
+    ++num_rotations_;
+    return true;
+  }
+
+  void wait_for_change(std::chrono::milliseconds timeout) {
+    timeout = std::min(timeout, poll_interval_);
+#ifdef FLT_IO_HAVE_INOTIFY
+    if (inotify_fd_ >= 0) {
+      auto poll_fd = pollfd{inotify_fd_, POLLIN, 0};
+      if (::poll(&poll_fd, 1, int(timeout.count())) > 0) {
+        // Any event leads to checking the file again, so they are discarded
+        alignas(inotify_event) char events[4096];
+        while (::read(inotify_fd_, events, sizeof(events)) > 0) {
+        }
+      }
+      return;
+    }
+#endif
+    std::this_thread::sleep_for(timeout);
+  }
+
+  std::string filename_;
+  std::chrono::milliseconds poll_interval_;
+  detail::line_buffer buffer_;
+  int fd_{-1};
+  int inotify_fd_{-1};
+  // Bytes of the current file read into the buffer
+  off_t offset_{0};
+  // The partial line at the end of a replaced file is returned as a line
+  bool flush_rest_{false};
+  std::uint64_t num_rotations_{0};
+  std::uint64_t num_truncations_{0};
+};
+#else
+// Following files needs POSIX file identities to detect rotations
+class file_follower {
+public:
+  explicit file_follower(std::string, bool = true,
+                         std::chrono::milliseconds = {}, std::size_t = 0) {
+    throw std::runtime_error{"Following files is not supported here"};
+  }
+
+  bool next(std::string_view&, std::chrono::milliseconds) { return false; }
+  bool uses_inotify() const { return false; }
+  std::uint64_t num_rotations() const { return 0; }
+  std::uint64_t num_truncations() const { return 0; }
+};
+#endif
+} // namespace flt::io
+
+#endif
@@ -0,0 +1,315 @@
+#ifndef FLT_IO_LINE_READER_HPP
+#define FLT_IO_LINE_READER_HPP
+
+#include <flt/io/compressed_input.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#define FLT_IO_HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace flt::io {
+namespace detail {
+// Splits the data read into it into lines. A partial line at the end is kept
+// until the rest of it is read, the buffer grows if the line fills all of it.
+class line_buffer {
+public:
+  explicit line_buffer(std::size_t size) : data_(size) {
+    if (data_.empty())
+      throw std::invalid_argument{"Buffer size must not be zero"};
+  }
+
+  std::size_t capacity() const { return data_.size(); }
+
+  // Unreturned data
+  std::string_view contents() const {
+    return std::string_view{data_.data() + begin_, end_ - begin_};
+  }
+
+  // Lines stay valid until the next call of fill
+  bool next_line(std::string_view& line) {
+    auto* data = data_.data();
+    if (const auto* newline = static_cast<const char*>(
+            std::memchr(data + scan_pos_, '\n', end_ - scan_pos_))) {
+      line = std::string_view{data + begin_,
+                              std::size_t(newline - data) - begin_};
+      begin_ = scan_pos_ = std::size_t(newline - data) + 1;
+      return true;
+    }
+    scan_pos_ = end_;
+    return false;
+  }
+
+  // Returns the partial line at the end, if there is one
+  bool take_rest(std::string_view& line) {
+    if (begin_ == end_)
+      return false;
+    line = contents();
+    begin_ = scan_pos_ = end_;
+    return true;
+  }
+
+  // Reads at most max_size bytes with read(data, size) after the unreturned
+  // data, returns the number of bytes read.
+  template <typename Read>
+  std::size_t fill(Read read, std::size_t max_size = std::size_t(-1)) {
+    if (begin_ > 0) {
+      std::memmove(data_.data(), data_.data() + begin_, end_ - begin_);
+      end_ -= begin_;
+      scan_pos_ -= begin_;
+      begin_ = 0;
+    }
+    if (end_ == data_.size())
+      data_.resize(data_.size() * 2);
+    const auto num_read =
+        read(data_.data() + end_, std::min(data_.size() - end_, max_size));
+    end_ += num_read;
+    return num_read;
+  }
+
+  void clear() { begin_ = end_ = scan_pos_ = 0; }
+
+private:
+  std::vector<char> data_;
+  // Unreturned data and how far it was searched for newlines
+  std::size_t begin_{0};
+  std::size_t end_{0};
+  std::size_t scan_pos_{0};
+};
+} // namespace detail
+
+// Splits a file into lines without copying them. Regular files are memory
+// mapped, other inputs like pipes are read in large chunks into a buffer. A
+// filename of "-" reads from stdin. Lines are returned without the newline,
+// like std::getline does. Input compressed with gzip or zstd is detected by
+// its magic bytes and decompressed on a separate thread.
+class line_reader {
+public:
+  explicit line_reader(const std::string& filename, bool allow_mmap = true,
+                       std::size_t buffer_size = 1 << 20)
+      : buffer_(buffer_size) {
+#ifdef FLT_IO_HAVE_MMAP
+    if (filename == "-") {
+      fd_ = STDIN_FILENO;
+    } else {
+      fd_ = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd_ < 0)
+        throw std::system_error{errno, std::generic_category(),
+                                "Couldn't open " + filename};
+      owns_file_ = true;
+    }
+    struct stat file_stat;
+    if (allow_mmap && ::fstat(fd_, &file_stat) == 0 &&
+        S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+      auto* mapping = ::mmap(nullptr, std::size_t(file_stat.st_size),
+                             PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (mapping != MAP_FAILED) {
+        ::madvise(mapping, std::size_t(file_stat.st_size), MADV_SEQUENTIAL);
+        mapping_ = static_cast<const char*>(mapping);
+        mapping_size_ = mapping_end_ = std::size_t(file_stat.st_size);
+      }
+    }
+#else
+    static_cast<void>(allow_mmap);
+    if (filename == "-") {
+      file_ = stdin;
+    } else {
+      file_ = std::fopen(filename.c_str(), "rb");
+      if (!file_)
+        throw std::system_error{errno, std::generic_category(),
+                                "Couldn't open " + filename};
+      owns_file_ = true;
+    }
+#endif
+    try {
+      detect_compression_and_start();
+    } catch (...) {
+      close();
+      throw;
+    }
+  }
+
+  line_reader(const line_reader&) = delete;
+  line_reader& operator=(const line_reader&) = delete;
+
+  ~line_reader() { close(); }
+
+  bool is_mapped() const { return mapping_ && !decompressor_; }
+
+  // Restricts reading to the lines starting within the part-th of num_parts
+  // equally sized byte ranges of the file, so every line belongs to exactly
+  // one part. Only mapped files can be split, must be called before reading.
+  void select_part(std::size_t part, std::size_t num_parts) {
+    if (part >= num_parts)
+      throw std::invalid_argument{"Invalid part of file"};
+    if (!is_mapped())
+      throw std::logic_error{
+          "Only uncompressed regular files can be split into parts"};
+    const auto part_begin = [this, num_parts](std::size_t i) {
+      const auto pos = mapping_size_ / num_parts * i +
+                       mapping_size_ % num_parts * i / num_parts;
+      if (pos == 0 || pos >= mapping_size_)
+        return std::min(pos, mapping_size_);
+      const auto* newline = static_cast<const char*>(
+          std::memchr(mapping_ + pos - 1, '\n', mapping_size_ - pos + 1));
+      return newline ? std::size_t(newline - mapping_) + 1 : mapping_size_;
+    };
+    mapping_pos_ = part_begin(part);
+    mapping_end_ = part_begin(part + 1);
+  }
+
+  // Lines of mapped files stay valid for the lifetime of the reader, else
+  // only until the next call.
+  bool next(std::string_view& line) {
+    if (is_mapped()) {
+      if (mapping_pos_ >= mapping_end_)
+        return false;
+      const auto* begin = mapping_ + mapping_pos_;
+      const auto rest = mapping_end_ - mapping_pos_;
+      const auto* newline =
+          static_cast<const char*>(std::memchr(begin, '\n', rest));
+      const auto length = newline ? std::size_t(newline - begin) : rest;
+      line = std::string_view{begin, length};
+      mapping_pos_ += length + 1;
+      missing_newline_ = !newline;
+      return true;
+    }
+    return next_buffered(line);
+  }
+
+  // Whether the last line returned ended the input without a newline
+  bool missing_newline() const { return missing_newline_; }
+
+private:
+  void detect_compression_and_start() {
+    if (mapping_) {
+      const auto format = detect_compression({mapping_, mapping_size_});
+      if (format != compression::none)
+        decompressor_ = std::make_unique<detail::threaded_decompressor>(
+            format, [this, done = false]() mutable {
+              auto input = done ? std::string_view{}
+                                : std::string_view{mapping_, mapping_size_};
+              done = true;
+              return input;
+            });
+      return;
+    }
+
+    // The head of unmapped input is read into the buffer for detection and
+    // handed to the decompressor as the first input if it is compressed.
+    const auto read = [this](char* data, std::size_t size) {
+      return read_file(data, size);
+    };
+    while (buffer_.contents().size() < 4 &&
+           buffer_.fill(read, 4 - buffer_.contents().size()) > 0) {
+    }
+    const auto head = buffer_.contents();
+    const auto format = detect_compression(head);
+    if (format != compression::none) {
+      input_buffer_.assign(head.begin(), head.end());
+      buffer_.clear();
+      decompressor_ = std::make_unique<detail::threaded_decompressor>(
+          format, [this, first = true,
+                   input_size = std::max(buffer_.capacity(),
+                                         std::size_t{4096})]()
+                      mutable {
+            if (!first) {
+              input_buffer_.resize(input_size);
+              input_buffer_.resize(
+                  read_file(input_buffer_.data(), input_buffer_.size()));
+            }
+            first = false;
+            return std::string_view{input_buffer_.data(),
+                                    input_buffer_.size()};
+          });
+    }
+  }
+
+  void close() {
+    decompressor_.reset();
+#ifdef FLT_IO_HAVE_MMAP
+    if (mapping_)
+      ::munmap(const_cast<char*>(mapping_), mapping_size_);
+    if (owns_file_)
+      ::close(fd_);
+#else
+    if (owns_file_)
+      std::fclose(file_);
+#endif
+  }
+
+  bool next_buffered(std::string_view& line) {
+    while (!buffer_.next_line(line)) {
+      if (eof_) {
+        if (!buffer_.take_rest(line))
+          return false;
+        missing_newline_ = true;
+        return true;
+      }
+      eof_ = buffer_.fill([this](char* data, std::size_t size) {
+               return read_some(data, size);
+             }) == 0;
+    }
+    return true;
+  }
+
+  std::size_t read_some(char* data, std::size_t size) {
+    if (decompressor_)
+      return decompressor_->read(data, size);
+    return read_file(data, size);
+  }
+
+  std::size_t read_file(char* data, std::size_t size) {
+#ifdef FLT_IO_HAVE_MMAP
+    for (;;) {
+      const auto num_read = ::read(fd_, data, size);
+      if (num_read >= 0)
+        return std::size_t(num_read);
+      if (errno != EINTR)
+        throw std::system_error{errno, std::generic_category(),
+                                "Couldn't read input"};
+    }
+#else
+    const auto num_read = std::fread(data, 1, size, file_);
+    if (num_read == 0 && std::ferror(file_))
+      throw std::runtime_error{"Couldn't read input"};
+    return num_read;
+#endif
+  }
+
+#ifdef FLT_IO_HAVE_MMAP
+  int fd_{-1};
+#else
+  std::FILE* file_{nullptr};
+#endif
+  bool owns_file_{false};
+  const char* mapping_{nullptr};
+  std::size_t mapping_size_{0};
+  std::size_t mapping_pos_{0};
+  // End of the selected part of the mapping
+  std::size_t mapping_end_{0};
+  detail::line_buffer buffer_;
+  bool eof_{false};
+  bool missing_newline_{false};
+  // Compressed input read from unmapped files, owned by the decompressor
+  std::vector<char> input_buffer_;
+  std::unique_ptr<detail::threaded_decompressor> decompressor_;
+};
+} // namespace flt::io
+
+#endif
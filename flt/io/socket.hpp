@@ -0,0 +1,182 @@
+#ifndef FLT_IO_SOCKET_HPP
+#define FLT_IO_SOCKET_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if __has_include(<sys/socket.h>) && __has_include(<netdb.h>) &&             \
+    __has_include(<sys/un.h>) && __has_include(<unistd.h>)
+#define FLT_IO_HAVE_SOCKETS
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Addresses are [host:]port, hosts may be IPv6 addresses in brackets, or
+// unix:path for Unix domain sockets.
+namespace flt::io {
+#ifdef FLT_IO_HAVE_SOCKETS
+namespace detail {
+inline constexpr std::string_view unix_prefix{"unix:"};
+
+inline bool is_unix_address(const std::string& address) {
+  return address.compare(0, unix_prefix.size(), unix_prefix) == 0;
+}
+
+// Splits [host:]port, the host is empty if not given
+inline std::pair<std::string, std::string>
+split_address(const std::string& address) {
+  if (!address.empty() && address.front() == '[') {
+    const auto end = address.find("]:");
+    if (end == std::string::npos)
+      throw std::invalid_argument{"Invalid address " + address};
+    return {address.substr(1, end - 1), address.substr(end + 2)};
+  }
+  const auto colon = address.rfind(':');
+  if (colon == std::string::npos)
+    return {std::string{}, address};
+  return {address.substr(0, colon), address.substr(colon + 1)};
+}
+
+inline int new_socket(int family, int type, int protocol) {
+#ifdef SOCK_CLOEXEC
+  return ::socket(family, type | SOCK_CLOEXEC, protocol);
+#else
+  return ::socket(family, type, protocol);
+#endif
+}
+
+[[noreturn]] inline void throw_socket_error(int error, bool passive,
+                                            const std::string& address) {
+  throw std::system_error{error, std::generic_category(),
+                          std::string{passive ? "Couldn't bind to "
+                                              : "Couldn't connect to "} +
+                              address};
+}
+
+inline int open_unix_socket(const std::string& address, int type,
+                            bool passive) {
+  const auto path = address.substr(unix_prefix.size());
+  auto unix_address = sockaddr_un{};
+  if (path.empty() || path.size() >= sizeof(unix_address.sun_path))
+    throw std::invalid_argument{"Invalid address " + address};
+  unix_address.sun_family = AF_UNIX;
+  std::memcpy(unix_address.sun_path, path.c_str(), path.size() + 1);
+  const auto fd = new_socket(AF_UNIX, type, 0);
+  if (fd < 0)
+    throw_socket_error(errno, passive, address);
+  const auto* socket_address = reinterpret_cast<sockaddr*>(&unix_address);
+  if ((passive ? ::bind(fd, socket_address, sizeof(unix_address))
+               : ::connect(fd, socket_address, sizeof(unix_address))) != 0) {
+    const auto error = errno;
+    ::close(fd);
+    throw_socket_error(error, passive, address);
+  }
+  return fd;
+}
+
+// Returns a socket bound to the address if passive, else connected to it
+inline int open_socket(const std::string& address, int type, bool passive) {
+  if (is_unix_address(address))
+    return open_unix_socket(address, type, passive);
+  const auto [host, port] = split_address(address);
+  auto hints = addrinfo{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = type;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  addrinfo* addresses = nullptr;
+  if (const auto error = ::getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                                       port.c_str(), &hints, &addresses);
+      error != 0)
+    throw std::runtime_error{"Couldn't resolve " + address + ": " +
+                             ::gai_strerror(error)};
+  auto fd = -1;
+  auto error = 0;
+  for (auto* info = addresses; info && fd < 0; info = info->ai_next) {
+    fd = new_socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (fd < 0) {
+      error = errno;
+      continue;
+    }
+    const auto one = 1;
+    if (passive && type == SOCK_STREAM)
+      ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if ((passive ? ::bind(fd, info->ai_addr, info->ai_addrlen)
+                 : ::connect(fd, info->ai_addr, info->ai_addrlen)) != 0) {
+      error = errno;
+      ::close(fd);
+      fd = -1;
+    }
+  }
+  ::freeaddrinfo(addresses);
+  if (fd < 0)
+    throw_socket_error(error, passive, address);
+  return fd;
+}
+
+inline void set_nonblocking(int fd) {
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// 0 for sockets not bound to an IP address
+inline std::uint16_t local_port(int fd) {
+  auto address = sockaddr_storage{};
+  auto size = socklen_t{sizeof(address)};
+  if (fd < 0 ||
+      ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) != 0)
+    return 0;
+  if (address.ss_family == AF_INET6)
+    return ntohs(reinterpret_cast<sockaddr_in6*>(&address)->sin6_port);
+  if (address.ss_family == AF_INET)
+    return ntohs(reinterpret_cast<sockaddr_in*>(&address)->sin_port);
+  return 0;
+}
+
+inline void write_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    const auto num_written = ::write(fd, data.data(), data.size());
+    if (num_written < 0 && errno == EINTR)
+      continue;
+    if (num_written < 0)
+      throw std::system_error{errno, std::generic_category(),
+                              "Couldn't write to socket"};
+    data.remove_prefix(std::size_t(num_written));
+  }
+}
+
+// Reads until the peer closes the connection
+inline std::string read_all(int fd) {
+  auto data = std::string{};
+  auto size = std::size_t{0};
+  for (;;) {
+    if (size == data.size())
+      data.resize(std::max(2 * size, std::size_t{65536}));
+    const auto num_read = ::read(fd, data.data() + size, data.size() - size);
+    if (num_read < 0 && errno == EINTR)
+      continue;
+    if (num_read < 0)
+      throw std::system_error{errno, std::generic_category(),
+                              "Couldn't read from socket"};
+    if (num_read == 0)
+      break;
+    size += std::size_t(num_read);
+  }
+  data.resize(size);
+  return data;
+}
+} // namespace detail
+#endif
+} // namespace flt::io
+
+#endif
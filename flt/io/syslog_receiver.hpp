@@ -0,0 +1,426 @@
+#ifndef FLT_IO_SYSLOG_RECEIVER_HPP
+#define FLT_IO_SYSLOG_RECEIVER_HPP
+
+#include <flt/io/socket.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef FLT_IO_HAVE_SOCKETS
+#if __has_include(<poll.h>) && __has_include(<sys/uio.h>)
+#define FLT_IO_HAVE_SYSLOG_RECEIVER
+#include <poll.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace flt::io {
+struct receiver_config {
+  // [host:]port to listen on, nothing is received if empty. Hosts may be
+  // IPv6 addresses in brackets, port 0 listens on a free port.
+  std::string udp_address;
+  std::string tcp_address;
+  // Datagrams received with one system call
+  std::size_t batch_size{64};
+  // Longer messages are cut
+  std::size_t max_message_size{8192};
+  // Requested UDP socket receive buffer, 0 keeps the system's default
+  int receive_buffer_size{8 << 20};
+};
+
+struct receiver_stats {
+  std::uint64_t datagrams{0};
+  std::uint64_t tcp_messages{0};
+  std::uint64_t bytes{0};
+  std::uint64_t connections{0};
+  // Datagrams dropped by the kernel because the socket buffer was full, only
+  // counted where the kernel reports them (SO_RXQ_OVFL)
+  std::uint64_t kernel_drops{0};
+  // Messages longer than the maximum message size
+  std::uint64_t truncated{0};
+  // TCP connections closed because of invalid octet counts
+  std::uint64_t framing_errors{0};
+};
+
+#ifdef FLT_IO_HAVE_SYSLOG_RECEIVER
+namespace detail {
+// Removes trailing line breaks and NUL bytes some senders append
+inline std::string_view trim_message(std::string_view message) {
+  while (!message.empty() &&
+         (message.back() == '\n' || message.back() == '\r' ||
+          message.back() == '\0'))
+    message.remove_suffix(1);
+  return message;
+}
+} // namespace detail
+
+// Receives syslog messages over UDP, one message per datagram, and TCP with
+// octet counting or newline framing (RFC 6587), chosen per message. Datagrams
+// are received in batches with recvmmsg where available. All sockets are
+// served from the calling thread.
+class syslog_receiver {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  explicit syslog_receiver(receiver_config config)
+      : config_(std::move(config)) {
+    if (config_.batch_size == 0 || config_.max_message_size == 0)
+      throw std::invalid_argument{"Batch and message sizes must be > 0"};
+    if (config_.udp_address.empty() && config_.tcp_address.empty())
+      throw std::invalid_argument{"Need an address to receive on"};
+    try {
+      if (!config_.udp_address.empty())
+        open_udp();
+      if (!config_.tcp_address.empty()) {
+        tcp_fd_ = detail::open_socket(config_.tcp_address, SOCK_STREAM, true);
+        if (::listen(tcp_fd_, SOMAXCONN) != 0)
+          throw std::system_error{errno, std::generic_category(),
+                                  "Couldn't listen on " + config_.tcp_address};
+        detail::set_nonblocking(tcp_fd_);
+      }
+    } catch (...) {
+      close_all();
+      throw;
+    }
+  }
+
+  syslog_receiver(const syslog_receiver&) = delete;
+  syslog_receiver& operator=(const syslog_receiver&) = delete;
+
+  ~syslog_receiver() { close_all(); }
+
+  // Returns false if no message arrived within the timeout. Messages stay
+  // valid until the next call.
+  bool next(std::string_view& message, std::chrono::milliseconds timeout) {
+    const auto deadline = clock_type::now() + timeout;
+    for (;;) {
+      if (next_datagram(message) || next_tcp_message(message))
+        return true;
+      if (receive() > 0)
+        continue;
+      const auto now = clock_type::now();
+      if (now >= deadline)
+        return false;
+      wait(std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                 now) +
+           std::chrono::milliseconds{1});
+    }
+  }
+
+  // The ports listened on, 0 if not listening
+  std::uint16_t udp_port() const { return detail::local_port(udp_fd_); }
+  std::uint16_t tcp_port() const { return detail::local_port(tcp_fd_); }
+
+  std::size_t num_connections() const { return connections_.size(); }
+  const receiver_stats& stats() const { return stats_; }
+
+private:
+  struct tcp_connection {
+    explicit tcp_connection(int fd) : fd(fd) {}
+
+    int fd;
+    std::string data;
+    // Start of the first message not returned yet
+    std::size_t pos{0};
+    bool closed{false};
+    // Whether the rest of a cut message is discarded up to the next newline
+    bool skipping{false};
+  };
+
+  void open_udp() {
+    udp_fd_ = detail::open_socket(config_.udp_address, SOCK_DGRAM, true);
+    detail::set_nonblocking(udp_fd_);
+    if (config_.receive_buffer_size > 0) {
+      const auto size = config_.receive_buffer_size;
+      // Beyond the system's maximum the buffer can only be forced with
+      // privileges
+#ifdef SO_RCVBUFFORCE
+      if (::setsockopt(udp_fd_, SOL_SOCKET, SO_RCVBUFFORCE, &size,
+                       sizeof(size)) != 0)
+#endif
+        ::setsockopt(udp_fd_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+#ifdef SO_RXQ_OVFL
+    const auto one = 1;
+    ::setsockopt(udp_fd_, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+#endif
+    const auto batch_size = config_.batch_size;
+    datagrams_.resize(batch_size * config_.max_message_size);
+    sizes_.resize(batch_size);
+    iovecs_.resize(batch_size);
+    for (auto i = std::size_t{0}; i < batch_size; ++i)
+      iovecs_[i] = {&datagrams_[i * config_.max_message_size],
+                    config_.max_message_size};
+#ifdef __linux__
+    controls_.resize(batch_size * control_size);
+    headers_.resize(batch_size);
+#endif
+  }
+
+  bool next_datagram(std::string_view& message) {
+    if (next_datagram_ == num_datagrams_)
+      return false;
+    const auto i = next_datagram_++;
+    message = detail::trim_message(
+        {&datagrams_[i * config_.max_message_size], sizes_[i]});
+    ++stats_.datagrams;
+    return true;
+  }
+
+  bool next_tcp_message(std::string_view& message) {
+    // Connections take turns, one message each
+    for (auto i = std::size_t{0}; i < connections_.size(); ++i) {
+      const auto pos = (next_connection_ + i) % connections_.size();
+      if (next_frame(connections_[pos], message)) {
+        next_connection_ = pos + 1;
+        ++stats_.tcp_messages;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool next_frame(tcp_connection& connection, std::string_view& message) {
+    auto data = std::string_view{connection.data}.substr(connection.pos);
+    if (connection.skipping) {
+      const auto end = data.find('\n');
+      connection.skipping = end == std::string_view::npos;
+      const auto skipped = connection.skipping ? data.size() : end + 1;
+      connection.pos += skipped;
+      data.remove_prefix(skipped);
+    }
+    if (data.empty())
+      return false;
+    // Octet counting frames start with the message length and a space
+    if (data.front() >= '1' && data.front() <= '9') {
+      auto length = std::size_t{0};
+      auto digits = std::size_t{0};
+      while (digits < data.size() && digits < 10 && data[digits] >= '0' &&
+             data[digits] <= '9')
+        length = length * 10 + std::size_t(data[digits++] - '0');
+      if (digits == data.size() && !connection.closed)
+        return false;
+      if (digits < data.size() && data[digits] == ' ') {
+        if (length > config_.max_message_size) {
+          ++stats_.framing_errors;
+          drop(connection);
+          return false;
+        }
+        if (data.size() - digits - 1 < length) {
+          if (connection.closed) {
+            ++stats_.framing_errors;
+            drop(connection);
+          }
+          return false;
+        }
+        message = detail::trim_message(data.substr(digits + 1, length));
+        connection.pos += digits + 1 + length;
+        return true;
+      }
+    }
+    const auto end = data.find('\n');
+    if (end != std::string_view::npos &&
+        end <= config_.max_message_size) {
+      message = detail::trim_message(data.substr(0, end));
+      connection.pos += end + 1;
+      return true;
+    }
+    if (data.size() >= config_.max_message_size) {
+      ++stats_.truncated;
+      message = data.substr(0, config_.max_message_size);
+      connection.pos += config_.max_message_size;
+      connection.skipping = true;
+      return true;
+    }
+    // The rest of a closed connection is a message of its own
+    if (connection.closed) {
+      message = detail::trim_message(data);
+      connection.pos = connection.data.size();
+      return true;
+    }
+    return false;
+  }
+
+  static void drop(tcp_connection& connection) {
+    connection.pos = connection.data.size();
+    connection.closed = true;
+  }
+
+  // Reads what is available without waiting, returns the number of
+  // datagrams, connections and reads of TCP data
+  std::size_t receive() {
+    auto num_events = std::size_t{0};
+    if (udp_fd_ >= 0)
+      num_events += receive_datagrams();
+    if (tcp_fd_ >= 0) {
+      for (;;) {
+        const auto fd = ::accept(tcp_fd_, nullptr, nullptr);
+        if (fd < 0)
+          break;
+        detail::set_nonblocking(fd);
+        connections_.emplace_back(fd);
+        ++stats_.connections;
+        ++num_events;
+      }
+    }
+    // Closed connections are kept until all their messages were returned
+    const auto done = std::remove_if(
+        connections_.begin(), connections_.end(), [](const auto& connection) {
+          if (!connection.closed || connection.pos < connection.data.size())
+            return false;
+          ::close(connection.fd);
+          return true;
+        });
+    connections_.erase(done, connections_.end());
+    for (auto& connection : connections_) {
+      if (connection.closed)
+        continue;
+      connection.data.erase(0, connection.pos);
+      connection.pos = 0;
+      const auto size = connection.data.size();
+      const auto chunk_size = std::max(config_.max_message_size,
+                                       std::size_t{1} << 16);
+      connection.data.resize(size + chunk_size);
+      const auto num_read =
+          ::recv(connection.fd, &connection.data[size], chunk_size, 0);
+      connection.data.resize(size + std::size_t(std::max(num_read,
+                                                          ssize_t{0})));
+      if (num_read > 0) {
+        stats_.bytes += std::uint64_t(num_read);
+        ++num_events;
+      } else if (num_read == 0 ||
+                 (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        connection.closed = true;
+        ++num_events;
+      }
+    }
+    return num_events;
+  }
+
+  std::size_t receive_datagrams() {
+    next_datagram_ = 0;
+    num_datagrams_ = 0;
+#ifdef __linux__
+    for (auto i = std::size_t{0}; i < config_.batch_size; ++i) {
+      auto& header = headers_[i].msg_hdr;
+      header = msghdr{};
+      header.msg_iov = &iovecs_[i];
+      header.msg_iovlen = 1;
+      header.msg_control = &controls_[i * control_size];
+      header.msg_controllen = control_size;
+    }
+    const auto num_received =
+        ::recvmmsg(udp_fd_, headers_.data(), unsigned(config_.batch_size),
+                   MSG_DONTWAIT, nullptr);
+    for (auto i = 0; i < num_received; ++i) {
+      auto& header = headers_[std::size_t(i)].msg_hdr;
+      sizes_[std::size_t(i)] = headers_[std::size_t(i)].msg_len;
+      if (header.msg_flags & MSG_TRUNC)
+        ++stats_.truncated;
+#ifdef SO_RXQ_OVFL
+      for (auto* cmsg = CMSG_FIRSTHDR(&header); cmsg;
+           cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+          auto drops = std::uint32_t{0};
+          std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+          // The kernel counts the drops since the socket was opened
+          stats_.kernel_drops = std::max(stats_.kernel_drops,
+                                         std::uint64_t{drops});
+        }
+      }
+#endif
+    }
+    num_datagrams_ = std::size_t(std::max(num_received, 0));
+#else
+    while (num_datagrams_ < config_.batch_size) {
+      const auto num_read =
+          ::recv(udp_fd_, iovecs_[num_datagrams_].iov_base,
+                 config_.max_message_size, MSG_DONTWAIT | MSG_TRUNC);
+      if (num_read < 0)
+        break;
+      if (std::size_t(num_read) > config_.max_message_size)
+        ++stats_.truncated;
+      sizes_[num_datagrams_++] =
+          std::min(std::size_t(num_read), config_.max_message_size);
+    }
+#endif
+    for (auto i = std::size_t{0}; i < num_datagrams_; ++i) {
+      sizes_[i] = std::min(sizes_[i], config_.max_message_size);
+      stats_.bytes += sizes_[i];
+    }
+    return num_datagrams_;
+  }
+
+  void wait(std::chrono::milliseconds timeout) {
+    poll_fds_.clear();
+    if (udp_fd_ >= 0)
+      poll_fds_.push_back({udp_fd_, POLLIN, 0});
+    if (tcp_fd_ >= 0)
+      poll_fds_.push_back({tcp_fd_, POLLIN, 0});
+    for (const auto& connection : connections_)
+      if (!connection.closed)
+        poll_fds_.push_back({connection.fd, POLLIN, 0});
+    ::poll(poll_fds_.data(), nfds_t(poll_fds_.size()), int(timeout.count()));
+  }
+
+  void close_all() {
+    if (udp_fd_ >= 0)
+      ::close(udp_fd_);
+    if (tcp_fd_ >= 0)
+      ::close(tcp_fd_);
+    for (const auto& connection : connections_)
+      ::close(connection.fd);
+    udp_fd_ = tcp_fd_ = -1;
+    connections_.clear();
+  }
+
+  receiver_config config_;
+  int udp_fd_{-1};
+  int tcp_fd_{-1};
+  // Datagrams of the last batch, each in a slot of the maximum message size
+  std::vector<char> datagrams_;
+  std::vector<std::size_t> sizes_;
+  std::vector<iovec> iovecs_;
+#ifdef __linux__
+  static constexpr std::size_t control_size = CMSG_SPACE(sizeof(std::uint32_t));
+  std::vector<char> controls_;
+  std::vector<mmsghdr> headers_;
+#endif
+  std::size_t num_datagrams_{0};
+  std::size_t next_datagram_{0};
+  std::vector<tcp_connection> connections_;
+  std::size_t next_connection_{0};
+  std::vector<pollfd> poll_fds_;
+  receiver_stats stats_;
+};
+#else
+// Receiving needs POSIX sockets
+class syslog_receiver {
+public:
+  explicit syslog_receiver(receiver_config) {
+    throw std::runtime_error{"Receiving syslog messages is not supported here"};
+  }
+
+  bool next(std::string_view&, std::chrono::milliseconds) { return false; }
+  std::uint16_t udp_port() const { return 0; }
+  std::uint16_t tcp_port() const { return 0; }
+  std::size_t num_connections() const { return 0; }
+  const receiver_stats& stats() const { return stats_; }
+
+private:
+  receiver_stats stats_;
+};
+#endif
+} // namespace flt::io
+
+#endif
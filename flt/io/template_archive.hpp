@@ -0,0 +1,673 @@
+#ifndef FLT_IO_TEMPLATE_ARCHIVE_HPP
+#define FLT_IO_TEMPLATE_ARCHIVE_HPP
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef FLT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Template archives store log lines as templates and parameters. Lines are
+// split into tokens at whitespace and punctuation, tokens containing a digit
+// are parameters and everything else, separators included, is the template,
+// so lines are reconstructed exactly. An archive is a header followed by
+// independent blocks of lines:
+//
+//   block   := size lines newline templates ids num_columns column*
+//   column  := template slot kind section
+//   section := compression raw_size stored_size bytes
+//
+// All numbers are varints. newline is 0 if the last line of the block ended the
+// log without a newline, else 1. The templates section holds the static pieces
+// of the templates used in the block, the ids section one template id per line
+// and each column the parameters at one slot of one template, in line order.
+// Columns of canonical decimal integers are delta encoded, others are
+// dictionary encoded or stored plainly if most values are distinct. Sections
+// are zlib compressed where available, so single columns can be read without
+// decompressing the rest of their block.
+namespace flt::io {
+enum class column_kind : std::uint8_t { integers, dictionary, plain };
+
+// Static text of a template, its parameters go between the pieces
+struct archive_template {
+  std::vector<std::string> pieces;
+
+  std::size_t num_slots() const { return pieces.size() - 1; }
+};
+
+struct archive_config {
+  // Blocks are compressed and decoded independently
+  std::size_t block_lines{1 << 16};
+  // zlib level of the sections, 0 stores them uncompressed
+  int compression_level{6};
+};
+
+namespace detail {
+inline constexpr std::string_view archive_magic{"FLTARCH1"};
+
+// Marks the parameter slots in template keys. Lines containing it are stored
+// as a template with a single slot holding the whole line.
+inline constexpr char slot_marker = '\x11';
+
+enum class section_compression : std::uint8_t { none, zlib };
+
+inline constexpr auto archive_separators = [] {
+  auto separators = std::array<bool, 256>{};
+  for (auto c : std::string_view{" \t\r\n\v\f=;,'\"()[]{}<>:./\\-@#%|&+*!?~"})
+    separators[static_cast<unsigned char>(c)] = true;
+  return separators;
+}();
+
+[[noreturn]] inline void throw_corrupt_archive() {
+  throw std::runtime_error{"Corrupt archive"};
+}
+
+inline void put_varint(std::string& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(char(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(char(value));
+}
+
+inline std::uint64_t get_varint(std::string_view& in) {
+  auto value = std::uint64_t{0};
+  for (auto shift = 0u; shift < 64 && !in.empty(); shift += 7) {
+    const auto byte = static_cast<unsigned char>(in.front());
+    in.remove_prefix(1);
+    value |= std::uint64_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  throw_corrupt_archive();
+}
+
+inline void put_string(std::string& out, std::string_view value) {
+  put_varint(out, value.size());
+  out += value;
+}
+
+inline std::string_view get_string(std::string_view& in) {
+  const auto size = get_varint(in);
+  if (size > in.size())
+    throw_corrupt_archive();
+  const auto value = in.substr(0, size);
+  in.remove_prefix(size);
+  return value;
+}
+
+inline std::uint64_t zigzag(std::uint64_t value) {
+  return (value << 1) ^ (0 - (value >> 63));
+}
+
+inline std::uint64_t unzigzag(std::uint64_t value) {
+  return (value >> 1) ^ (0 - (value & 1));
+}
+
+// Only integers printing back the same are parsed, e.g. not 007 or -0
+inline bool parse_integer(std::string_view token, std::int64_t& value) {
+  const auto digits = token.substr(!token.empty() && token.front() == '-');
+  if (digits.empty() || (digits.front() == '0' && token.size() > 1))
+    return false;
+  const auto [end, error] =
+      std::from_chars(token.data(), token.data() + token.size(), value);
+  return error == std::errc{} && end == token.data() + token.size();
+}
+
+inline void put_section(std::string& out, std::string_view raw, int level,
+                        std::string& buffer) {
+#ifdef FLT_HAVE_ZLIB
+  if (level != 0 && raw.size() >= 64) {
+    auto stored_size = compressBound(uLong(raw.size()));
+    buffer.resize(stored_size);
+    if (compress2(reinterpret_cast<Bytef*>(buffer.data()), &stored_size,
+                  reinterpret_cast<const Bytef*>(raw.data()), uLong(raw.size()),
+                  level) == Z_OK &&
+        stored_size < raw.size()) {
+      out.push_back(char(section_compression::zlib));
+      put_varint(out, raw.size());
+      put_string(out, std::string_view{buffer.data(), stored_size});
+      return;
+    }
+  }
+#else
+  static_cast<void>(level);
+  static_cast<void>(buffer);
+#endif
+  out.push_back(char(section_compression::none));
+  put_varint(out, raw.size());
+  put_string(out, raw);
+}
+
+struct section_ref {
+  section_compression compression{section_compression::none};
+  std::size_t raw_size{0};
+  std::string_view stored;
+};
+
+inline section_ref get_section(std::string_view& in) {
+  if (in.empty())
+    throw_corrupt_archive();
+  auto section = section_ref{};
+  section.compression = section_compression(in.front());
+  in.remove_prefix(1);
+  section.raw_size = get_varint(in);
+  section.stored = get_string(in);
+  // zlib can't compress by more than about 1:1000
+  if (section.raw_size > section.stored.size() * 1032 + 64)
+    throw_corrupt_archive();
+  return section;
+}
+
+// The returned view refers to the archive data or the buffer
+inline std::string_view read_section(const section_ref& section,
+                                     std::string& buffer) {
+  switch (section.compression) {
+  case section_compression::none:
+    if (section.stored.size() != section.raw_size)
+      throw_corrupt_archive();
+    return section.stored;
+  case section_compression::zlib: {
+#ifdef FLT_HAVE_ZLIB
+    buffer.resize(section.raw_size);
+    auto raw_size = uLongf(section.raw_size);
+    if (uncompress(reinterpret_cast<Bytef*>(buffer.data()), &raw_size,
+                   reinterpret_cast<const Bytef*>(section.stored.data()),
+                   uLong(section.stored.size())) != Z_OK ||
+        raw_size != section.raw_size)
+      throw_corrupt_archive();
+    return buffer;
+#else
+    throw std::runtime_error{"Archive needs zlib support"};
+#endif
+  }
+  default:
+    throw_corrupt_archive();
+  }
+}
+} // namespace detail
+
+// Decoded parameters of one column
+class archive_column {
+public:
+  column_kind kind() const { return kind_; }
+  std::size_t size() const { return ends_.size(); }
+
+  std::string_view operator[](std::size_t i) const {
+    const auto begin = i == 0 ? 0 : ends_[i - 1];
+    return std::string_view{text_}.substr(begin, ends_[i] - begin);
+  }
+
+  // Only filled for integer columns
+  const std::vector<std::int64_t>& integers() const { return integers_; }
+
+private:
+  friend class archive_block;
+
+  void add(std::string_view value) {
+    text_ += value;
+    ends_.push_back(text_.size());
+  }
+
+  column_kind kind_{column_kind::plain};
+  std::string text_;
+  std::vector<std::size_t> ends_;
+  std::vector<std::int64_t> integers_;
+};
+
+// A block read from an archive. Parsing only decodes the templates, the ids
+// and columns are decoded on access.
+class archive_block {
+public:
+  void parse(std::string data) {
+    data_ = std::move(data);
+    templates_.clear();
+    columns_.clear();
+    first_columns_.clear();
+    auto in = std::string_view{data_};
+    num_lines_ = detail::get_varint(in);
+    const auto newline = detail::get_varint(in);
+    if (newline > 1)
+      detail::throw_corrupt_archive();
+    final_newline_ = newline == 1;
+
+    auto buffer = std::string{};
+    auto templates = detail::read_section(detail::get_section(in), buffer);
+    const auto num_templates = detail::get_varint(templates);
+    if (num_templates > templates.size())
+      detail::throw_corrupt_archive();
+    templates_.resize(num_templates);
+    for (auto& templ : templates_) {
+      const auto num_slots = detail::get_varint(templates);
+      if (num_slots >= templates.size())
+        detail::throw_corrupt_archive();
+      for (auto i = std::uint64_t{0}; i <= num_slots; ++i)
+        templ.pieces.emplace_back(detail::get_string(templates));
+    }
+    if (!templates.empty())
+      detail::throw_corrupt_archive();
+
+    // Every id takes at least a byte
+    ids_ = detail::get_section(in);
+    if (num_lines_ > ids_.raw_size)
+      detail::throw_corrupt_archive();
+    // Columns are ordered by template and slot
+    auto num_columns = detail::get_varint(in);
+    for (const auto& templ : templates_) {
+      first_columns_.push_back(columns_.size());
+      for (auto slot = std::size_t{0}; slot < templ.num_slots(); ++slot) {
+        if (num_columns-- == 0 ||
+            detail::get_varint(in) != first_columns_.size() - 1 ||
+            detail::get_varint(in) != slot)
+          detail::throw_corrupt_archive();
+        const auto kind = detail::get_varint(in);
+        if (kind > std::uint64_t(column_kind::plain))
+          detail::throw_corrupt_archive();
+        columns_.push_back({column_kind(kind), detail::get_section(in)});
+      }
+    }
+    if (num_columns != 0 || !in.empty())
+      detail::throw_corrupt_archive();
+  }
+
+  std::size_t num_lines() const { return num_lines_; }
+
+  // Whether the last line of the block is followed by a newline
+  bool final_newline() const { return final_newline_; }
+
+  const std::vector<archive_template>& templates() const { return templates_; }
+
+  std::vector<std::uint32_t> template_ids() const {
+    auto buffer = std::string{};
+    auto in = detail::read_section(ids_, buffer);
+    auto ids = std::vector<std::uint32_t>(num_lines_);
+    for (auto& id : ids) {
+      id = std::uint32_t(detail::get_varint(in));
+      if (id >= templates_.size())
+        detail::throw_corrupt_archive();
+    }
+    if (!in.empty())
+      detail::throw_corrupt_archive();
+    return ids;
+  }
+
+  archive_column column(std::size_t templ, std::size_t slot) const {
+    if (templ >= templates_.size() || slot >= templates_[templ].num_slots())
+      throw std::out_of_range{"No such template slot"};
+    const auto& ref = columns_[first_columns_[templ] + slot];
+    auto buffer = std::string{};
+    auto in = detail::read_section(ref.section, buffer);
+    auto column = archive_column{};
+    column.kind_ = ref.kind;
+    const auto size = detail::get_varint(in);
+    if (size > num_lines_)
+      detail::throw_corrupt_archive();
+    column.ends_.reserve(size);
+    if (ref.kind == column_kind::integers) {
+      auto value = std::uint64_t{0};
+      char text[24];
+      for (auto i = std::uint64_t{0}; i < size; ++i) {
+        value += detail::unzigzag(detail::get_varint(in));
+        column.integers_.push_back(std::int64_t(value));
+        const auto end =
+            std::to_chars(text, text + sizeof(text), std::int64_t(value)).ptr;
+        column.add(std::string_view{text, std::size_t(end - text)});
+      }
+    } else if (ref.kind == column_kind::dictionary) {
+      const auto dictionary_size = detail::get_varint(in);
+      if (dictionary_size > size)
+        detail::throw_corrupt_archive();
+      auto dictionary = std::vector<std::string_view>(dictionary_size);
+      for (auto& value : dictionary)
+        value = detail::get_string(in);
+      for (auto i = std::uint64_t{0}; i < size; ++i) {
+        const auto index = detail::get_varint(in);
+        if (index >= dictionary.size())
+          detail::throw_corrupt_archive();
+        column.add(dictionary[index]);
+      }
+    } else {
+      for (auto i = std::uint64_t{0}; i < size; ++i)
+        column.add(detail::get_string(in));
+    }
+    if (!in.empty())
+      detail::throw_corrupt_archive();
+    return column;
+  }
+
+  void decode_lines(std::vector<std::string>& lines) const {
+    const auto ids = template_ids();
+    auto columns = std::vector<archive_column>{};
+    columns.reserve(columns_.size());
+    for (auto templ = std::size_t{0}; templ < templates_.size(); ++templ)
+      for (auto slot = std::size_t{0}; slot < templates_[templ].num_slots();
+           ++slot)
+        columns.push_back(column(templ, slot));
+    auto positions = std::vector<std::size_t>(templates_.size(), 0);
+    lines.resize(ids.size());
+    for (auto i = std::size_t{0}; i < ids.size(); ++i) {
+      const auto& pieces = templates_[ids[i]].pieces;
+      const auto first_column = first_columns_[ids[i]];
+      const auto pos = positions[ids[i]]++;
+      auto& line = lines[i];
+      line = pieces[0];
+      for (auto slot = std::size_t{0}; slot + 1 < pieces.size(); ++slot) {
+        const auto& values = columns[first_column + slot];
+        if (pos >= values.size())
+          detail::throw_corrupt_archive();
+        line += values[pos];
+        line += pieces[slot + 1];
+      }
+    }
+  }
+
+private:
+  struct column_ref {
+    column_kind kind;
+    detail::section_ref section;
+  };
+
+  std::string data_;
+  std::size_t num_lines_{0};
+  bool final_newline_{true};
+  std::vector<archive_template> templates_;
+  detail::section_ref ids_;
+  std::vector<column_ref> columns_;
+  std::vector<std::size_t> first_columns_;
+};
+
+class archive_reader {
+public:
+  explicit archive_reader(std::istream& in) : in_(in) {
+    auto magic = std::string(detail::archive_magic.size(), '\0');
+    if (!in_.read(magic.data(), std::streamsize(magic.size())) ||
+        magic != detail::archive_magic)
+      throw std::runtime_error{"Not a template archive"};
+    bytes_read_ = magic.size();
+  }
+
+  // Reads the next block without parsing it, e.g. to parse blocks in
+  // parallel. Returns false at the end of the archive.
+  bool read_block(std::string& data) {
+    auto size = std::uint64_t{0};
+    for (auto shift = 0u;; shift += 7) {
+      const auto byte = in_.get();
+      if (byte == std::istream::traits_type::eof()) {
+        if (shift == 0)
+          return false;
+        detail::throw_corrupt_archive();
+      }
+      ++bytes_read_;
+      size |= std::uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+      if (shift >= 56)
+        detail::throw_corrupt_archive();
+    }
+    // Read in pieces, so a corrupt size fails at the end of the input
+    data.clear();
+    while (data.size() < size) {
+      const auto begin = data.size();
+      data.resize(begin + std::min<std::uint64_t>(size - begin, 1 << 20));
+      if (!in_.read(data.data() + begin, std::streamsize(data.size() - begin)))
+        detail::throw_corrupt_archive();
+    }
+    bytes_read_ += size;
+    return true;
+  }
+
+  bool next_block(archive_block& block) {
+    auto data = std::string{};
+    if (!read_block(data))
+      return false;
+    block.parse(std::move(data));
+    return true;
+  }
+
+  std::uint64_t bytes_read() const { return bytes_read_; }
+
+private:
+  std::istream& in_;
+  std::uint64_t bytes_read_{0};
+};
+
+// Lines are buffered until a block is full. close() writes the last block,
+// the destructor does too but can't report errors. A log without a newline
+// after its last line is closed with final_newline false.
+class archive_writer {
+public:
+  explicit archive_writer(std::ostream& out, archive_config config = {})
+      : out_(out), config_(config) {
+    if (config_.block_lines == 0)
+      throw std::invalid_argument{"Blocks need at least one line"};
+    out_.write(detail::archive_magic.data(),
+               std::streamsize(detail::archive_magic.size()));
+    bytes_written_ = detail::archive_magic.size();
+  }
+
+  archive_writer(const archive_writer&) = delete;
+  archive_writer& operator=(const archive_writer&) = delete;
+
+  ~archive_writer() {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  void add(std::string_view line) {
+    // Full blocks are written once the next line arrives, so the last block
+    // is still pending in close()
+    if (ids_.size() == config_.block_lines)
+      write_block(true);
+    split(line);
+    auto templ = templ_ids_.find(key_);
+    if (templ == templ_ids_.end()) {
+      templ = templ_ids_.emplace(key_, std::uint32_t(templs_.size())).first;
+      templs_.push_back({key_, columns_.size()});
+      columns_.resize(columns_.size() + params_.size());
+    }
+    ids_.push_back(templ->second);
+    auto* column = &columns_[templs_[templ->second].first_column];
+    for (const auto& param : params_)
+      (column++)->add(param);
+    ++num_lines_;
+  }
+
+  void close(bool final_newline = true) {
+    if (!ids_.empty())
+      write_block(final_newline);
+    out_.flush();
+    if (!out_)
+      throw std::runtime_error{"Couldn't write archive"};
+  }
+
+  std::uint64_t num_lines() const { return num_lines_; }
+  std::uint64_t num_blocks() const { return num_blocks_; }
+  std::uint64_t bytes_written() const { return bytes_written_; }
+
+private:
+  struct templ_entry {
+    std::string key;
+    std::size_t first_column;
+  };
+
+  struct column_builder {
+    std::string text;
+    std::vector<std::size_t> ends;
+
+    void add(std::string_view value) {
+      text += value;
+      ends.push_back(text.size());
+    }
+
+    std::string_view operator[](std::size_t i) const {
+      const auto begin = i == 0 ? 0 : ends[i - 1];
+      return std::string_view{text}.substr(begin, ends[i] - begin);
+    }
+  };
+
+  void split(std::string_view line) {
+    key_.clear();
+    params_.clear();
+    if (line.find(detail::slot_marker) != std::string_view::npos) {
+      key_.push_back(detail::slot_marker);
+      params_.push_back(line);
+      return;
+    }
+    const auto is_separator = [](char c) {
+      return detail::archive_separators[static_cast<unsigned char>(c)];
+    };
+    for (auto pos = std::size_t{0}; pos < line.size();) {
+      if (is_separator(line[pos])) {
+        key_.push_back(line[pos++]);
+        continue;
+      }
+      auto end = pos;
+      auto has_digit = false;
+      for (; end < line.size() && !is_separator(line[end]); ++end)
+        has_digit |= line[end] >= '0' && line[end] <= '9';
+      const auto token = line.substr(pos, end - pos);
+      if (has_digit) {
+        key_.push_back(detail::slot_marker);
+        params_.push_back(token);
+      } else {
+        key_ += token;
+      }
+      pos = end;
+    }
+  }
+
+  column_kind encode_column(const column_builder& column) {
+    const auto size = column.ends.size();
+    detail::put_varint(raw_, size);
+
+    integers_.clear();
+    auto value = std::int64_t{0};
+    for (auto i = std::size_t{0};
+         i < size && detail::parse_integer(column[i], value); ++i)
+      integers_.push_back(value);
+    if (integers_.size() == size) {
+      auto previous = std::uint64_t{0};
+      for (auto integer : integers_) {
+        detail::put_varint(raw_,
+                           detail::zigzag(std::uint64_t(integer) - previous));
+        previous = std::uint64_t(integer);
+      }
+      return column_kind::integers;
+    }
+
+    dictionary_.clear();
+    indexes_.clear();
+    for (auto i = std::size_t{0}; i < size; ++i)
+      indexes_.push_back(
+          dictionary_.emplace(column[i], std::uint32_t(dictionary_.size()))
+              .first->second);
+    if (dictionary_.size() * 2 > size) {
+      for (auto i = std::size_t{0}; i < size; ++i)
+        detail::put_string(raw_, column[i]);
+      return column_kind::plain;
+    }
+    auto values = std::vector<std::string_view>(dictionary_.size());
+    for (const auto& entry : dictionary_)
+      values[entry.second] = entry.first;
+    detail::put_varint(raw_, values.size());
+    for (auto value : values)
+      detail::put_string(raw_, value);
+    for (auto index : indexes_)
+      detail::put_varint(raw_, index);
+    return column_kind::dictionary;
+  }
+
+  void write_block(bool final_newline) {
+    const auto level = config_.compression_level;
+    block_.clear();
+    detail::put_varint(block_, ids_.size());
+    detail::put_varint(block_, final_newline);
+
+    raw_.clear();
+    detail::put_varint(raw_, templs_.size());
+    for (const auto& templ : templs_) {
+      const auto key = std::string_view{templ.key};
+      detail::put_varint(raw_, std::count(key.begin(), key.end(),
+                                          detail::slot_marker));
+      for (auto begin = std::size_t{0};;) {
+        const auto end = key.find(detail::slot_marker, begin);
+        detail::put_string(raw_, key.substr(begin, end - begin));
+        if (end == std::string_view::npos)
+          break;
+        begin = end + 1;
+      }
+    }
+    detail::put_section(block_, raw_, level, buffer_);
+
+    raw_.clear();
+    for (auto id : ids_)
+      detail::put_varint(raw_, id);
+    detail::put_section(block_, raw_, level, buffer_);
+
+    detail::put_varint(block_, columns_.size());
+    for (auto templ = std::size_t{0}; templ < templs_.size(); ++templ) {
+      const auto first_column = templs_[templ].first_column;
+      const auto last_column = templ + 1 < templs_.size()
+                                   ? templs_[templ + 1].first_column
+                                   : columns_.size();
+      for (auto column = first_column; column < last_column; ++column) {
+        raw_.clear();
+        const auto kind = encode_column(columns_[column]);
+        detail::put_varint(block_, templ);
+        detail::put_varint(block_, column - first_column);
+        detail::put_varint(block_, std::uint64_t(kind));
+        detail::put_section(block_, raw_, level, buffer_);
+      }
+    }
+
+    raw_.clear();
+    detail::put_varint(raw_, block_.size());
+    out_.write(raw_.data(), std::streamsize(raw_.size()));
+    out_.write(block_.data(), std::streamsize(block_.size()));
+    bytes_written_ += raw_.size() + block_.size();
+    ++num_blocks_;
+
+    templ_ids_.clear();
+    templs_.clear();
+    columns_.clear();
+    ids_.clear();
+  }
+
+  std::ostream& out_;
+  archive_config config_;
+  std::uint64_t num_lines_{0};
+  std::uint64_t num_blocks_{0};
+  std::uint64_t bytes_written_{0};
+  // Lines of the current block
+  std::unordered_map<std::string, std::uint32_t> templ_ids_;
+  std::vector<templ_entry> templs_;
+  std::vector<column_builder> columns_;
+  std::vector<std::uint32_t> ids_;
+  // Reused between lines and blocks
+  std::string key_;
+  std::vector<std::string_view> params_;
+  std::string block_;
+  std::string raw_;
+  std::string buffer_;
+  std::vector<std::int64_t> integers_;
+  std::unordered_map<std::string_view, std::uint32_t> dictionary_;
+  std::vector<std::uint32_t> indexes_;
+};
+} // namespace flt::io
+
+#endif
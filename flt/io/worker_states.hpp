@@ -0,0 +1,183 @@
+#ifndef FLT_IO_WORKER_STATES_HPP
+#define FLT_IO_WORKER_STATES_HPP
+
+#include <flt/io/socket.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifdef FLT_IO_HAVE_SOCKETS
+#if __has_include(<poll.h>)
+#define FLT_IO_HAVE_WORKER_STATES
+#include <poll.h>
+#endif
+#endif
+
+// Workers templating parts of a log send their templater states to a
+// coordinator, one connection per state. A state is sent as
+//
+//   magic part num_parts num_lines size state
+//
+// with the numbers as 8 byte little endian integers.
+namespace flt::io {
+struct worker_state {
+  std::size_t part{0};
+  std::size_t num_parts{1};
+  // Loglines the worker has read
+  std::uint64_t num_lines{0};
+  std::string state;
+};
+
+#ifdef FLT_IO_HAVE_WORKER_STATES
+namespace detail {
+inline constexpr std::string_view worker_state_magic{"FLTWORK1"};
+
+inline void put_uint64(std::string& out, std::uint64_t value) {
+  for (auto i = 0; i < 8; ++i, value >>= 8)
+    out.push_back(char(value & 0xff));
+}
+
+inline std::uint64_t get_uint64(std::string_view& in) {
+  if (in.size() < 8)
+    throw std::runtime_error{"Truncated worker state"};
+  auto value = std::uint64_t{0};
+  for (auto i = 8; i-- > 0;)
+    value = value << 8 | static_cast<unsigned char>(in[std::size_t(i)]);
+  in.remove_prefix(8);
+  return value;
+}
+
+inline worker_state parse_worker_state(std::string_view data) {
+  if (data.substr(0, worker_state_magic.size()) != worker_state_magic)
+    throw std::runtime_error{"Not a worker state"};
+  data.remove_prefix(worker_state_magic.size());
+  auto state = worker_state{};
+  state.part = std::size_t(get_uint64(data));
+  state.num_parts = std::size_t(get_uint64(data));
+  state.num_lines = get_uint64(data);
+  if (get_uint64(data) != data.size())
+    throw std::runtime_error{"Truncated worker state"};
+  state.state = data;
+  return state;
+}
+} // namespace detail
+
+inline void send_worker_state(const std::string& address,
+                              const worker_state& state) {
+  auto header = std::string{detail::worker_state_magic};
+  detail::put_uint64(header, state.part);
+  detail::put_uint64(header, state.num_parts);
+  detail::put_uint64(header, state.num_lines);
+  detail::put_uint64(header, state.state.size());
+  const auto fd = detail::open_socket(address, SOCK_STREAM, false);
+  try {
+    detail::write_all(fd, header);
+    detail::write_all(fd, state.state);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+}
+
+// Listens for the states of the workers. Unix socket files are created on
+// construction and removed on destruction.
+class state_collector {
+public:
+  explicit state_collector(std::string address) : address_(std::move(address)) {
+    fd_ = detail::open_socket(address_, SOCK_STREAM, true);
+    if (::listen(fd_, SOMAXCONN) != 0) {
+      const auto error = errno;
+      close();
+      throw std::system_error{error, std::generic_category(),
+                              "Couldn't listen on " + address_};
+    }
+    if (!detail::is_unix_address(address_)) {
+      const auto [host, port] = detail::split_address(address_);
+      const auto bracketed = host.find(':') != std::string::npos;
+      address_ = (bracketed ? "[" + host + "]" : host) + ':' +
+                 std::to_string(detail::local_port(fd_));
+    }
+  }
+
+  state_collector(const state_collector&) = delete;
+  state_collector& operator=(const state_collector&) = delete;
+
+  ~state_collector() { close(); }
+
+  // The address workers connect to, with the actual port if listening on
+  // port 0
+  const std::string& address() const { return address_; }
+
+  // Receives the states of all num_parts parts and returns them ordered by
+  // part. stop is called about every 250 ms while waiting, receiving is
+  // given up with an exception once it returns true.
+  template <typename Stop>
+  std::vector<worker_state> collect(std::size_t num_parts, Stop stop) {
+    auto states = std::vector<worker_state>{};
+    auto received = std::vector<bool>(num_parts, false);
+    while (states.size() < num_parts) {
+      auto poll_fd = pollfd{fd_, POLLIN, 0};
+      const auto num_ready = ::poll(&poll_fd, 1, 250);
+      if (num_ready < 0 && errno != EINTR)
+        throw std::system_error{errno, std::generic_category(),
+                                "Couldn't wait for workers"};
+      if (num_ready <= 0) {
+        if (stop())
+          throw std::runtime_error{"Stopped waiting for worker states"};
+        continue;
+      }
+      const auto connection = ::accept(fd_, nullptr, nullptr);
+      if (connection < 0) {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        throw std::system_error{errno, std::generic_category(),
+                                "Couldn't accept worker connection"};
+      }
+      auto data = std::string{};
+      try {
+        data = detail::read_all(connection);
+      } catch (...) {
+        ::close(connection);
+        throw;
+      }
+      ::close(connection);
+      auto state = detail::parse_worker_state(data);
+      if (state.num_parts != num_parts || state.part >= num_parts ||
+          received[state.part])
+        throw std::runtime_error{"Unexpected state of part " +
+                                 std::to_string(state.part) + " of " +
+                                 std::to_string(state.num_parts)};
+      received[state.part] = true;
+      states.push_back(std::move(state));
+    }
+    std::sort(states.begin(), states.end(),
+              [](const auto& a, const auto& b) { return a.part < b.part; });
+    return states;
+  }
+
+private:
+  void close() {
+    if (fd_ < 0)
+      return;
+    ::close(fd_);
+    fd_ = -1;
+    if (detail::is_unix_address(address_))
+      ::unlink(address_.c_str() + detail::unix_prefix.size());
+  }
+
+  std::string address_;
+  int fd_{-1};
+};
+#endif
+} // namespace flt::io
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef FLT_LOGLINES_EVENT_ASSEMBLER_HPP
+#define FLT_LOGLINES_EVENT_ASSEMBLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace flt::logline {
+// Which lines start a new event, all other lines continue the current one
+enum class event_start {
+  // Lines beginning with a date or time, optionally in square brackets
+  timestamp,
+  // Lines not beginning with a space or tab, apart from the "Caused by:" and
+  // "... N more" lines of Java stack traces
+  unindented,
+  // Lines beginning with a syslog priority like <13> or a traditional
+  // syslog timestamp
+  syslog_header
+};
+
+inline event_start parse_event_start(const std::string& name) {
+  if (name == "timestamp")
+    return event_start::timestamp;
+  if (name == "indent")
+    return event_start::unindented;
+  if (name == "syslog")
+    return event_start::syslog_header;
+  throw std::invalid_argument{"event start " + name};
+}
+
+namespace detail {
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool digits(std::string_view line, std::size_t pos, std::size_t num) {
+  if (line.size() < pos + num)
+    return false;
+  for (auto i = pos; i < pos + num; ++i)
+    if (!is_digit(line[i]))
+      return false;
+  return true;
+}
+
+// HH:MM:SS
+inline bool time_at(std::string_view line, std::size_t pos) {
+  return digits(line, pos, 2) && digits(line, pos + 3, 2) &&
+         digits(line, pos + 6, 2) && line[pos + 2] == ':' &&
+         line[pos + 5] == ':';
+}
+
+// YYYY-MM-DD, also with / or . between the numbers
+inline bool date_at(std::string_view line, std::size_t pos) {
+  const auto is_sep = [](char c) { return c == '-' || c == '/' || c == '.'; };
+  return digits(line, pos, 4) && digits(line, pos + 5, 2) &&
+         digits(line, pos + 8, 2) && is_sep(line[pos + 4]) &&
+         line[pos + 7] == line[pos + 4];
+}
+
+// Mmm dd HH:MM:SS with the day padded by a space or zero
+inline bool traditional_timestamp_at(std::string_view line, std::size_t pos) {
+  const auto is_lower = [](char c) { return c >= 'a' && c <= 'z'; };
+  return line.size() >= pos + 15 && line[pos] >= 'A' && line[pos] <= 'Z' &&
+         is_lower(line[pos + 1]) && is_lower(line[pos + 2]) &&
+         line[pos + 3] == ' ' &&
+         (line[pos + 4] == ' ' || is_digit(line[pos + 4])) &&
+         is_digit(line[pos + 5]) && line[pos + 6] == ' ' &&
+         time_at(line, pos + 7);
+}
+
+inline bool starts_with(std::string_view line, std::string_view prefix) {
+  return line.substr(0, prefix.size()) == prefix;
+}
+} // namespace detail
+
+// Only the first bytes of a line are looked at
+inline bool starts_event(std::string_view line, event_start start) {
+  using namespace detail;
+  switch (start) {
+  case event_start::timestamp: {
+    const auto pos = std::size_t(!line.empty() && line.front() == '[');
+    return date_at(line, pos) || time_at(line, pos) ||
+           traditional_timestamp_at(line, pos);
+  }
+  case event_start::unindented:
+    return !line.empty() && line.front() != ' ' && line.front() != '\t' &&
+           !starts_with(line, "Caused by: ") && !starts_with(line, "... ");
+  case event_start::syslog_header: {
+    if (!line.empty() && line.front() == '<') {
+      auto pos = std::size_t{1};
+      while (pos < line.size() && pos < 5 && is_digit(line[pos]))
+        ++pos;
+      return pos > 1 && pos < line.size() && line[pos] == '>';
+    }
+    return traditional_timestamp_at(line, 0);
+  }
+  }
+  return true;
+}
+
+// Joins continuation lines, like the lines of stack traces and wrapped
+// messages, to the line starting their event. Continuation lines are appended
+// with their leading whitespace replaced by a single space, so events are
+// single lines again. An event is complete once the next event starts, the
+// pending event is bounded by max_lines and max_bytes, beyond which lines
+// start a new event.
+class event_assembler {
+public:
+  explicit event_assembler(event_start start, std::size_t max_lines = 512,
+                           std::size_t max_bytes = 65536)
+      : start_(start), max_lines_(max_lines), max_bytes_(max_bytes) {}
+
+  // Returns whether the line completed the pending event, which is then
+  // available from event() until the next call
+  bool push(std::string_view line) {
+    if (num_pending_ != 0 && !starts_event(line, start_)) {
+      const auto first = line.find_first_not_of(" \t");
+      line.remove_prefix(first == std::string_view::npos ? line.size()
+                                                          : first);
+      if (num_pending_ < max_lines_ &&
+          pending_.size() + line.size() + 1 <= max_bytes_) {
+        if (!line.empty()) {
+          pending_ += ' ';
+          pending_ += line;
+        }
+        ++num_pending_;
+        ++num_joined_;
+        return false;
+      }
+      ++num_cut_;
+    }
+    const auto completed = num_pending_ != 0;
+    if (completed) {
+      pending_.swap(event_);
+      ++num_events_;
+    }
+    pending_.assign(line);
+    num_pending_ = 1;
+    return completed;
+  }
+
+  // Completes the pending event at the end of the input. Returns whether
+  // there was one.
+  bool flush() {
+    if (num_pending_ == 0)
+      return false;
+    pending_.swap(event_);
+    pending_.clear();
+    num_pending_ = 0;
+    ++num_events_;
+    return true;
+  }
+
+  // Whether lines are waiting for the next event to start
+  bool pending() const { return num_pending_ != 0; }
+
+  std::string_view event() const { return event_; }
+
+  std::uint64_t num_events() const { return num_events_; }
+  // Continuation lines joined to their event
+  std::uint64_t num_joined() const { return num_joined_; }
+  // Continuation lines starting a new event as the pending one was full
+  std::uint64_t num_cut() const { return num_cut_; }
+
+private:
+  event_start start_;
+  std::size_t max_lines_;
+  std::size_t max_bytes_;
+  std::string pending_;
+  std::size_t num_pending_{0};
+  std::string event_;
+  std::uint64_t num_events_{0};
+  std::uint64_t num_joined_{0};
+  std::uint64_t num_cut_{0};
+};
+} // namespace flt::logline
+
+#endif
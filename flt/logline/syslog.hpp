@@ -164,6 +164,7 @@ public:
             {"ORIGIN"sv, syslog_token_types::Origin},
             {"FACILITY"sv, syslog_token_types::Facility},
             {"FACILITY_NUM"sv, syslog_token_types::FacilityNum},
+            {"PRIORITY"sv, syslog_token_types::Priority},
             {"ISODATE"sv, syslog_token_types::ISODate},
             {"DATE"sv, syslog_token_types::TradDate},
             {"SEVERITY"sv, syslog_token_types::Severity},
@@ -304,6 +305,17 @@ protected:
             sp.logline_.set_severity(logline::Severity{severnum});
           break;
         }
+        case logline_parser::syslog_token_types::Priority: {
+          // Facility and severity encoded as in the <PRI> part of syslog
+          // messages received over the network
+          auto prinum = std::underlying_type_t<logline::Facility>{};
+          is >> prinum;
+          if (is) {
+            sp.logline_.set_facility(logline::Facility{prinum / 8});
+            sp.logline_.set_severity(logline::Severity{prinum % 8});
+          }
+          break;
+        }
         case logline_parser::syslog_token_types::Message: {
           auto strbuf = std::string{};
           std::getline(is >> std::ws, strbuf);
@@ -352,6 +364,7 @@ protected:
     TradDate,
     Severity,
     SeverityNum,
+    Priority,
     Message,
     Ignore
   };
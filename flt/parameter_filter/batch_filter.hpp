@@ -0,0 +1,105 @@
+#ifndef FLT_PARAMETER_FILTER_BATCH_FILTER_HPP
+#define FLT_PARAMETER_FILTER_BATCH_FILTER_HPP
+
+#include <flt/util/thread_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+// Lines stored back to back in one buffer, line i is
+// [offsets[i], offsets[i + 1]) of chars
+struct line_buffer {
+  std::string chars;
+  std::vector<std::size_t> offsets{0};
+
+  std::size_t size() const { return offsets.size() - 1; }
+
+  bool empty() const { return size() == 0; }
+
+  std::string_view operator[](std::size_t i) const {
+    return std::string_view{chars}.substr(offsets[i],
+                                          offsets[i + 1] - offsets[i]);
+  }
+
+  void push_back(std::string_view line) {
+    chars.append(line);
+    offsets.push_back(chars.size());
+  }
+
+  // Keeps the capacity
+  void clear() {
+    chars.clear();
+    offsets.resize(1);
+  }
+};
+
+// Filters batches of lines on a thread pool. The lines are split into chunks
+// of consecutive lines, which each thread filters into a buffer of the chunk
+// kept from batch to batch, and are then copied to the output in parallel.
+// The filters keep their match state per thread.
+template <typename Filters> class batch_filter {
+public:
+  batch_filter(Filters filters,
+               unsigned int num_threads =
+                   std::max(std::thread::hardware_concurrency(), 1u),
+               std::size_t chunk_lines = 256)
+      : filters_(std::move(filters)), pool_(num_threads),
+        chunk_lines_(std::max<std::size_t>(chunk_lines, 1)) {}
+
+  // Writes the filtered lines of in to out, which can't be in, in the same
+  // order. Not to be called concurrently.
+  void operator()(const line_buffer& in, line_buffer& out) {
+    const auto num_chunks = (in.size() + chunk_lines_ - 1) / chunk_lines_;
+    if (chunks_.size() < num_chunks)
+      chunks_.resize(num_chunks);
+    pool_.run(num_chunks, [&](std::size_t chunk_i) {
+      thread_local auto line = std::string{};
+      auto& chunk = chunks_[chunk_i];
+      chunk.clear();
+      const auto first = chunk_i * chunk_lines_;
+      const auto last = std::min(first + chunk_lines_, in.size());
+      for (auto i = first; i < last; ++i) {
+        line.assign(in[i]);
+        filters_.filter_into(line, line);
+        chunk.push_back(line);
+      }
+    });
+
+    chunk_begins_.resize(num_chunks + 1);
+    chunk_begins_[0] = 0;
+    for (auto i = std::size_t{0}; i < num_chunks; ++i)
+      chunk_begins_[i + 1] = chunk_begins_[i] + chunks_[i].chars.size();
+    out.chars.resize(chunk_begins_[num_chunks]);
+    out.offsets.resize(in.size() + 1);
+    out.offsets[0] = 0;
+    pool_.run(num_chunks, [&](std::size_t chunk_i) {
+      const auto& chunk = chunks_[chunk_i];
+      const auto begin = chunk_begins_[chunk_i];
+      std::copy(chunk.chars.begin(), chunk.chars.end(),
+                out.chars.begin() + std::ptrdiff_t(begin));
+      const auto first = chunk_i * chunk_lines_;
+      for (auto i = std::size_t{0}; i < chunk.size(); ++i)
+        out.offsets[first + i + 1] = begin + chunk.offsets[i + 1];
+    });
+  }
+
+  const Filters& filters() const { return filters_; }
+
+  unsigned int num_threads() const { return pool_.size(); }
+
+private:
+  const Filters filters_;
+  util::thread_pool pool_;
+  const std::size_t chunk_lines_;
+  std::vector<line_buffer> chunks_;
+  std::vector<std::size_t> chunk_begins_;
+};
+} // namespace flt::parameter_filter
+
+#endif
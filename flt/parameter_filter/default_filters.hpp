@@ -0,0 +1,84 @@
+#ifndef FLT_PARAMETER_FILTER_DEFAULT_FILTERS_HPP
+#define FLT_PARAMETER_FILTER_DEFAULT_FILTERS_HPP
+
+#include <flt/parameter_filter/common_regex_filters.hpp>
+#include <flt/parameter_filter/filter_array.hpp>
+#include <flt/parameter_filter/ipv6_address_filter.hpp>
+#include <flt/parameter_filter/scanner_filters.hpp>
+#include <flt/parameter_filter/static_filter_pipeline.hpp>
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+namespace detail {
+// The default filters in the order they are applied
+inline auto default_filter_set() {
+  using namespace regex_filters;
+  return std::tuple{extended_date_filter(),
+                    long_date_filter(),
+                    scanner_filters::date_filter(),
+                    scanner_filters::time_filter(),
+                    scanner_filters::UUID_filter(),
+                    libvirtd_filter(),
+                    ipv6_address_filter<>(),
+                    linux_kernel_audit_filter(),
+                    scanner_filters::linux_mem_size_filter(),
+                    scanner_filters::data_size_filter(),
+                    scanner_filters::time_duration_filter(),
+                    linux_netif_filter(),
+                    scanner_filters::mac_address_filter(),
+                    scanner_filters::ipv4_address_filter(),
+                    scanner_filters::hexadec_constant_filter(),
+                    scanner_filters::square_bracket_filter(),
+                    scanner_filters::pointed_bracket_filter(),
+                    scanner_filters::number_constant_filter()};
+}
+
+// filter_array applies the filter added last first
+template <typename OutIt, typename Filters, std::size_t... I>
+filter_array<OutIt, std::string>
+reversed_filter_array(Filters filters, std::index_sequence<I...>) {
+  return filter_array<OutIt, std::string>{
+      std::get<sizeof...(I) - 1 - I>(std::move(filters))...};
+}
+} // namespace detail
+
+// The filters the templater tools apply to loglines before templating them.
+// Lines classified against saved templates have to be filtered the same way.
+// Filters with a scanner use it instead of their regex, the output is the
+// same.
+template <typename OutIt = std::vector<std::string>::iterator>
+filter_array<OutIt, std::string> default_filters() {
+  auto filters = detail::default_filter_set();
+  return detail::reversed_filter_array<OutIt>(
+      std::move(filters),
+      std::make_index_sequence<std::tuple_size_v<decltype(filters)>>{});
+}
+
+// The default filters in a static_filter_pipeline, which filters the same
+// without virtual calls. The extraction iterator type is chosen per call.
+inline auto static_default_filters() {
+  return std::apply(
+      [](auto&&... filters) {
+        return static_filter_pipeline{std::move(filters)...};
+      },
+      detail::default_filter_set());
+}
+
+// Names of the default filters in the order they are applied, which is the
+// order of their hit counts
+inline std::vector<std::string> default_filter_names() {
+  return {"extended_date",  "long_date",       "date",
+          "time",           "UUID",            "libvirtd",
+          "ipv6_address",   "kernel_audit",    "linux_mem_size",
+          "data_size",      "time_duration",   "linux_netif",
+          "mac_address",    "ipv4_address",    "hexadec_constant",
+          "square_bracket", "pointed_bracket", "number_constant"};
+}
+} // namespace flt::parameter_filter
+
+#endif
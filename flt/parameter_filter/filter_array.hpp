@@ -1,18 +1,57 @@
 #ifndef FLT_PARAMETER_FILTER_FILTER_ARRAY_HPP
 #define FLT_PARAMETER_FILTER_FILTER_ARRAY_HPP
 
+#include <flt/parameter_filter/param_spans.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <forward_list>
+#include <iterator>
 #include <optional>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace flt::parameter_filter {
+namespace detail {
+template <typename FilterT, typename = void>
+struct has_screen : std::false_type {};
+template <typename FilterT>
+struct has_screen<
+    FilterT, std::void_t<decltype(std::declval<const FilterT&>().screen())>>
+    : std::true_type {};
+
+template <typename FilterT, typename T, typename OutIt, typename = void>
+struct has_filter_into : std::false_type {};
+template <typename FilterT, typename T, typename OutIt>
+struct has_filter_into<
+    FilterT, T, OutIt,
+    std::void_t<decltype(std::declval<const FilterT&>().filter_into(
+        std::declval<const T&>(), std::declval<T&>(), std::declval<OutIt>()))>>
+    : std::true_type {};
+} // namespace detail
+
+// Filters providing screen clauses are skipped for lines they can't match.
+// The clauses of all filters are checked in one pass over the line, which is
+// repeated after a filter changed it. Filters providing filter_into write to
+// two buffers in turn, which keep their capacity from line to line, instead
+// of returning a new string each.
 template <typename OutIt, typename T> class filter_array {
 protected:
   struct filter_base {
     virtual ~filter_base() = default;
     virtual T operator()(const T& line_str, OutIt outit) const = 0;
     virtual T operator()(const T& line_str) const = 0;
+    virtual std::vector<screen_clause> screen() const = 0;
+    // Returns whether the filter wrote the filtered line to res_str
+    virtual bool filter_into(const T& line_str, T& res_str,
+                             const OutIt* outit) const = 0;
+    virtual bool filter_edits(const T& line_str, T& res_str,
+                              std::vector<filter_edit>& edits) const = 0;
+    virtual value_format values() const = 0;
   };
   template <typename FilterT>
   struct filter_abstracter final : public filter_base {
@@ -24,6 +63,34 @@ protected:
     }
 
     T operator()(const T& line_str) const override { return filter_(line_str); }
+
+    std::vector<screen_clause> screen() const override {
+      if constexpr (detail::has_screen<FilterT>::value)
+        return filter_.screen();
+      else
+        return {};
+    }
+
+    bool filter_into(const T& line_str, T& res_str,
+                     const OutIt* outit) const override {
+      if constexpr (detail::has_filter_into<FilterT, T, OutIt>::value) {
+        return outit ? filter_.filter_into(line_str, res_str, *outit)
+                     : filter_.filter_into(line_str, res_str, nullptr);
+      } else {
+        auto filtered = outit ? filter_(line_str, *outit) : filter_(line_str);
+        if (filtered == line_str)
+          return false;
+        res_str = std::move(filtered);
+        return true;
+      }
+    }
+
+    bool filter_edits(const T& line_str, T& res_str,
+                      std::vector<filter_edit>& edits) const override {
+      return detail::filter_edits(filter_, line_str, res_str, edits);
+    }
+
+    value_format values() const override { return detail::values_of(filter_); }
   };
 
   using ptr_type = std::unique_ptr<filter_base>;
@@ -35,25 +102,95 @@ public:
   }
 
   auto operator()(const T& line_str, OutIt outit) const {
-    auto res_str = line_str;
-    for (auto&& filt : filt_array_) {
-      res_str = (*filt)(res_str, outit);
-    }
+    auto res_str = T{};
+    filter_into(line_str, res_str, outit);
     return res_str;
   }
 
   auto operator()(const T& line_str) const {
-    auto res_str = line_str;
-    for (auto&& filt : filt_array_) {
-      res_str = (*filt)(res_str);
-    }
+    auto res_str = T{};
+    filter_into(line_str, res_str);
     return res_str;
   }
 
+  // Writes the filtered line to res_str, which may be line_str itself.
+  // Returns whether a filter matched.
+  bool filter_into(const T& line_str, T& res_str, OutIt outit) const {
+    return apply(line_str, res_str,
+                 [&](const filter_base& filt, const T& in, T& out,
+                     std::size_t) {
+                   return filt.filter_into(in, out, &outit);
+                 });
+  }
+
+  bool filter_into(const T& line_str, T& res_str) const {
+    return apply(line_str, res_str,
+                 [](const filter_base& filt, const T& in, T& out, std::size_t) {
+                   return filt.filter_into(in, out, nullptr);
+                 });
+  }
+
+  // Like filter_into, appends the parameters to spans as ranges of line_str
+  // with the values of numbers, in the order filter_into extracts them
+  bool filter_spans(const T& line_str, T& res_str, param_spans& spans) const {
+    thread_local auto recorder = detail::span_recorder{};
+    recorder.start(line_str.size());
+    return apply(line_str, res_str,
+                 [&](const filter_base& filt, const T& in, T& out,
+                     std::size_t filt_i) {
+                   if (!filt.filter_edits(in, out, recorder.edits()))
+                     return false;
+                   recorder.record(filt_i, in, out.size(), filt.values(),
+                                   spans);
+                   return true;
+                 });
+  }
+
+  // Like operator(), also counts the lines each filter changed and, if
+  // given, the lines each filter was skipped for by the screen. The counts
+  // are in the order the filters are applied, the last added filter first.
+  auto filter_and_count(const T& line_str, std::vector<std::uint64_t>& hits,
+                        std::vector<std::uint64_t>* skips = nullptr) const {
+    auto res_str = T{};
+    filter_and_count(line_str, res_str, hits, skips);
+    return res_str;
+  }
+
+  // Like filter_into, returns whether a filter changed the line
+  bool filter_and_count(const T& line_str, T& res_str,
+                        std::vector<std::uint64_t>& hits,
+                        std::vector<std::uint64_t>* skips = nullptr) const {
+    hits.resize(std::max(hits.size(), size()));
+    if (skips)
+      skips->resize(std::max(skips->size(), size()));
+    auto changed = false;
+    apply(
+        line_str, res_str,
+        [&](const filter_base& filt, const T& in, T& out,
+            std::size_t filt_i) {
+          if (!filt.filter_into(in, out, nullptr))
+            return false;
+          const auto hit = out != in;
+          hits[filt_i] += hit;
+          changed = changed || hit;
+          return true;
+        },
+        skips ? skips->data() : nullptr);
+    return changed;
+  }
+
+  std::size_t size() const {
+    return std::size_t(std::distance(filt_array_.begin(), filt_array_.end()));
+  }
+
   template <typename FilterT> void add_filter(FilterT&& filt) {
     using filter_ptr_type = filter_abstracter<std::decay_t<FilterT>>;
     auto myptr = std::make_unique<filter_ptr_type>(std::forward<FilterT>(filt));
     filt_array_.emplace_front(std::move(myptr));
+    auto screens = std::vector<std::vector<screen_clause>>{};
+    for (auto&& filt_ptr : filt_array_)
+      screens.push_back(filt_ptr->screen());
+    screen_ = multi_screen{screens};
   }
 
   template <typename FilterT, typename... FilterTypes>
@@ -63,7 +200,45 @@ public:
   }
 
 protected:
+  // The filters write to res_str and a scratch buffer in turn, the input
+  // is only read
+  template <typename ApplyFilter>
+  bool apply(const T& line_str, T& res_str, ApplyFilter apply_filter,
+             std::uint64_t* skips = nullptr) const {
+    thread_local auto scratch = T{};
+    const T* filtered = &line_str;
+    auto matched = false;
+    auto mask = scan(line_str);
+    auto filt_i = std::size_t{0};
+    for (auto&& filt : filt_array_) {
+      if (screen_.may_match(filt_i, mask)) {
+        auto& out = filtered == &res_str ? scratch : res_str;
+        if (apply_filter(*filt, *filtered, out, filt_i)) {
+          filtered = &out;
+          matched = true;
+          mask = scan(out);
+        }
+      } else if (skips) {
+        ++skips[filt_i];
+      }
+      ++filt_i;
+    }
+    if (filtered == &scratch)
+      res_str.swap(scratch);
+    else if (filtered != &res_str)
+      res_str = line_str;
+    return matched;
+  }
+
+  auto scan(const T& line_str) const {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>)
+      return screen_.scan(line_str);
+    else
+      return ~multi_screen::mask_type{0};
+  }
+
   std::forward_list<ptr_type> filt_array_;
+  multi_screen screen_;
 };
 } // namespace flt::parameter_filter
 
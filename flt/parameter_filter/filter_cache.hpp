@@ -0,0 +1,203 @@
+#ifndef FLT_PARAMETER_FILTER_FILTER_CACHE_HPP
+#define FLT_PARAMETER_FILTER_FILTER_CACHE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+struct filter_cache_stats {
+  std::uint64_t hits{0};
+  std::uint64_t misses{0};
+  std::uint64_t evictions{0};
+
+  double hit_rate() const {
+    return hits + misses ? double(hits) / double(hits + misses) : 0.;
+  }
+};
+
+// Remembers the filtered lines of up to capacity distinct raw lines, so lines
+// repeated often, like heartbeats, are filtered once. The entries are split
+// into shards by the hash of the line, each with its own lock and CLOCK
+// eviction, which keeps entries hit since the clock hand last passed them.
+// Lines are filtered outside the locks, so it can be used from parallel loops
+// like the filters. Parameters are cached when extracted, which requires the
+// filters to accept a std::back_insert_iterator into a std::vector.
+template <typename Filters, typename StringType = std::string>
+class filter_cache {
+public:
+  using params_type = std::vector<StringType>;
+
+  filter_cache(Filters filters, std::size_t capacity,
+               std::size_t num_shards = 16)
+      : filters_(std::move(filters)),
+        shards_(std::max<std::size_t>(1, std::min(capacity, num_shards))),
+        shard_capacity_((capacity + shards_.size() - 1) / shards_.size()) {}
+
+  StringType operator()(const StringType& line_str) const {
+    auto res_str = StringType{};
+    filter_into(line_str, res_str);
+    return res_str;
+  }
+
+  template <typename OutIt>
+  StringType operator()(const StringType& line_str, OutIt outit) const {
+    auto res_str = StringType{};
+    filter_into(line_str, res_str, outit);
+    return res_str;
+  }
+
+  // Like filter_array::filter_into, res_str may be line_str itself
+  bool filter_into(const StringType& line_str, StringType& res_str) const {
+    return filter_into_by(line_str, res_str,
+                          [this](const StringType& line, StringType& res) {
+                            return filters_.filter_into(line, res);
+                          });
+  }
+
+  template <typename OutIt>
+  bool filter_into(const StringType& line_str, StringType& res_str,
+                   OutIt outit) const {
+    if (shard_capacity_ == 0)
+      return filters_.filter_into(line_str, res_str, outit);
+    const auto hash = std::hash<StringType>{}(line_str);
+    auto& shard = shard_of(hash);
+    thread_local auto params = params_type{};
+    params.clear();
+    auto matched = false;
+    if (!shard.find(hash, line_str, res_str, matched, &params)) {
+      auto line = line_str;
+      matched = filters_.filter_into(line, res_str, std::back_inserter(params));
+      shard.insert(hash, std::move(line), res_str, matched, &params,
+                   shard_capacity_);
+    }
+    std::copy(params.begin(), params.end(), outit);
+    return matched;
+  }
+
+  // Calls filter_line(line_str, res_str) for lines not cached instead of the
+  // filters, e.g. to count the hits of each filter. It has to filter like
+  // them.
+  template <typename FilterLine>
+  bool filter_into_by(const StringType& line_str, StringType& res_str,
+                      FilterLine filter_line) const {
+    if (shard_capacity_ == 0)
+      return filter_line(line_str, res_str);
+    const auto hash = std::hash<StringType>{}(line_str);
+    auto& shard = shard_of(hash);
+    auto matched = false;
+    if (shard.find(hash, line_str, res_str, matched, nullptr))
+      return matched;
+    // res_str may be line_str
+    auto line = line_str;
+    matched = filter_line(line, res_str);
+    shard.insert(hash, std::move(line), res_str, matched, nullptr,
+                 shard_capacity_);
+    return matched;
+  }
+
+  filter_cache_stats stats() const {
+    auto res = filter_cache_stats{};
+    for (auto& shard : shards_) {
+      auto lock = std::lock_guard{shard.mtx};
+      res.hits += shard.stats.hits;
+      res.misses += shard.stats.misses;
+      res.evictions += shard.stats.evictions;
+    }
+    return res;
+  }
+
+  const Filters& filters() const { return filters_; }
+
+private:
+  struct entry {
+    std::size_t hash;
+    StringType line;
+    StringType filtered;
+    bool matched;
+    bool has_params;
+    params_type params;
+    bool referenced;
+  };
+
+  struct shard_type {
+    std::mutex mtx;
+    std::vector<entry> entries;
+    std::unordered_map<std::size_t, std::size_t> index;
+    std::size_t hand{0};
+    filter_cache_stats stats;
+
+    // Entries without cached parameters miss if params are asked for
+    bool find(std::size_t hash, const StringType& line_str,
+              StringType& res_str, bool& matched, params_type* params) {
+      auto lock = std::lock_guard{mtx};
+      const auto it = index.find(hash);
+      if (it == index.end() || entries[it->second].line != line_str ||
+          (params && !entries[it->second].has_params)) {
+        ++stats.misses;
+        return false;
+      }
+      ++stats.hits;
+      auto& hit = entries[it->second];
+      hit.referenced = true;
+      res_str = hit.filtered;
+      matched = hit.matched;
+      if (params)
+        *params = hit.params;
+      return true;
+    }
+
+    void insert(std::size_t hash, StringType line_str,
+                const StringType& res_str, bool matched,
+                const params_type* params, std::size_t capacity) {
+      auto lock = std::lock_guard{mtx};
+      auto slot = std::size_t{0};
+      if (const auto it = index.find(hash); it != index.end()) {
+        slot = it->second;
+      } else if (entries.size() < capacity) {
+        slot = entries.size();
+        entries.emplace_back();
+        index.emplace(hash, slot);
+      } else {
+        while (entries[hand].referenced) {
+          entries[hand].referenced = false;
+          hand = (hand + 1) % entries.size();
+        }
+        slot = hand;
+        hand = (hand + 1) % entries.size();
+        index.erase(entries[slot].hash);
+        index.emplace(hash, slot);
+        ++stats.evictions;
+      }
+      auto& filled = entries[slot];
+      filled.hash = hash;
+      filled.line = std::move(line_str);
+      filled.filtered = res_str;
+      filled.matched = matched;
+      filled.has_params = params != nullptr;
+      if (params)
+        filled.params = *params;
+      else
+        filled.params.clear();
+      filled.referenced = false;
+    }
+  };
+
+  shard_type& shard_of(std::size_t hash) const {
+    return shards_[(hash >> 16) % shards_.size()];
+  }
+
+  const Filters filters_;
+  mutable std::vector<shard_type> shards_;
+  const std::size_t shard_capacity_;
+};
+} // namespace flt::parameter_filter
+
+#endif
@@ -1,11 +1,15 @@
 #ifndef PARAMETER_FILTER_IPV6_ADDRESS_FILTER_HPP
 #define PARAMETER_FILTER_IPV6_ADDRESS_FILTER_HPP
 
+#include <flt/parameter_filter/param_spans.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+
 #include <algorithm>
 #include <functional>
 #include <regex>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace flt::parameter_filter {
 template <typename StringType = std::string> class ipv6_address_filter {
@@ -22,7 +26,24 @@ public:
     return apply_filter(line_str, nullptr);
   }
 
+  // Like regex_filter::filter_edits
+  template <typename T>
+  bool filter_edits(const T& line_str, T& res_str,
+                    std::vector<filter_edit>& edits) const {
+    const auto num_edits = edits.size();
+    auto filtered = apply_filter(line_str, nullptr, &edits);
+    if (edits.size() == num_edits)
+      return false;
+    res_str = std::move(filtered);
+    return true;
+  }
+
+  // Addresses are only looked for where regex_ipv6_begin matches
+  const std::vector<screen_clause>& screen() const { return screen_; }
+
 protected:
+  const std::vector<screen_clause> screen_{
+      regex_screen(R"(\b[[:xdigit:]]{1,4}:|::)", false)};
   const std::regex regex_ipv6_begin{R"(\b[[:xdigit:]]{1,4}:|::)",
                                     std::regex::optimize};
   const std::regex regex_ipv6_mid{R"([[:xdigit:]]{1,4}:)",
@@ -34,7 +55,8 @@ protected:
   const std::regex regex_port{R"(]:\d{1,5}(?![\w:]))", std::regex::optimize};
 
   template <typename T, typename Its>
-  auto apply_filter(const T& line_str, [[maybe_unused]] Its output_it) const {
+  auto apply_filter(const T& line_str, [[maybe_unused]] Its output_it,
+                    std::vector<filter_edit>* edits = nullptr) const {
     auto res_str = T{};
     auto res_str_it = std::back_inserter(res_str);
     using regex_it = std::regex_iterator<typename T::const_iterator>;
@@ -131,11 +153,22 @@ protected:
         res_str_it =
             std::copy(prefix_start + !first_match,
                       std::get<1>(regex_m.prefix()) - has_port, res_str_it);
+        const auto out_begin = res_str.size();
         res_str_it = regex_m.format(res_str_it, replacement_str_);
         regex_m_last = regex_m_cont;
         prefix_start = std::get<0>(regex_m_last.suffix()) - 1;
         first_match = false;
 
+        if (edits) {
+          const auto pos = [&](auto it) {
+            return std::size_t(it - std::cbegin(line_str));
+          };
+          const auto end = pos(std::get<0>(regex_m_last.suffix()));
+          edits->push_back(
+              {pos(std::get<1>(regex_m.prefix()) - has_port), end, out_begin,
+               res_str.size(), pos(std::get<0>(regex_m[0])), end});
+        }
+
         if constexpr (!std::is_same_v<Its, std::nullptr_t>) {
           auto extr_str_begin = std::get<0>(regex_m[0]);
           auto extr_str_end = std::get<0>(regex_m_last.suffix());
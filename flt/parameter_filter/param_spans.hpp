@@ -0,0 +1,260 @@
+#ifndef FLT_PARAMETER_FILTER_PARAM_SPANS_HPP
+#define FLT_PARAMETER_FILTER_PARAM_SPANS_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+// How the parameters a filter extracts are parsed
+enum class value_format : std::uint8_t { text, decimal, hexadecimal };
+
+enum class value_kind : std::uint8_t { text, integer, real };
+
+// A parameter as the range of the original line it was extracted from, which
+// covers the text earlier filters replaced within it. Lines are limited to
+// 4 GiB.
+struct param_span {
+  // Index of the filter in the order the filters are applied
+  std::uint32_t filter;
+  std::uint32_t begin;
+  std::uint32_t length;
+  value_kind kind;
+  // Index of the value in param_spans::integers or reals, by kind
+  std::uint32_t value;
+};
+
+// The parameters of one or more lines in flat arrays, which keep their
+// capacity when cleared
+struct param_spans {
+  std::vector<param_span> spans;
+  std::vector<std::int64_t> integers;
+  std::vector<double> reals;
+
+  void clear() {
+    spans.clear();
+    integers.clear();
+    reals.clear();
+  }
+
+  // Adds a parameter, parsing its text by format. Numbers that don't parse
+  // completely stay text.
+  void add(std::size_t filter, std::pair<std::size_t, std::size_t> range,
+           value_format format, std::string_view text) {
+    auto span = param_span{std::uint32_t(filter), std::uint32_t(range.first),
+                           std::uint32_t(range.second - range.first),
+                           value_kind::text, 0};
+    const auto last = text.data() + text.size();
+    const auto parsed = [&](std::from_chars_result res) {
+      return res.ec == std::errc{} && res.ptr == last;
+    };
+    auto integer = std::int64_t{0};
+    auto real = 0.;
+    if (format == value_format::hexadecimal && text.size() > 2 &&
+        text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+      if (parsed(std::from_chars(text.data() + 2, last, integer, 16)))
+        span.kind = value_kind::integer;
+    } else if (format == value_format::decimal) {
+      if (parsed(std::from_chars(text.data(), last, integer)))
+        span.kind = value_kind::integer;
+      else if (parsed(std::from_chars(text.data(), last, real)))
+        span.kind = value_kind::real;
+    }
+    if (span.kind == value_kind::integer) {
+      span.value = std::uint32_t(integers.size());
+      integers.push_back(integer);
+    } else if (span.kind == value_kind::real) {
+      span.value = std::uint32_t(reals.size());
+      reals.push_back(real);
+    }
+    spans.push_back(span);
+  }
+};
+
+// A match a filter replaced, [begin, end) of its input by [out_begin, out_end)
+// of its output, extracting [param_begin, param_end) of its input. Filters
+// providing filter_edits report them in the order of the line.
+struct filter_edit {
+  static constexpr auto no_param = std::size_t(-1);
+  std::size_t begin;
+  std::size_t end;
+  std::size_t out_begin;
+  std::size_t out_end;
+  std::size_t param_begin{no_param};
+  std::size_t param_end{no_param};
+};
+
+namespace detail {
+// Maps the positions of a filtered line to the original line. Text copied
+// from the original line maps to itself, text a filter inserted to the range
+// of the original line it replaced.
+class origin_map {
+public:
+  void reset(std::size_t size) {
+    pieces_.assign(1, {0, size, 0, size, true});
+    size_ = size;
+  }
+
+  // The range of the original line the range [begin, end) maps to
+  std::pair<std::size_t, std::size_t> map(std::size_t begin,
+                                          std::size_t end) const {
+    if (begin == end) {
+      const auto pos = begin < size_ ? first_of(begin) : last_of(begin);
+      return {pos, pos};
+    }
+    return {first_of(begin), last_of(end)};
+  }
+
+  // Applies the edits of a filter, which filtered the mapped line into a
+  // line of out_size
+  void apply(const std::vector<filter_edit>& edits, std::size_t out_size) {
+    next_.clear();
+    auto in_pos = std::size_t{0};
+    auto out_pos = std::size_t{0};
+    for (const auto& edit : edits) {
+      copy_range(in_pos, edit.begin, out_pos);
+      if (edit.out_end > edit.out_begin) {
+        const auto [orig_begin, orig_end] = map(edit.begin, edit.end);
+        next_.push_back(
+            {edit.out_begin, edit.out_end, orig_begin, orig_end, false});
+      }
+      in_pos = edit.end;
+      out_pos = edit.out_end;
+    }
+    copy_range(in_pos, size_, out_pos);
+    pieces_.swap(next_);
+    size_ = out_size;
+  }
+
+private:
+  struct piece {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t orig_begin;
+    std::size_t orig_end;
+    // Whether the piece is a copy of [orig_begin, orig_end)
+    bool copied;
+  };
+
+  std::size_t piece_of(std::size_t pos) const {
+    const auto it = std::upper_bound(
+        pieces_.begin(), pieces_.end(), pos,
+        [](std::size_t pos, const piece& p) { return pos < p.begin; });
+    return std::size_t(it - pieces_.begin()) - 1;
+  }
+
+  std::size_t first_of(std::size_t pos) const {
+    const auto& p = pieces_[piece_of(pos)];
+    return p.copied ? p.orig_begin + (pos - p.begin) : p.orig_begin;
+  }
+
+  // Maps the end of a range, i.e. the position after pos - 1
+  std::size_t last_of(std::size_t pos) const {
+    if (pos == 0)
+      return pieces_.empty() ? 0 : pieces_.front().orig_begin;
+    const auto& p = pieces_[piece_of(pos - 1)];
+    return p.copied ? p.orig_begin + (pos - p.begin) : p.orig_end;
+  }
+
+  // Adds the pieces of [begin, end), copied to out_begin
+  void copy_range(std::size_t begin, std::size_t end, std::size_t out_begin) {
+    if (begin >= end)
+      return;
+    for (auto i = piece_of(begin); i < pieces_.size() && pieces_[i].begin < end;
+         ++i) {
+      auto p = pieces_[i];
+      const auto first = std::max(p.begin, begin);
+      const auto last = std::min(p.end, end);
+      if (p.copied) {
+        p.orig_begin += first - p.begin;
+        p.orig_end = p.orig_begin + (last - first);
+      }
+      p.begin = first - begin + out_begin;
+      p.end = last - begin + out_begin;
+      next_.push_back(p);
+    }
+  }
+
+  std::vector<piece> pieces_;
+  std::vector<piece> next_;
+  std::size_t size_{0};
+};
+
+// Turns the edits of each filter applied to a line into the spans of its
+// parameters in the original line
+class span_recorder {
+public:
+  void start(std::size_t size) { origins_.reset(size); }
+
+  // Cleared for the next filter
+  std::vector<filter_edit>& edits() {
+    edits_.clear();
+    return edits_;
+  }
+
+  // Adds the parameters of the edits filter filt_i made to line_str, which
+  // it filtered into a line of out_size
+  void record(std::size_t filt_i, std::string_view line_str,
+              std::size_t out_size, value_format format, param_spans& spans) {
+    for (const auto& edit : edits_)
+      if (edit.param_begin != filter_edit::no_param)
+        spans.add(filt_i, origins_.map(edit.param_begin, edit.param_end),
+                  format,
+                  line_str.substr(edit.param_begin,
+                                  edit.param_end - edit.param_begin));
+    origins_.apply(edits_, out_size);
+  }
+
+private:
+  origin_map origins_;
+  std::vector<filter_edit> edits_;
+};
+
+template <typename FilterT, typename = void>
+struct has_values : std::false_type {};
+template <typename FilterT>
+struct has_values<
+    FilterT, std::void_t<decltype(std::declval<const FilterT&>().values())>>
+    : std::true_type {};
+
+template <typename FilterT, typename T, typename = void>
+struct has_filter_edits : std::false_type {};
+template <typename FilterT, typename T>
+struct has_filter_edits<
+    FilterT, T,
+    std::void_t<decltype(std::declval<const FilterT&>().filter_edits(
+        std::declval<const T&>(), std::declval<T&>(),
+        std::declval<std::vector<filter_edit>&>()))>> : std::true_type {};
+
+template <typename FilterT> value_format values_of(const FilterT& filt) {
+  if constexpr (has_values<FilterT>::value)
+    return filt.values();
+  else
+    return value_format::text;
+}
+
+// Filters without filter_edits replace the whole line and extract no spans
+template <typename FilterT, typename T>
+bool filter_edits(const FilterT& filt, const T& line_str, T& res_str,
+                  std::vector<filter_edit>& edits) {
+  if constexpr (has_filter_edits<FilterT, T>::value) {
+    return filt.filter_edits(line_str, res_str, edits);
+  } else {
+    auto filtered = filt(line_str);
+    if (filtered == line_str)
+      return false;
+    res_str = std::move(filtered);
+    edits.push_back({0, line_str.size(), 0, res_str.size()});
+    return true;
+  }
+}
+} // namespace detail
+} // namespace flt::parameter_filter
+
+#endif
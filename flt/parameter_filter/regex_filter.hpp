@@ -1,12 +1,20 @@
 #ifndef PARAMETER_FILTER_REGEX_FILTER_HPP
 #define PARAMETER_FILTER_REGEX_FILTER_HPP
 
+#include <flt/parameter_filter/param_spans.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+#include <flt/parameter_filter/replacement_format.hpp>
+
 #include <algorithm>
+#include <cstddef>
 #include <functional>
+#include <iterator>
 #include <optional>
 #include <regex>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace flt::parameter_filter {
 template <typename CharT, typename RegexTraits,
@@ -22,7 +30,36 @@ public:
                    std::regex_constants::format_default)
       : regex_(std::move(regex)), replacement_str_(std::move(replacement_str)),
         extraction_str_(std::move(extraction_str)),
-        regex_flags_(std::move(regex_flags)) {}
+        regex_flags_(std::move(regex_flags)),
+        replacement_(replacement_str_, regex_.mark_count() + 1),
+        extraction_(extraction_str_, regex_.mark_count() + 1) {}
+
+  // Filters constructed from the pattern keep it and skip lines the pattern
+  // can't match without running the regex when applied by a filter_array
+  regex_filter(StringType pattern,
+               typename regex_type::flag_type syntax =
+                   std::regex_constants::ECMAScript,
+               StringType replacement_str = StringType{"$$v"},
+               StringType extraction_str = StringType{"$&"},
+               std::regex_constants::match_flag_type regex_flags =
+                   std::regex_constants::format_default)
+      : regex_filter(regex_type{pattern, syntax}, std::move(replacement_str),
+                     std::move(extraction_str), regex_flags) {
+    if constexpr (sizeof(CharT) == 1)
+      if ((syntax & (std::regex_constants::basic |
+                     std::regex_constants::extended |
+                     std::regex_constants::awk | std::regex_constants::grep |
+                     std::regex_constants::egrep)) == 0)
+        screen_ = regex_screen(
+            std::string_view{pattern.data(), pattern.size()},
+            (syntax & std::regex_constants::icase) != 0);
+    pattern_ = std::move(pattern);
+  }
+
+  // Empty if constructed from a regex
+  const StringType& pattern() const { return pattern_; }
+
+  const std::vector<screen_clause>& screen() const { return screen_; }
 
   template <typename OutIt, typename T>
   auto operator()(const T& line_str, OutIt output_cont) const {
@@ -33,47 +70,113 @@ public:
     return apply_filter(line_str, nullptr);
   }
 
-protected:
+  // Writes the filtered line to res_str, reusing its capacity, and returns
+  // true if the regex matched. Otherwise res_str, which can't be line_str, is
+  // left alone. Pass nullptr as output_it to not extract parameters.
   template <typename T, typename Its>
-  auto apply_filter(const T& line_str, [[maybe_unused]] Its output_it) const {
-    auto res_str = T{};
-    auto res_str_it = std::back_inserter(res_str);
-    using regex_it = std::regex_iterator<typename T::const_iterator>;
-    auto regex_i_last = regex_it{};
-    for (auto regex_i =
-                  regex_it{std::cbegin(line_str), std::cend(line_str), regex_},
-              regex_end = regex_it{};
-         regex_i != regex_end; regex_i_last = regex_i++) {
-      const auto regex_m = *regex_i;
-      res_str_it = std::copy(std::get<0>(regex_m.prefix()),
-                             std::get<1>(regex_m.prefix()), res_str_it);
+  bool filter_into(const T& line_str, T& res_str, Its output_it) const {
+    return filter_matches(line_str, res_str, output_it, nullptr);
+  }
+
+  // Like filter_into, appends the matches replaced to edits instead of
+  // extracting parameters
+  template <typename T>
+  bool filter_edits(const T& line_str, T& res_str,
+                    std::vector<filter_edit>& edits) const {
+    return filter_matches(line_str, res_str, nullptr, &edits);
+  }
 
+protected:
+  template <typename T, typename Its>
+  bool filter_matches(const T& line_str, T& res_str,
+                      [[maybe_unused]] Its output_it,
+                      std::vector<filter_edit>* edits) const {
+    using iterator = typename T::const_iterator;
+    thread_local auto regex_m = std::match_results<iterator>{};
+    const auto first = std::cbegin(line_str);
+    const auto last = std::cend(line_str);
+    auto flags = regex_flags_;
+    auto start = first;
+    if (!std::regex_search(start, last, regex_m, regex_, flags))
+      return false;
+    res_str.clear();
+    auto prefix_first = first;
+    const auto append_ref = [&](std::size_t ref, T& out) {
+      if (ref == replacement_format<StringType>::prefix_ref)
+        out.append(prefix_first, regex_m[0].first);
+      else if (ref == replacement_format<StringType>::suffix_ref)
+        out.append(regex_m[0].second, last);
+      else if (regex_m[ref].matched)
+        out.append(regex_m[ref].first, regex_m[ref].second);
+    };
+    // Visits the matches like regex_iterator does
+    for (auto found = true; found;) {
+      res_str.append(prefix_first, regex_m[0].first);
       if constexpr (!std::is_same_v<Its, std::nullptr_t>) {
         auto extr_str = T{};
-        auto extr_str_it = std::back_inserter(extr_str);
-        extr_str_it = regex_m.format(extr_str_it, extraction_str_);
+        extraction_.append(extr_str, append_ref);
         *output_it = std::move(extr_str);
         ++output_it;
       }
-
-      res_str_it = regex_m.format(res_str_it, replacement_str_);
-    }
-    if (regex_i_last != regex_it{}) {
-      const auto regex_m_last = *regex_i_last;
-      res_str_it = std::copy(std::get<0>(regex_m_last.suffix()),
-                             std::get<1>(regex_m_last.suffix()), res_str_it);
-    } else {
-      res_str = line_str;
+      const auto out_begin = res_str.size();
+      replacement_.append(res_str, append_ref);
+      if (edits) {
+        const auto pos = [&](iterator it) { return std::size_t(it - first); };
+        const auto param = extraction_.extent(
+            [&](std::size_t ref) {
+              if (ref == replacement_format<StringType>::prefix_ref)
+                return std::pair{pos(prefix_first), pos(regex_m[0].first)};
+              if (ref == replacement_format<StringType>::suffix_ref)
+                return std::pair{pos(regex_m[0].second), pos(last)};
+              if (!regex_m[ref].matched)
+                return std::pair{std::size_t(-1), std::size_t(-1)};
+              return std::pair{pos(regex_m[ref].first),
+                               pos(regex_m[ref].second)};
+            },
+            pos(regex_m[0].first));
+        edits->push_back({pos(regex_m[0].first), pos(regex_m[0].second),
+                          out_begin, res_str.size(), param.first,
+                          param.second});
+      }
+      prefix_first = start = regex_m[0].second;
+      if (regex_m[0].first == regex_m[0].second) {
+        if (start == last)
+          break;
+        if (std::regex_search(start, last, regex_m, regex_,
+                              flags | std::regex_constants::match_not_null |
+                                  std::regex_constants::match_continuous))
+          continue;
+        ++start;
+      }
+      flags |= std::regex_constants::match_prev_avail;
+      found = std::regex_search(start, last, regex_m, regex_, flags);
     }
-    return std::move(res_str);
+    res_str.append(prefix_first, last);
+    return true;
+  }
+
+  template <typename T, typename Its>
+  auto apply_filter(const T& line_str, Its output_it) const {
+    auto res_str = T{};
+    if (!filter_into(line_str, res_str, output_it))
+      return line_str;
+    return res_str;
   }
 
   const regex_type regex_;
   const StringType replacement_str_;
   const StringType extraction_str_;
   const std::regex_constants::match_flag_type regex_flags_;
+  const replacement_format<StringType> replacement_;
+  const replacement_format<StringType> extraction_;
+  StringType pattern_;
+  std::vector<screen_clause> screen_;
 };
 
+template <typename CharT, typename... Args>
+regex_filter(std::basic_string<CharT>, Args...)
+    -> regex_filter<CharT, std::regex_traits<CharT>>;
+
 } // namespace flt::parameter_filter
 
 #endif
@@ -0,0 +1,607 @@
+#ifndef FLT_PARAMETER_FILTER_REGEX_SCREEN_HPP
+#define FLT_PARAMETER_FILTER_REGEX_SCREEN_HPP
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Filters skip lines they can't match without running their regex. A line
+// can only contain a match if it satisfies all screen clauses derived from
+// the pattern, e.g. a byte of a set followed by a byte of another set. The
+// clauses of all filters of a filter_array are checked in one pass over the
+// line.
+namespace flt::parameter_filter {
+using byte_set = std::bitset<256>;
+
+// The line contains a byte of first, followed by a byte of second if given.
+// With at_begin, the line begins with a byte of first.
+struct screen_clause {
+  byte_set first;
+  std::optional<byte_set> second;
+  bool at_begin{false};
+
+  bool operator==(const screen_clause& other) const {
+    return first == other.first && second == other.second &&
+           at_begin == other.at_begin;
+  }
+};
+
+namespace detail {
+inline byte_set bytes_where(bool (*pred)(unsigned char)) {
+  auto set = byte_set{};
+  for (auto b = 0u; b < 256; ++b)
+    set[b] = pred(static_cast<unsigned char>(b));
+  return set;
+}
+
+inline byte_set byte_range(unsigned char low, unsigned char high) {
+  auto set = byte_set{};
+  for (auto b = unsigned(low); b <= high; ++b)
+    set[b] = true;
+  return set;
+}
+
+// Bytes beyond ASCII may belong to the classes in some locales. They are only
+// left out of classes that are negated.
+inline byte_set named_class(std::string_view name, bool negated = false) {
+  const auto non_ascii = negated ? byte_set{} : byte_range(0x80, 0xff);
+  const auto digit = byte_range('0', '9');
+  const auto upper = byte_range('A', 'Z') | non_ascii;
+  const auto lower = byte_range('a', 'z') | non_ascii;
+  const auto space = bytes_where([](unsigned char b) {
+                       return b == ' ' || (b >= '\t' && b <= '\r');
+                     }) |
+                     non_ascii;
+  if (name == "digit" || name == "d")
+    return digit;
+  if (name == "xdigit")
+    return digit | byte_range('a', 'f') | byte_range('A', 'F');
+  if (name == "upper")
+    return upper;
+  if (name == "lower")
+    return lower;
+  if (name == "alpha")
+    return upper | lower;
+  if (name == "alnum")
+    return upper | lower | digit;
+  if (name == "w")
+    return upper | lower | digit | byte_set{}.set('_');
+  if (name == "space" || name == "s")
+    return space;
+  if (name == "blank")
+    return byte_set{}.set(' ').set('\t') | non_ascii;
+  if (name == "punct")
+    return bytes_where([](unsigned char b) {
+             return b > ' ' && b < 0x7f && !(b >= '0' && b <= '9') &&
+                    !(b >= 'a' && b <= 'z') && !(b >= 'A' && b <= 'Z');
+           }) |
+           non_ascii;
+  if (name == "graph" || name == "print")
+    return byte_range(name == "graph" ? '!' : ' ', 0x7e) | non_ascii;
+  if (name == "cntrl")
+    return byte_range(0, 0x1f) | byte_set{}.set(0x7f) | non_ascii;
+  throw std::invalid_argument{"character class " + std::string{name}};
+}
+
+// Crude estimate of how many lines contain the bytes, the most selective
+// clauses are kept
+inline double byte_weight(std::size_t b) {
+  const auto common = (b >= '0' && b <= '9') || (b >= 'a' && b <= 'z') ||
+                      (b >= 'A' && b <= 'Z') || b == ' ';
+  return common ? 1. : 0.25;
+}
+
+inline double weight(const byte_set& set) {
+  auto sum = 0.;
+  for (auto b = std::size_t{0}; b < set.size(); ++b)
+    if (set[b])
+      sum += byte_weight(b);
+  return sum;
+}
+
+inline double clause_cost(const screen_clause& clause) {
+  const auto cost = weight(clause.first) *
+                    (clause.second ? weight(*clause.second) / 16. : 1.);
+  return clause.at_begin ? cost / 16. : cost;
+}
+
+// What a subexpression matches: whether it matches the empty string, the
+// bytes its non-empty matches begin and end with and conditions all its
+// matches satisfy
+struct regex_info {
+  bool nullable{true};
+  byte_set first;
+  byte_set last;
+  std::vector<screen_clause> clauses;
+  // Only matches at the beginning of the line
+  bool at_begin{false};
+  // Only matches the empty string, like assertions
+  bool zero_width{true};
+};
+
+inline void add_clause(std::vector<screen_clause>& clauses,
+                       screen_clause clause, std::size_t max_clauses) {
+  if (clause.first.none() || (clause.second && clause.second->none()))
+    return;
+  if (!clause.second && !clause.at_begin && clause.first.all())
+    return;
+  if (std::find(clauses.begin(), clauses.end(), clause) != clauses.end())
+    return;
+  clauses.push_back(std::move(clause));
+  if (clauses.size() > max_clauses) {
+    std::stable_sort(clauses.begin(), clauses.end(),
+                     [](const auto& a, const auto& b) {
+                       return clause_cost(a) < clause_cost(b);
+                     });
+    clauses.resize(max_clauses);
+  }
+}
+
+// A clause both clauses imply
+inline screen_clause join(const screen_clause& a, const screen_clause& b) {
+  if (a.second && b.second && a.at_begin == b.at_begin)
+    return {a.first | b.first, *a.second | *b.second, a.at_begin};
+  if (!a.second && !b.second)
+    return {a.first | b.first, std::nullopt, a.at_begin && b.at_begin};
+  const auto& pair = a.second ? a : b;
+  const auto& other = a.second ? b : a;
+  auto first = screen_clause{pair.first | other.first, std::nullopt, false};
+  auto second =
+      screen_clause{*pair.second | other.first, std::nullopt, false};
+  return clause_cost(first) <= clause_cost(second) ? first : second;
+}
+
+// Analyzes the ECMAScript subset the filters use, anything else is rejected
+class regex_analyzer {
+public:
+  static constexpr std::size_t max_clauses = 8;
+
+  regex_analyzer(std::string_view pattern, bool icase)
+      : pattern_(pattern), icase_(icase) {}
+
+  regex_info analyze() {
+    auto info = alternation();
+    if (pos_ != pattern_.size())
+      unsupported();
+    if (info.at_begin && !info.nullable)
+      add_clause(info.clauses, {info.first, std::nullopt, true}, max_clauses);
+    return info;
+  }
+
+private:
+  [[noreturn]] void unsupported() const {
+    throw std::invalid_argument{"Unsupported regex " + std::string{pattern_}};
+  }
+
+  bool at_end() const { return pos_ == pattern_.size(); }
+  char peek() const { return at_end() ? '\0' : pattern_[pos_]; }
+  char next() {
+    if (at_end())
+      unsupported();
+    return pattern_[pos_++];
+  }
+
+  byte_set folded(byte_set set) const {
+    if (icase_)
+      for (auto b = 'a'; b <= 'z'; ++b) {
+        const auto upper = std::size_t(b - 'a' + 'A');
+        const auto lower = std::size_t(b);
+        if (set[lower] || set[upper])
+          set.set(lower).set(upper);
+      }
+    return set;
+  }
+
+  regex_info bytes(const byte_set& set) const {
+    auto info = regex_info{false, folded(set), folded(set), {}, false, false};
+    add_clause(info.clauses, {info.first, std::nullopt, false}, max_clauses);
+    return info;
+  }
+
+  static regex_info anything() {
+    return regex_info{true, byte_set{}.set(), byte_set{}.set(), {}, false,
+                      false};
+  }
+
+  static regex_info concat(regex_info a, regex_info b) {
+    auto info = regex_info{};
+    info.nullable = a.nullable && b.nullable;
+    info.first = a.nullable ? a.first | b.first : a.first;
+    info.last = b.nullable ? a.last | b.last : b.last;
+    info.at_begin = a.at_begin || (a.zero_width && b.at_begin);
+    info.zero_width = a.zero_width && b.zero_width;
+    info.clauses = std::move(a.clauses);
+    for (auto& clause : b.clauses)
+      add_clause(info.clauses, std::move(clause), max_clauses);
+    if (!a.nullable && !b.nullable)
+      add_clause(info.clauses, {a.last, b.first}, max_clauses);
+    return info;
+  }
+
+  static regex_info either(const regex_info& a, const regex_info& b) {
+    auto info = regex_info{};
+    info.nullable = a.nullable || b.nullable;
+    info.first = a.first | b.first;
+    info.last = a.last | b.last;
+    info.at_begin = a.at_begin && b.at_begin;
+    info.zero_width = a.zero_width && b.zero_width;
+    for (const auto& clause_a : a.clauses)
+      for (const auto& clause_b : b.clauses)
+        add_clause(info.clauses, join(clause_a, clause_b), max_clauses);
+    return info;
+  }
+
+  static regex_info repeat(regex_info info, std::size_t min) {
+    if (min == 0) {
+      info.nullable = true;
+      info.clauses.clear();
+      info.at_begin = false;
+    } else if (min > 1 && !info.nullable) {
+      add_clause(info.clauses, {info.last, info.first}, max_clauses);
+    }
+    return info;
+  }
+
+  regex_info alternation() {
+    auto info = sequence();
+    while (peek() == '|') {
+      ++pos_;
+      info = either(info, sequence());
+    }
+    return info;
+  }
+
+  regex_info sequence() {
+    auto info = regex_info{};
+    while (!at_end() && peek() != '|' && peek() != ')')
+      info = concat(std::move(info), quantified());
+    return info;
+  }
+
+  std::size_t number() {
+    if (!std::isdigit(static_cast<unsigned char>(peek())))
+      unsupported();
+    auto value = std::size_t{0};
+    while (std::isdigit(static_cast<unsigned char>(peek())))
+      value = value * 10 + std::size_t(next() - '0');
+    return value;
+  }
+
+  regex_info quantified() {
+    auto info = atom();
+    for (;;) {
+      auto min = std::size_t{0};
+      switch (peek()) {
+      case '*':
+        ++pos_;
+        break;
+      case '+':
+        ++pos_;
+        min = 1;
+        break;
+      case '?':
+        ++pos_;
+        break;
+      case '{':
+        ++pos_;
+        min = number();
+        if (peek() == ',') {
+          ++pos_;
+          if (peek() != '}')
+            number();
+        }
+        if (next() != '}')
+          unsupported();
+        break;
+      default:
+        return info;
+      }
+      if (info.zero_width)
+        unsupported();
+      info = repeat(std::move(info), min);
+      // Lazy quantifiers match the same lines
+      if (peek() == '?')
+        ++pos_;
+    }
+  }
+
+  regex_info atom() {
+    switch (const auto c = next()) {
+    case '^': {
+      auto info = regex_info{};
+      info.at_begin = true;
+      return info;
+    }
+    case '$':
+      return regex_info{};
+    case '.':
+      return bytes(byte_set{}.set());
+    case '[':
+      return bytes(bracket());
+    case '(':
+      return group();
+    case '\\':
+      return escape();
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case ')':
+      unsupported();
+    default:
+      return bytes(byte_set{}.set(static_cast<unsigned char>(c)));
+    }
+  }
+
+  regex_info group() {
+    auto kind = '\0';
+    if (peek() == '?') {
+      ++pos_;
+      kind = next();
+      if (kind != ':' && kind != '=' && kind != '!')
+        unsupported();
+    }
+    auto info = alternation();
+    if (next() != ')')
+      unsupported();
+    if (kind == '!')
+      return regex_info{};
+    if (kind == '=') {
+      // Lookaheads don't consume their match, which is still in the line
+      auto assertion = regex_info{};
+      assertion.clauses = std::move(info.clauses);
+      return assertion;
+    }
+    return info;
+  }
+
+  regex_info escape() {
+    const auto c = next();
+    switch (c) {
+    case 'b':
+    case 'B':
+      return regex_info{};
+    case 'd':
+    case 's':
+    case 'w':
+      return bytes(named_class(std::string_view{&c, 1}));
+    case 'D':
+    case 'S':
+    case 'W':
+      return bytes(~named_class(
+          std::string(1, char(std::tolower(static_cast<unsigned char>(c)))),
+          true));
+    default:
+      if (std::isdigit(static_cast<unsigned char>(c))) {
+        // Backreferences match anything the group matched
+        if (c == '0')
+          unsupported();
+        return anything();
+      }
+      return bytes(byte_set{}.set(escaped(c)));
+    }
+  }
+
+  unsigned char escaped(char c) const {
+    switch (c) {
+    case 'n':
+      return '\n';
+    case 't':
+      return '\t';
+    case 'r':
+      return '\r';
+    case 'f':
+      return '\f';
+    case 'v':
+      return '\v';
+    case 'c':
+    case 'x':
+    case 'u':
+      unsupported();
+    default:
+      if (std::isalnum(static_cast<unsigned char>(c)))
+        unsupported();
+      return static_cast<unsigned char>(c);
+    }
+  }
+
+  byte_set bracket() {
+    auto set = byte_set{};
+    const auto negated = peek() == '^';
+    if (negated)
+      ++pos_;
+    for (auto first = true; first || peek() != ']'; first = false) {
+      if (pattern_.compare(pos_, 2, "[:") == 0) {
+        const auto end = pattern_.find(":]", pos_ + 2);
+        if (end == std::string_view::npos)
+          unsupported();
+        set |= named_class(pattern_.substr(pos_ + 2, end - pos_ - 2),
+                           negated);
+        pos_ = end + 2;
+        continue;
+      }
+      auto low = next();
+      if (low == '\\') {
+        const auto c = next();
+        if (c == 'd' || c == 's' || c == 'w') {
+          set |= named_class(std::string_view{&c, 1}, negated);
+          continue;
+        }
+        if (c == 'D' || c == 'S' || c == 'W')
+          unsupported();
+        low = char(c == 'b' ? '\b' : escaped(c));
+      }
+      if (peek() == '-' && pos_ + 1 < pattern_.size() &&
+          pattern_[pos_ + 1] != ']') {
+        ++pos_;
+        auto high = next();
+        if (high == '\\')
+          high = char(escaped(next()));
+        if (static_cast<unsigned char>(high) < static_cast<unsigned char>(low))
+          unsupported();
+        set |= byte_range(static_cast<unsigned char>(low),
+                          static_cast<unsigned char>(high));
+      } else {
+        set.set(static_cast<unsigned char>(low));
+      }
+    }
+    ++pos_;
+    return negated ? ~folded(set) : set;
+  }
+
+  std::string_view pattern_;
+  std::size_t pos_{0};
+  bool icase_;
+};
+} // namespace detail
+
+// Clauses every line containing a match of the ECMAScript pattern satisfies.
+// Patterns using syntax not understood here give no clauses, so lines are
+// never skipped.
+inline std::vector<screen_clause> regex_screen(std::string_view pattern,
+                                               bool icase,
+                                               std::size_t max_clauses = 3) {
+  auto clauses = std::vector<screen_clause>{};
+  try {
+    clauses = detail::regex_analyzer{pattern, icase}.analyze().clauses;
+  } catch (const std::invalid_argument&) {
+    return {};
+  }
+  std::stable_sort(clauses.begin(), clauses.end(),
+                   [](const auto& a, const auto& b) {
+                     return detail::clause_cost(a) < detail::clause_cost(b);
+                   });
+  if (clauses.size() > max_clauses)
+    clauses.resize(max_clauses);
+  return clauses;
+}
+
+// Clauses every line containing the literal satisfies, for filters without
+// a pattern that only match such lines
+inline std::vector<screen_clause> literal_screen(std::string_view literal,
+                                                 bool icase = false) {
+  auto pattern = std::string{};
+  for (auto c : literal) {
+    if (!std::isalnum(static_cast<unsigned char>(c)))
+      pattern += '\\';
+    pattern += c;
+  }
+  return regex_screen(pattern, icase);
+}
+
+// Checks the clauses of several filters in one pass over a line. Bytes no
+// clause tells apart share a class, the pairs of classes found in the line
+// are looked up in a table of the clauses they satisfy.
+class multi_screen {
+public:
+  using mask_type = std::uint64_t;
+  static constexpr std::size_t max_clauses =
+      std::numeric_limits<mask_type>::digits;
+
+  multi_screen() = default;
+
+  // The clauses of each filter, clauses beyond max_clauses are dropped
+  explicit multi_screen(
+      const std::vector<std::vector<screen_clause>>& screens) {
+    auto clauses = std::vector<screen_clause>{};
+    for (const auto& screen : screens) {
+      auto required = mask_type{0};
+      for (const auto& clause : screen) {
+        auto found = std::find(clauses.begin(), clauses.end(), clause);
+        if (found == clauses.end()) {
+          if (clauses.size() == max_clauses)
+            continue;
+          found = clauses.insert(clauses.end(), clause);
+        }
+        required |= mask_type{1} << std::size_t(found - clauses.begin());
+      }
+      required_.push_back(required);
+    }
+    if (clauses.empty())
+      return;
+
+    auto classes = std::map<std::vector<bool>, std::uint8_t>{};
+    auto representatives = std::vector<std::size_t>{};
+    for (auto b = std::size_t{0}; b < 256; ++b) {
+      auto signature = std::vector<bool>{};
+      for (const auto& clause : clauses) {
+        signature.push_back(clause.first[b]);
+        signature.push_back(clause.second && (*clause.second)[b]);
+      }
+      const auto [entry, added] = classes.emplace(
+          std::move(signature), std::uint8_t(representatives.size()));
+      if (added)
+        representatives.push_back(b);
+      class_of_[b] = entry->second;
+    }
+    num_classes_ = representatives.size();
+    single_.assign(num_classes_, 0);
+    begin_.assign(num_classes_, 0);
+    pair_.assign(num_classes_ * num_classes_, 0);
+    for (auto i = std::size_t{0}; i < clauses.size(); ++i) {
+      const auto bit = mask_type{1} << i;
+      const auto& clause = clauses[i];
+      for (auto a = std::size_t{0}; a < num_classes_; ++a) {
+        if (!clause.first[representatives[a]])
+          continue;
+        if (clause.at_begin)
+          begin_[a] |= bit;
+        else if (!clause.second)
+          single_[a] |= bit;
+        else
+          for (auto b = std::size_t{0}; b < num_classes_; ++b)
+            if ((*clause.second)[representatives[b]])
+              pair_[a * num_classes_ + b] |= bit;
+      }
+    }
+    for (auto required : required_)
+      all_ |= required;
+    for (auto a = std::size_t{0}; a < num_classes_; ++a)
+      for (auto b = std::size_t{0}; b < num_classes_; ++b)
+        pair_[a * num_classes_ + b] |= single_[b];
+  }
+
+  // The clauses the line satisfies
+  mask_type scan(std::string_view line) const {
+    if (line.empty() || num_classes_ == 0)
+      return 0;
+    auto prev = std::size_t(class_of_[static_cast<unsigned char>(line[0])]);
+    auto mask = begin_[prev] | single_[prev];
+    for (auto i = std::size_t{1}; i < line.size() && mask != all_; ++i) {
+      const auto cur =
+          std::size_t(class_of_[static_cast<unsigned char>(line[i])]);
+      mask |= pair_[prev * num_classes_ + cur];
+      prev = cur;
+    }
+    return mask;
+  }
+
+  // Whether the filter may match a line with the clauses found
+  bool may_match(std::size_t filter, mask_type mask) const {
+    return filter >= required_.size() ||
+           (mask & required_[filter]) == required_[filter];
+  }
+
+private:
+  std::array<std::uint8_t, 256> class_of_{};
+  std::size_t num_classes_{0};
+  std::vector<mask_type> single_;
+  std::vector<mask_type> begin_;
+  std::vector<mask_type> pair_;
+  std::vector<mask_type> required_;
+  mask_type all_{0};
+};
+} // namespace flt::parameter_filter
+
+#endif
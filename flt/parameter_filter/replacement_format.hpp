@@ -0,0 +1,106 @@
+#ifndef FLT_PARAMETER_FILTER_REPLACEMENT_FORMAT_HPP
+#define FLT_PARAMETER_FILTER_REPLACEMENT_FORMAT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+// A format string of match_results::format with the default ECMAScript rules,
+// parsed once into literals and references to groups, the prefix and the
+// suffix of a match
+template <typename StringType = std::string> class replacement_format {
+public:
+  static constexpr auto prefix_ref = std::size_t(-1);
+  static constexpr auto suffix_ref = std::size_t(-2);
+
+  // References to groups from num_groups on expand to nothing and are dropped
+  replacement_format(const StringType& fmt, std::size_t num_groups) {
+    const auto dollar = typename StringType::value_type('$');
+    const auto is_digit = [](auto c) { return c >= '0' && c <= '9'; };
+    for (auto i = std::size_t{0}; i < fmt.size(); ++i) {
+      if (fmt[i] != dollar || i + 1 == fmt.size()) {
+        add_literal(fmt[i]);
+        continue;
+      }
+      const auto next = fmt[++i];
+      if (next == dollar) {
+        add_literal(dollar);
+      } else if (next == '&') {
+        ops_.push_back({0, 0, 0});
+      } else if (next == '`') {
+        ops_.push_back({prefix_ref, 0, 0});
+      } else if (next == '\'') {
+        ops_.push_back({suffix_ref, 0, 0});
+      } else if (is_digit(next)) {
+        auto num = std::size_t(next - '0');
+        if (i + 1 < fmt.size() && is_digit(fmt[i + 1]))
+          num = num * 10 + std::size_t(fmt[++i] - '0');
+        if (num < num_groups)
+          ops_.push_back({num, 0, 0});
+      } else {
+        add_literal(dollar);
+        --i;
+      }
+    }
+  }
+
+  // Appends the expansion to out, append_ref(ref, out) appends group ref or
+  // the prefix or suffix
+  template <typename OutString, typename AppendRef>
+  void append(OutString& out, AppendRef append_ref) const {
+    for (const auto& op : ops_) {
+      if (op.ref == literal_ref)
+        out.append(literals_.data() + op.begin, op.end - op.begin);
+      else
+        append_ref(op.ref, out);
+    }
+  }
+
+  // The smallest range covering the references that matched, range_of(ref)
+  // gives the range of group ref or the prefix or suffix as a pair of
+  // positions, which are npos if it didn't match. An empty range at position
+  // at if none did.
+  template <typename RangeOf>
+  std::pair<std::size_t, std::size_t> extent(RangeOf range_of,
+                                             std::size_t at) const {
+    auto res = std::pair{std::size_t(-1), std::size_t{0}};
+    for (const auto& op : ops_) {
+      if (op.ref == literal_ref)
+        continue;
+      const auto [begin, end] = range_of(op.ref);
+      if (begin == std::size_t(-1))
+        continue;
+      res.first = std::min(res.first, begin);
+      res.second = std::max(res.second, end);
+    }
+    if (res.first == std::size_t(-1))
+      return {at, at};
+    return res;
+  }
+
+private:
+  static constexpr auto literal_ref = std::size_t(-3);
+
+  struct op {
+    std::size_t ref;
+    // The range of a literal in literals_
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  void add_literal(typename StringType::value_type c) {
+    if (ops_.empty() || ops_.back().ref != literal_ref)
+      ops_.push_back({literal_ref, literals_.size(), literals_.size()});
+    literals_.push_back(c);
+    ++ops_.back().end;
+  }
+
+  StringType literals_;
+  std::vector<op> ops_;
+};
+} // namespace flt::parameter_filter
+
+#endif
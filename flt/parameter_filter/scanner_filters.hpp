@@ -0,0 +1,732 @@
+#ifndef FLT_PARAMETER_FILTER_SCANNER_FILTERS_HPP
+#define FLT_PARAMETER_FILTER_SCANNER_FILTERS_HPP
+
+#include <flt/parameter_filter/param_spans.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+#include <flt/parameter_filter/replacement_format.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) && __has_include(<emmintrin.h>)
+#define FLT_PARAMETER_FILTER_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Hand-written scanners for the simple patterns of common_regex_filters.
+// Each scanner finds the same matches as std::regex does for its pattern,
+// i.e. tries the alternatives and quantifiers in the same order, for the
+// classic locale the regexes use unless the global locale is changed.
+namespace flt::parameter_filter {
+// Begin and end of the match and its capture groups in the line, groups
+// that didn't participate are npos
+struct scan_match {
+  static constexpr auto npos = std::string_view::npos;
+  std::array<std::pair<std::size_t, std::size_t>, 3> groups{
+      {{npos, npos}, {npos, npos}, {npos, npos}}};
+};
+
+namespace detail {
+enum char_class : std::uint8_t {
+  digit_class = 1,
+  xdigit_class = 2,
+  word_class = 4,
+  space_class = 8
+};
+
+constexpr std::array<std::uint8_t, 256> make_char_classes() {
+  auto classes = std::array<std::uint8_t, 256>{};
+  for (auto c = 0; c < 256; ++c) {
+    const auto digit = c >= '0' && c <= '9';
+    const auto lower = c >= 'a' && c <= 'z';
+    const auto upper = c >= 'A' && c <= 'Z';
+    classes[std::size_t(c)] = std::uint8_t(
+        (digit ? digit_class : 0) |
+        (digit || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')
+             ? xdigit_class
+             : 0) |
+        (digit || lower || upper || c == '_' ? word_class : 0) |
+        (c == ' ' || (c >= '\t' && c <= '\r') ? space_class : 0));
+  }
+  return classes;
+}
+
+inline constexpr auto char_classes = make_char_classes();
+
+// Out of range positions belong to no class
+inline bool is(std::string_view line, std::size_t pos, char_class cls) {
+  return pos < line.size() &&
+         (char_classes[static_cast<unsigned char>(line[pos])] & cls) != 0;
+}
+
+inline bool is_char(std::string_view line, std::size_t pos, char c) {
+  return pos < line.size() && line[pos] == c;
+}
+
+// Case insensitive for letters given in lower case
+inline bool is_nocase(std::string_view line, std::size_t pos, char lower) {
+  return pos < line.size() && (line[pos] | 0x20) == lower;
+}
+
+// \b, the line before pos is looked at as regex_iterator does
+inline bool word_boundary(std::string_view line, std::size_t pos) {
+  return (pos > 0 && is(line, pos - 1, word_class)) !=
+         is(line, pos, word_class);
+}
+
+inline std::size_t run_of(std::string_view line, std::size_t pos,
+                          char_class cls) {
+  auto end = pos;
+  while (is(line, end, cls))
+    ++end;
+  return end - pos;
+}
+
+// Position of the next digit at or after pos, the size of the line if none
+inline std::size_t find_digit(std::string_view line, std::size_t pos) {
+#ifdef FLT_PARAMETER_FILTER_HAVE_SSE2
+  // Bytes b with '0' <= b <= '9' are those with b - '0' < 10 unsigned, which
+  // is b - ('0' + 128) < 10 - 128 signed
+  const auto offset = _mm_set1_epi8(char('0' + 128));
+  const auto limit = _mm_set1_epi8(char(10 - 128));
+  for (; pos + 16 <= line.size(); pos += 16) {
+    const auto bytes = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(line.data() + pos));
+    const auto digits =
+        _mm_cmplt_epi8(_mm_sub_epi8(bytes, offset), limit);
+    if (const auto mask = unsigned(_mm_movemask_epi8(digits)); mask != 0)
+      return pos + unsigned(__builtin_ctz(mask));
+  }
+#endif
+  while (pos < line.size() && !is(line, pos, digit_class))
+    ++pos;
+  return pos;
+}
+
+// Next position at or after pos where a match beginning with a digit after
+// a word boundary may start
+inline std::size_t next_number(std::string_view line, std::size_t pos) {
+  for (pos = find_digit(line, pos); pos < line.size();
+       pos = find_digit(line, pos)) {
+    if (pos == 0 || !is(line, pos - 1, word_class))
+      return pos;
+    pos += run_of(line, pos, word_class);
+  }
+  return line.size();
+}
+
+// \d+(?:\.\d+)?\s* at pos, whose backtracking never changes the result as
+// the next byte can't continue the shorter alternatives. Returns the end
+// or npos.
+inline std::size_t decimal_and_spaces(std::string_view line, std::size_t pos) {
+  const auto num_digits = run_of(line, pos, digit_class);
+  if (num_digits == 0)
+    return std::string_view::npos;
+  pos += num_digits;
+  if (is_char(line, pos, '.') && is(line, pos + 1, digit_class))
+    pos += 1 + run_of(line, pos + 1, digit_class);
+  return pos + run_of(line, pos, space_class);
+}
+
+inline void set_match(scan_match& match, std::size_t begin, std::size_t end) {
+  match.groups[0] = {begin, end};
+}
+
+// Scanners of numbers give the format of their values
+template <typename Scanner, typename = void>
+struct has_value_format : std::false_type {};
+template <typename Scanner>
+struct has_value_format<Scanner, std::void_t<decltype(Scanner::values)>>
+    : std::true_type {};
+} // namespace detail
+
+namespace scanners {
+// \b0x[[:xdigit:]]+\b
+struct hexadec_constant {
+  static constexpr std::string_view pattern{R"(\b0x[[:xdigit:]]+\b)"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 1;
+  static constexpr auto values = value_format::hexadecimal;
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (pos = line.find("0x", pos); pos != std::string_view::npos;
+         pos = line.find("0x", pos + 1)) {
+      if (!word_boundary(line, pos))
+        continue;
+      const auto num_digits = run_of(line, pos + 2, xdigit_class);
+      const auto end = pos + 2 + num_digits;
+      if (num_digits > 0 && !is(line, end, word_class)) {
+        set_match(match, pos, end);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// \b\d{2}<sep>\d{2}<sep>\d{2}\b
+template <char Sep> struct two_digit_triple {
+  static constexpr std::size_t num_groups = 1;
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (pos = next_number(line, pos); pos + 8 <= line.size();
+         pos = next_number(line, pos + 1)) {
+      if (is(line, pos + 1, digit_class) && line[pos + 2] == Sep &&
+          is(line, pos + 3, digit_class) && is(line, pos + 4, digit_class) &&
+          line[pos + 5] == Sep && is(line, pos + 6, digit_class) &&
+          is(line, pos + 7, digit_class) && !is(line, pos + 8, word_class)) {
+        set_match(match, pos, pos + 8);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+struct time : two_digit_triple<':'> {
+  static constexpr std::string_view pattern{R"(\b\d{2}:\d{2}:\d{2}\b)"};
+  static constexpr bool icase = false;
+};
+
+struct date : two_digit_triple<'/'> {
+  static constexpr std::string_view pattern{R"(\b\d{2}/\d{2}/\d{2}\b)"};
+  static constexpr bool icase = false;
+};
+
+// \b(?:[[:xdigit:]]{2}[:-]){5}[[:xdigit:]]{2}\b
+struct mac_address {
+  static constexpr std::string_view pattern{
+      R"(\b(?:[[:xdigit:]]{2}[:-]){5}[[:xdigit:]]{2}\b)"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 1;
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (; pos + 17 <= line.size(); ++pos) {
+      if (!is(line, pos, xdigit_class) || !word_boundary(line, pos))
+        continue;
+      auto end = pos;
+      for (auto i = 0; i < 6 && end != std::string_view::npos; ++i) {
+        if (!is(line, end, xdigit_class) || !is(line, end + 1, xdigit_class))
+          end = std::string_view::npos;
+        else if (i < 5 && !is_char(line, end + 2, ':') &&
+                 !is_char(line, end + 2, '-'))
+          end = std::string_view::npos;
+        else
+          end += i < 5 ? 3 : 2;
+      }
+      if (end != std::string_view::npos && !is(line, end, word_class)) {
+        set_match(match, pos, end);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// \b\{?[[:xdigit:]]{8}-(?:[[:xdigit:]]{4}-){3}[[:xdigit:]]{12}\}?\b
+struct UUID {
+  static constexpr std::string_view pattern{
+      R"(\b\{?[[:xdigit:]]{8}-(?:[[:xdigit:]]{4}-){3}[[:xdigit:]]{12}\}?\b)"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 1;
+
+  static bool body_at(std::string_view line, std::size_t pos) {
+    using namespace detail;
+    for (auto len : {8, 4, 4, 4, 12}) {
+      if (run_of(line, pos, xdigit_class) < std::size_t(len))
+        return false;
+      pos += std::size_t(len);
+      if (len != 12 && !is_char(line, pos++, '-'))
+        return false;
+    }
+    return true;
+  }
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (; pos + 36 <= line.size(); ++pos) {
+      if (!word_boundary(line, pos))
+        continue;
+      // \{? only fits a brace, without it the body has to begin here
+      const auto brace = line[pos] == '{';
+      const auto body = pos + brace;
+      if (!body_at(line, body))
+        continue;
+      const auto end = body + 36;
+      if (is_char(line, end, '}') && word_boundary(line, end + 1)) {
+        set_match(match, pos, end + 1);
+        return true;
+      }
+      if (word_boundary(line, end)) {
+        set_match(match, pos, end);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// \b(?:<octet>\.){3}<octet>(?::\d{1,5})?\b with the octet
+// 25[0-5]|2[0-4]?[0-9]?|1\d{0,2}|[1-9][0-9]?|0
+struct ipv4_address {
+  static constexpr std::string_view pattern{
+      R"(\b(?:(?:25[0-5]|2[0-4]?[0-9]?|1\d{0,2}|[1-9][0-9]?|0)\.){3}(?:25[0-5]|2[0-4]?[0-9]?|1\d{0,2}|[1-9][0-9]?|0)(?::\d{1,5})?\b)"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 1;
+
+  // The lengths the octet alternatives match at pos, in the order they are
+  // tried
+  static std::size_t octet_lengths(std::string_view line, std::size_t pos,
+                                   std::array<std::size_t, 10>& lengths) {
+    using namespace detail;
+    const auto digit_at = [&](std::size_t i, char low, char high) {
+      return pos + i < line.size() && line[pos + i] >= low &&
+             line[pos + i] <= high;
+    };
+    auto num = std::size_t{0};
+    if (digit_at(0, '2', '2') && digit_at(1, '5', '5') && digit_at(2, '0', '5'))
+      lengths[num++] = 3;
+    if (digit_at(0, '2', '2')) {
+      if (digit_at(1, '0', '4')) {
+        if (digit_at(2, '0', '9'))
+          lengths[num++] = 3;
+        lengths[num++] = 2;
+      }
+      if (digit_at(1, '0', '9'))
+        lengths[num++] = 2;
+      lengths[num++] = 1;
+    }
+    if (digit_at(0, '1', '1')) {
+      const auto num_digits = std::min<std::size_t>(
+          run_of(line, pos + 1, digit_class), 2);
+      for (auto i = num_digits + 1; i > 0; --i)
+        lengths[num++] = i;
+    }
+    if (digit_at(0, '1', '9')) {
+      if (digit_at(1, '0', '9'))
+        lengths[num++] = 2;
+      lengths[num++] = 1;
+    }
+    if (digit_at(0, '0', '0'))
+      lengths[num++] = 1;
+    return num;
+  }
+
+  // End of the octets from the index-th on at pos and the port, or npos
+  static std::size_t rest_at(std::string_view line, std::size_t pos,
+                             int index) {
+    using namespace detail;
+    auto lengths = std::array<std::size_t, 10>{};
+    const auto num = octet_lengths(line, pos, lengths);
+    for (auto i = std::size_t{0}; i < num; ++i) {
+      const auto end = pos + lengths[i];
+      if (index < 3) {
+        if (!is_char(line, end, '.'))
+          continue;
+        if (const auto rest = rest_at(line, end + 1, index + 1);
+            rest != std::string_view::npos)
+          return rest;
+        continue;
+      }
+      if (is_char(line, end, ':')) {
+        const auto num_digits =
+            std::min<std::size_t>(run_of(line, end + 1, digit_class), 5);
+        for (auto port = num_digits; port > 0; --port)
+          if (!is(line, end + 1 + port, word_class))
+            return end + 1 + port;
+      }
+      if (!is(line, end, word_class))
+        return end;
+    }
+    return std::string_view::npos;
+  }
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (pos = next_number(line, pos); pos < line.size();
+         pos = next_number(line, pos + 1)) {
+      if (const auto end = rest_at(line, pos, 0);
+          end != std::string_view::npos) {
+        set_match(match, pos, end);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// (^|[[:space:](=/\\'"%#@:.])(-?\d+)(?=[[:space:])/\\'",%#@:]|$)
+struct number_constant {
+  static constexpr std::string_view pattern{
+      R"((^|[[:space:](=/\\'"%#@:.])(-?\d+)(?=[[:space:])/\\'",%#@:]|$))"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 3;
+  static constexpr auto values = value_format::decimal;
+
+  static bool is_before(std::string_view line, std::size_t pos) {
+    if (detail::is(line, pos, detail::space_class))
+      return true;
+    return pos < line.size() &&
+           std::strchr("(=/\\'\"%#@:.", line[pos]) != nullptr &&
+           line[pos] != '\0';
+  }
+
+  static bool is_after(std::string_view line, std::size_t pos) {
+    if (pos == line.size() || detail::is(line, pos, detail::space_class))
+      return true;
+    return std::strchr(")/\\'\",%#@:", line[pos]) != nullptr &&
+           line[pos] != '\0';
+  }
+
+  // End of -?\d+ at pos followed by the lookahead, or npos. Shorter digit
+  // runs are followed by a digit, which the lookahead doesn't accept.
+  static std::size_t number_at(std::string_view line, std::size_t pos) {
+    using namespace detail;
+    const auto start = pos + is_char(line, pos, '-');
+    const auto num_digits = run_of(line, start, digit_class);
+    if (num_digits == 0 || !is_after(line, start + num_digits))
+      return std::string_view::npos;
+    return start + num_digits;
+  }
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    if (pos == 0) {
+      if (const auto end = number_at(line, 0); end != std::string_view::npos) {
+        match.groups = {{{0, end}, {0, 0}, {0, end}}};
+        return true;
+      }
+    }
+    for (; pos + 1 < line.size(); ++pos) {
+      // The number begins with a digit or '-'
+      const auto next = line[pos + 1];
+      if (next != '-' && (next < '0' || next > '9'))
+        continue;
+      if (!is_before(line, pos))
+        continue;
+      if (const auto end = number_at(line, pos + 1);
+          end != std::string_view::npos) {
+        match.groups = {{{pos, end}, {pos, pos + 1}, {pos + 1, end}}};
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// \b-?\d+(?:\.\d+)?\s*(?:ms|s|seconds?)\b
+struct time_duration {
+  static constexpr std::string_view pattern{
+      R"(\b-?\d+(?:\.\d+)?\s*(?:ms|s|seconds?)\b)"};
+  static constexpr bool icase = false;
+  static constexpr std::size_t num_groups = 1;
+
+  static std::size_t rest_at(std::string_view line, std::size_t pos) {
+    using namespace detail;
+    const auto unit = decimal_and_spaces(line, pos);
+    if (unit == std::string_view::npos)
+      return unit;
+    const auto ends = [&](std::string_view suffix) {
+      return line.substr(unit, suffix.size()) == suffix &&
+             !is(line, unit + suffix.size(), word_class);
+    };
+    for (auto suffix : {"ms", "s", "seconds", "second"})
+      if (ends(suffix))
+        return unit + std::strlen(suffix);
+    return std::string_view::npos;
+  }
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    while (pos < line.size()) {
+      // A minus can only start a match after a word
+      const auto number = next_number(line, pos);
+      const auto minus = line.find('-', pos);
+      if (minus < number) {
+        if (word_boundary(line, minus))
+          if (const auto end = rest_at(line, minus + 1);
+              end != std::string_view::npos) {
+            set_match(match, minus, end);
+            return true;
+          }
+        pos = minus + 1;
+        continue;
+      }
+      if (number == line.size())
+        break;
+      if (const auto end = rest_at(line, number);
+          end != std::string_view::npos) {
+        set_match(match, number, end);
+        return true;
+      }
+      pos = number + 1;
+    }
+    return false;
+  }
+};
+
+// \b\d+(?:\.\d+)?\s*[MKGTP]?i?B\b, case insensitive
+struct data_size {
+  static constexpr std::string_view pattern{
+      R"(\b\d+(?:\.\d+)?\s*[MKGTP]?i?B\b)"};
+  static constexpr bool icase = true;
+  static constexpr std::size_t num_groups = 1;
+
+  static std::size_t rest_at(std::string_view line, std::size_t pos) {
+    using namespace detail;
+    const auto unit = decimal_and_spaces(line, pos);
+    if (unit == std::string_view::npos)
+      return unit;
+    const auto prefix =
+        is_nocase(line, unit, 'm') || is_nocase(line, unit, 'k') ||
+        is_nocase(line, unit, 'g') || is_nocase(line, unit, 't') ||
+        is_nocase(line, unit, 'p');
+    // [MKGTP]? and i? are tried taken first
+    for (auto with_prefix : {true, false}) {
+      if (with_prefix && !prefix)
+        continue;
+      const auto i_pos = unit + with_prefix;
+      for (auto with_i : {true, false}) {
+        if (with_i && !is_nocase(line, i_pos, 'i'))
+          continue;
+        const auto b_pos = i_pos + with_i;
+        if (is_nocase(line, b_pos, 'b') && !is(line, b_pos + 1, word_class))
+          return b_pos + 1;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (pos = next_number(line, pos); pos < line.size();
+         pos = next_number(line, pos + 1))
+      if (const auto end = rest_at(line, pos); end != std::string_view::npos) {
+        set_match(match, pos, end);
+        return true;
+      }
+    return false;
+  }
+};
+
+// \b\d+(?:\.\d+)?\s*[GKM]\b, case insensitive
+struct linux_mem_size {
+  static constexpr std::string_view pattern{R"(\b\d+(?:\.\d+)?\s*[GKM]\b)"};
+  static constexpr bool icase = true;
+  static constexpr std::size_t num_groups = 1;
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    using namespace detail;
+    for (pos = next_number(line, pos); pos < line.size();
+         pos = next_number(line, pos + 1)) {
+      const auto unit = decimal_and_spaces(line, pos);
+      if ((is_nocase(line, unit, 'g') || is_nocase(line, unit, 'k') ||
+           is_nocase(line, unit, 'm')) &&
+          !is(line, unit + 1, word_class)) {
+        set_match(match, pos, unit + 1);
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// <Open>.*?<Close>, . matching anything but line terminators
+template <char Open, char Close> struct bracketed {
+  static constexpr std::size_t num_groups = 1;
+
+  bool find(std::string_view line, std::size_t pos, scan_match& match) const {
+    for (pos = line.find(Open, pos); pos != std::string_view::npos;
+         pos = line.find(Open, pos + 1)) {
+      for (auto end = pos + 1; end < line.size(); ++end) {
+        if (line[end] == Close) {
+          detail::set_match(match, pos, end + 1);
+          return true;
+        }
+        if (line[end] == '\n' || line[end] == '\r')
+          break;
+      }
+    }
+    return false;
+  }
+};
+
+struct square_bracket : bracketed<'[', ']'> {
+  static constexpr std::string_view pattern{R"(\[.*?\])"};
+  static constexpr bool icase = false;
+};
+
+struct pointed_bracket : bracketed<'<', '>'> {
+  static constexpr std::string_view pattern{R"(<.*?>)"};
+  static constexpr bool icase = false;
+};
+} // namespace scanners
+
+// Replaces and extracts the matches of a scanner like regex_filter does for
+// the regex the scanner implements, with the same format strings
+template <typename Scanner, typename StringType = std::string>
+class scanner_filter {
+public:
+  scanner_filter(StringType replacement_str = StringType{"$$v"},
+                 StringType extraction_str = StringType{"$&"})
+      : replacement_(replacement_str, Scanner::num_groups),
+        extraction_(extraction_str, Scanner::num_groups) {}
+
+  template <typename OutIt, typename T>
+  auto operator()(const T& line_str, OutIt output_cont) const {
+    return apply_filter(line_str, output_cont);
+  }
+
+  template <typename T> auto operator()(const T& line_str) const {
+    return apply_filter(line_str, nullptr);
+  }
+
+  // Like regex_filter::filter_into
+  template <typename T, typename Its>
+  bool filter_into(const T& line_str, T& res_str, Its output_it) const {
+    return filter_matches(line_str, res_str, output_it, nullptr);
+  }
+
+  // Like regex_filter::filter_edits
+  template <typename T>
+  bool filter_edits(const T& line_str, T& res_str,
+                    std::vector<filter_edit>& edits) const {
+    return filter_matches(line_str, res_str, nullptr, &edits);
+  }
+
+  const std::vector<screen_clause>& screen() const { return screen_; }
+
+  // How the parameters are parsed into values
+  static constexpr value_format values() {
+    if constexpr (detail::has_value_format<Scanner>::value)
+      return Scanner::values;
+    else
+      return value_format::text;
+  }
+
+protected:
+  using format_type = replacement_format<StringType>;
+
+  template <typename T, typename Its>
+  bool filter_matches(const T& line_str, T& res_str,
+                      [[maybe_unused]] Its output_it,
+                      std::vector<filter_edit>* edits) const {
+    const auto line = std::string_view{line_str};
+    auto match = scan_match{};
+    if (!scanner_.find(line, 0, match))
+      return false;
+    res_str.clear();
+    auto prefix_begin = std::size_t{0};
+    const auto append_ref = [&](std::size_t ref, T& out) {
+      auto [begin, end] = ref == format_type::prefix_ref
+                              ? std::pair{prefix_begin, match.groups[0].first}
+                          : ref == format_type::suffix_ref
+                              ? std::pair{match.groups[0].second, line.size()}
+                              : match.groups[ref];
+      if (begin != scan_match::npos)
+        out.append(line.data() + begin, end - begin);
+    };
+    do {
+      const auto [begin, end] = match.groups[0];
+      res_str.append(line.data() + prefix_begin, begin - prefix_begin);
+      if constexpr (!std::is_same_v<Its, std::nullptr_t>) {
+        auto extr_str = T{};
+        extraction_.append(extr_str, append_ref);
+        *output_it = std::move(extr_str);
+        ++output_it;
+      }
+      const auto out_begin = res_str.size();
+      replacement_.append(res_str, append_ref);
+      if (edits) {
+        const auto param = extraction_.extent(
+            [&](std::size_t ref) {
+              return ref == format_type::prefix_ref
+                         ? std::pair{prefix_begin, begin}
+                     : ref == format_type::suffix_ref
+                         ? std::pair{end, line.size()}
+                         : match.groups[ref];
+            },
+            begin);
+        edits->push_back(
+            {begin, end, out_begin, res_str.size(), param.first, param.second});
+      }
+      prefix_begin = end;
+    } while (scanner_.find(line, prefix_begin, match));
+    res_str.append(line.data() + prefix_begin, line.size() - prefix_begin);
+    return true;
+  }
+
+  template <typename T, typename Its>
+  auto apply_filter(const T& line_str, Its output_it) const {
+    auto res_str = T{};
+    if (!filter_into(line_str, res_str, output_it))
+      return line_str;
+    return res_str;
+  }
+
+  const Scanner scanner_{};
+  const format_type replacement_;
+  const format_type extraction_;
+  const std::vector<screen_clause> screen_{
+      regex_screen(Scanner::pattern, Scanner::icase)};
+};
+
+// Drop-in replacements for the filters of the same names in regex_filters
+namespace scanner_filters {
+using namespace std::literals::string_literals;
+
+inline auto pointed_bracket_filter() {
+  return scanner_filter<scanners::pointed_bracket>("<$$v>"s);
+}
+
+inline auto square_bracket_filter() {
+  return scanner_filter<scanners::square_bracket>("[$$v]"s);
+}
+
+inline auto hexadec_constant_filter() {
+  return scanner_filter<scanners::hexadec_constant>();
+}
+
+inline auto mac_address_filter() {
+  return scanner_filter<scanners::mac_address>();
+}
+
+inline auto ipv4_address_filter() {
+  return scanner_filter<scanners::ipv4_address>();
+}
+
+inline auto time_duration_filter() {
+  return scanner_filter<scanners::time_duration>();
+}
+
+inline auto data_size_filter() {
+  return scanner_filter<scanners::data_size>();
+}
+
+inline auto UUID_filter() { return scanner_filter<scanners::UUID>(); }
+
+inline auto number_constant_filter() {
+  return scanner_filter<scanners::number_constant>("$1$$v"s, "$2"s);
+}
+
+inline auto time_filter() { return scanner_filter<scanners::time>(); }
+
+inline auto date_filter() { return scanner_filter<scanners::date>(); }
+
+inline auto linux_mem_size_filter() {
+  return scanner_filter<scanners::linux_mem_size>();
+}
+} // namespace scanner_filters
+} // namespace flt::parameter_filter
+
+#endif
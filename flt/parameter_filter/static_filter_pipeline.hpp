@@ -0,0 +1,142 @@
+#ifndef FLT_PARAMETER_FILTER_STATIC_FILTER_PIPELINE_HPP
+#define FLT_PARAMETER_FILTER_STATIC_FILTER_PIPELINE_HPP
+
+#include <flt/parameter_filter/filter_array.hpp>
+#include <flt/parameter_filter/param_spans.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+
+#include <cstddef>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace flt::parameter_filter {
+// Like filter_array for filters known at compile time, which are stored in
+// place and called without virtual dispatch. The filters are applied in the
+// order they are given.
+template <typename... Filters> class static_filter_pipeline {
+public:
+  static_filter_pipeline(Filters... filters)
+      : filters_(std::move(filters)...),
+        screen_(std::apply(
+            [](const auto&... filts) {
+              return multi_screen{
+                  std::vector<std::vector<screen_clause>>{screen_of(filts)...}};
+            },
+            filters_)) {}
+
+  template <typename T, typename OutIt>
+  T operator()(const T& line_str, OutIt outit) const {
+    auto res_str = T{};
+    filter_into(line_str, res_str, outit);
+    return res_str;
+  }
+
+  template <typename T> T operator()(const T& line_str) const {
+    auto res_str = T{};
+    filter_into(line_str, res_str);
+    return res_str;
+  }
+
+  // Like filter_array::filter_into, parameters are extracted unless outit is
+  // nullptr
+  template <typename T, typename OutIt = std::nullptr_t>
+  bool filter_into(const T& line_str, T& res_str, OutIt outit = nullptr) const {
+    return apply(line_str, res_str,
+                 [&](const auto& filt, const T& in, T& out, std::size_t) {
+                   return filter_one(filt, in, out, outit);
+                 });
+  }
+
+  // Like filter_array::filter_spans
+  template <typename T>
+  bool filter_spans(const T& line_str, T& res_str, param_spans& spans) const {
+    thread_local auto recorder = detail::span_recorder{};
+    recorder.start(line_str.size());
+    return apply(line_str, res_str,
+                 [&](const auto& filt, const T& in, T& out,
+                     std::size_t filt_i) {
+                   if (!detail::filter_edits(filt, in, out, recorder.edits()))
+                     return false;
+                   recorder.record(filt_i, in, out.size(),
+                                   detail::values_of(filt), spans);
+                   return true;
+                 });
+  }
+
+  static constexpr std::size_t size() { return sizeof...(Filters); }
+
+private:
+  template <typename FilterT>
+  static std::vector<screen_clause> screen_of(const FilterT& filt) {
+    if constexpr (detail::has_screen<FilterT>::value)
+      return filt.screen();
+    else
+      return {};
+  }
+
+  // Like filter_array::apply
+  template <typename T, typename ApplyFilter>
+  bool apply(const T& line_str, T& res_str, ApplyFilter apply_filter) const {
+    thread_local auto scratch = T{};
+    const T* filtered = &line_str;
+    auto matched = false;
+    auto mask = scan(line_str);
+    for_each_filter(
+        [&](const auto& filt, std::size_t filt_i) {
+          if (!screen_.may_match(filt_i, mask))
+            return;
+          auto& out = filtered == &res_str ? scratch : res_str;
+          if (apply_filter(filt, *filtered, out, filt_i)) {
+            filtered = &out;
+            matched = true;
+            mask = scan(out);
+          }
+        },
+        std::index_sequence_for<Filters...>{});
+    if (filtered == &scratch)
+      res_str.swap(scratch);
+    else if (filtered != &res_str)
+      res_str = line_str;
+    return matched;
+  }
+
+  template <typename Visit, std::size_t... I>
+  void for_each_filter(Visit visit, std::index_sequence<I...>) const {
+    (visit(std::get<I>(filters_), I), ...);
+  }
+
+  template <typename FilterT, typename T, typename OutIt>
+  static bool filter_one(const FilterT& filt, const T& line_str, T& res_str,
+                         OutIt outit) {
+    if constexpr (detail::has_filter_into<FilterT, T, OutIt>::value) {
+      return filt.filter_into(line_str, res_str, outit);
+    } else {
+      auto filtered = [&] {
+        if constexpr (std::is_same_v<OutIt, std::nullptr_t>)
+          return filt(line_str);
+        else
+          return filt(line_str, outit);
+      }();
+      if (filtered == line_str)
+        return false;
+      res_str = std::move(filtered);
+      return true;
+    }
+  }
+
+  template <typename T> multi_screen::mask_type scan(const T& line_str) const {
+    if constexpr (std::is_convertible_v<const T&, std::string_view>)
+      return screen_.scan(line_str);
+    else
+      return ~multi_screen::mask_type{0};
+  }
+
+  const std::tuple<Filters...> filters_;
+  const multi_screen screen_;
+};
+} // namespace flt::parameter_filter
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef FLT_STRING_TOKEN_DICTIONARY_HPP
+#define FLT_STRING_TOKEN_DICTIONARY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace flt::string::dictionary {
+// Append-only store of distinct tokens. Interned tokens are views into
+// storage owned by the dictionary, they stay valid until the dictionary is
+// destroyed, also if the dictionary is moved. Not thread safe.
+template <typename M> class token_dictionary {
+public:
+  using char_type = typename M::value_type;
+  using view_type = std::basic_string_view<char_type, typename M::traits_type>;
+
+  explicit token_dictionary(std::size_t chunk_size = 64 * 1024)
+      : chunk_size_(chunk_size) {}
+
+  view_type intern(view_type token) {
+    auto interned = tokens_.find(token);
+    if (interned != tokens_.end())
+      return *interned;
+    return *tokens_.insert(store(token)).first;
+  }
+
+  // Returns an empty view if the token was never interned.
+  view_type find(view_type token) const {
+    auto interned = tokens_.find(token);
+    return interned != tokens_.end() ? *interned : view_type{};
+  }
+
+  std::size_t size() const { return tokens_.size(); }
+
+  // Approximate number of bytes allocated by the dictionary
+  std::size_t memory_usage() const {
+    return sizeof(*this) + chunks_allocated_ * sizeof(char_type) +
+           chunks_.capacity() * sizeof(std::unique_ptr<char_type[]>) +
+           tokens_.bucket_count() * sizeof(void*) +
+           tokens_.size() * (sizeof(view_type) + 2 * sizeof(void*));
+  }
+
+private:
+  view_type store(view_type token) {
+    if (token.empty())
+      return view_type{};
+    if (token.size() > chunk_capacity_ - chunk_used_) {
+      chunk_capacity_ = std::max(chunk_size_, token.size());
+      chunks_.push_back(std::make_unique<char_type[]>(chunk_capacity_));
+      chunks_allocated_ += chunk_capacity_;
+      chunk_used_ = 0;
+    }
+    auto* stored = chunks_.back().get() + chunk_used_;
+    token.copy(stored, token.size());
+    chunk_used_ += token.size();
+    return view_type{stored, token.size()};
+  }
+
+  std::size_t chunk_size_;
+  std::vector<std::unique_ptr<char_type[]>> chunks_;
+  std::size_t chunks_allocated_{0};
+  // Size and fill level of the last chunk
+  std::size_t chunk_capacity_{0};
+  std::size_t chunk_used_{0};
+  std::unordered_set<view_type> tokens_;
+};
+} // namespace flt::string::dictionary
+
+#endif
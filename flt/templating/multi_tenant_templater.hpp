@@ -0,0 +1,147 @@
+#ifndef FLT_TEMPLATING_MULTI_TENANT_TEMPLATER_HPP
+#define FLT_TEMPLATING_MULTI_TENANT_TEMPLATER_HPP
+
+#include <flt/templating/online_templater.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace flt::templating {
+inline namespace online {
+// Templates the loglines of each tenant, e.g. a host or process tag,
+// separately. All tenants intern their tokens into one shared dictionary, so
+// tokens common to many tenants are stored once.
+template <typename Key, typename M = std::string,
+          typename Hash = std::hash<Key>>
+class multi_tenant_templater {
+public:
+  using templater_type = online_templater<M>;
+  using dictionary_type = typename templater_type::dictionary_type;
+
+  // A tenant_quota of 0 disables eviction. Otherwise, every check_interval
+  // loglines of a tenant, its least recently used templates are evicted until
+  // its memory_usage() is within the quota again.
+  multi_tenant_templater(double threshold = 0.5, bool store_params = false,
+                         std::size_t tenant_quota = 0,
+                         unsigned int check_interval = 1024)
+      : threshold_(threshold), store_params_(store_params),
+        tenant_quota_(tenant_quota), check_interval_(check_interval) {
+    if (check_interval_ == 0)
+      throw std::invalid_argument{"Quota check interval must not be zero"};
+  }
+
+  void ingest(const Key& tenant_key, const M& logline) {
+    auto& tenant = get_tenant(tenant_key);
+    tenant.templater(logline);
+    if (tenant_quota_ != 0 && ++tenant.lines_since_check >= check_interval_) {
+      tenant.lines_since_check = 0;
+      const auto num_evicted = tenant.templater.evict_templs(tenant_quota_);
+      num_evicted_ += num_evicted;
+      if (num_evicted > 0 && dictionary_->size() > min_compaction_size &&
+          dictionary_->size() > 2 * compacted_size_)
+        compact_dictionary();
+    }
+  }
+
+  void operator()(const Key& tenant_key, const M& logline) {
+    ingest(tenant_key, logline);
+  }
+
+  // Creates the tenant if it does not exist yet, e.g. to register callbacks
+  templater_type& tenant(const Key& tenant_key) {
+    return get_tenant(tenant_key).templater;
+  }
+
+  const templater_type* find_tenant(const Key& tenant_key) const {
+    auto tenant = tenants_.find(tenant_key);
+    return tenant != tenants_.end() ? &tenant->second.templater : nullptr;
+  }
+
+  std::size_t num_tenants() const { return tenants_.size(); }
+
+  std::uint64_t num_evicted() const { return num_evicted_; }
+
+  const dictionary_type& dictionary() const { return *dictionary_; }
+
+  // Approximate number of bytes allocated by all tenants and the dictionary
+  std::size_t memory_usage() const {
+    auto bytes = sizeof(*this) + dictionary_->memory_usage() +
+                 tenants_.bucket_count() * sizeof(void*);
+    for (const auto& tenant : tenants_)
+      bytes += sizeof(tenant) + 2 * sizeof(void*) +
+               tenant.second.templater.memory_usage();
+    return bytes;
+  }
+
+  // The dictionary only grows, evicted templates leave their tokens behind.
+  // Compaction rebuilds it from the tokens still referred to. This happens
+  // automatically after evictions once the dictionary doubled in size.
+  void compact_dictionary() {
+    auto compacted = std::make_unique<dictionary_type>();
+    for (auto& tenant : tenants_)
+      tenant.second.templater.reintern(*compacted);
+    dictionary_ = std::move(compacted);
+    compacted_size_ = dictionary_->size();
+  }
+
+  void split_templs() {
+    for (auto& tenant : tenants_)
+      tenant.second.templater.split_templs();
+  }
+
+  std::size_t consolidate_templs(double min_constant_ratio = 0.5) {
+    auto num_merged = std::size_t{0};
+    for (auto& tenant : tenants_)
+      num_merged += tenant.second.templater.consolidate_templs(
+          min_constant_ratio);
+    return num_merged;
+  }
+
+  // Each tenant's templates are preceded by a line with its key.
+  void save_templs(std::ofstream& fout, bool save_params = false) const {
+    for (const auto& tenant : tenants_) {
+      fout << "Tenant: " << tenant.first << '\n';
+      tenant.second.templater.save_templs(fout, save_params);
+    }
+  }
+
+private:
+  struct tenant_state {
+    templater_type templater;
+    unsigned int lines_since_check{0};
+  };
+
+  tenant_state& get_tenant(const Key& tenant_key) {
+    auto tenant = tenants_.find(tenant_key);
+    if (tenant == tenants_.end())
+      tenant = tenants_
+                   .emplace(tenant_key,
+                            tenant_state{templater_type{threshold_,
+                                                        store_params_,
+                                                        *dictionary_}})
+                   .first;
+    return tenant->second;
+  }
+
+  static constexpr std::size_t min_compaction_size = 4096;
+
+  double threshold_;
+  bool store_params_;
+  std::size_t tenant_quota_;
+  unsigned int check_interval_;
+  std::unique_ptr<dictionary_type> dictionary_{
+      std::make_unique<dictionary_type>()};
+  std::size_t compacted_size_{0};
+  std::uint64_t num_evicted_{0};
+  std::unordered_map<Key, tenant_state, Hash> tenants_;
+};
+} // namespace online
+} // namespace flt::templating
+
+#endif
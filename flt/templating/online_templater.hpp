@@ -1,16 +1,31 @@
 #ifndef FLT_TEMPLATING_ONLINE_TEMPLATER_HPP
 #define FLT_TEMPLATING_ONLINE_TEMPLATER_HPP
 
+#include <flt/string/token_dictionary.hpp>
 #include <flt/string/word_iterator.hpp>
+#include <flt/templating/template_events.hpp>
+#include <flt/templating/templater_stats.hpp>
+#include <flt/util/hash_combine.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <istream>
 #include <map>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <regex>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace flt::templating {
@@ -20,20 +35,44 @@ namespace detail {
 class configuration {
   double threshold_;
   bool store_params_;
+#ifdef FLT_TEMPLATER_STATS
+  templater_stats* stats_;
+#endif
 
 public:
-  configuration(double threshold, bool store_params)
-      : threshold_(threshold), store_params_(store_params) {}
+  configuration(double threshold, bool store_params
+#ifdef FLT_TEMPLATER_STATS
+                ,
+                templater_stats* stats
+#endif
+                )
+      : threshold_(threshold), store_params_(store_params)
+#ifdef FLT_TEMPLATER_STATS
+        ,
+        stats_(stats)
+#endif
+  {
+  }
 
   double threshold() const { return threshold_; }
   bool store_params() const { return store_params_; }
+#ifdef FLT_TEMPLATER_STATS
+  templater_stats& stats() const { return *stats_; }
+#endif
 };
 
+#ifdef FLT_TEMPLATER_STATS
+inline auto elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count());
+}
+#endif
+
 std::regex special_chars{R"([^a-zA-Z\d:]|\$v)", std::regex::optimize};
 
 template <typename M> auto is_possible_param(const M& token) {
-  auto results = std::smatch{};
-  return std::regex_search(token, results, special_chars);
+  return std::regex_search(std::begin(token), std::end(token), special_chars);
 }
 
 template <typename M> auto count_tokens(const M& logline) {
@@ -42,24 +81,104 @@ template <typename M> auto count_tokens(const M& logline) {
                        cend_wordwise_special_seps(logline));
 }
 
+// Approximate sizes of the nodes of node based standard containers
+template <typename T>
+constexpr std::size_t tree_node_size = sizeof(T) + 4 * sizeof(void*);
+template <typename T>
+constexpr std::size_t hash_node_size = sizeof(T) + 2 * sizeof(void*);
+
+template <typename Map> std::size_t hash_map_memory_usage(const Map& map) {
+  auto bytes = map.bucket_count() * sizeof(void*) +
+               map.size() * hash_node_size<typename Map::value_type>;
+  for (const auto& node : map)
+    bytes += node.second.memory_usage();
+  return bytes;
+}
+
+// Templater states are written as varints and length prefixed strings
+[[noreturn]] inline void throw_corrupt_state() {
+  throw std::runtime_error{"Corrupt templater state"};
+}
+
+inline void write_varint(std::ostream& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.put(char(value | 0x80));
+    value >>= 7;
+  }
+  out.put(char(value));
+}
+
+inline std::uint64_t read_varint(std::istream& in) {
+  auto value = std::uint64_t{0};
+  for (auto shift = 0u; shift < 64; shift += 7) {
+    const auto byte = in.get();
+    if (byte == std::istream::traits_type::eof())
+      break;
+    value |= std::uint64_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  throw_corrupt_state();
+}
+
+template <typename View> void write_token(std::ostream& out, View token) {
+  using char_type = typename View::value_type;
+  write_varint(out, token.size());
+  out.write(reinterpret_cast<const char*>(token.data()),
+            std::streamsize(token.size() * sizeof(char_type)));
+}
+
+template <typename M> M read_token(std::istream& in) {
+  using char_type = typename M::value_type;
+  const auto size = read_varint(in);
+  auto token = M{};
+  // Read in chunks, a corrupt size must not allocate more than is there
+  for (auto chunk = std::size_t{4096}; token.size() < size;) {
+    const auto offset = token.size();
+    token.resize(offset + std::min<std::uint64_t>(chunk, size - offset));
+    if (!in.read(reinterpret_cast<char*>(token.data() + offset),
+                 std::streamsize((token.size() - offset) *
+                                 sizeof(char_type))))
+      throw_corrupt_state();
+  }
+  return token;
+}
+
+inline constexpr std::string_view state_magic{"FLTSTAT1"};
+
+// State shared by all layers of a templater
+template <typename M> struct templater_context {
+  using dictionary_type = flt::string::dictionary::token_dictionary<M>;
+  template_events<M> events;
+  dictionary_type* dictionary;
+  // Number of loglines seen so far, serves as clock for template recency
+  std::uint64_t tick{0};
+};
+
+// Parameters and token keys are views on tokens interned in the templater's
+// dictionary.
 template <typename M> class templ_node {
+  using dictionary_type = flt::string::dictionary::token_dictionary<M>;
+  using token_type = typename dictionary_type::view_type;
   M templ_;
   configuration config_;
   unsigned int templ_length_;
   using token_pos_type = unsigned int;
-  std::map<token_pos_type, std::set<M>> params_;
+  std::map<token_pos_type, std::set<token_type>> params_;
 
   bool templ_was_split_{false};
   M wildcard_{"<*>"};
-  using param_table_entry = std::map<token_pos_type, M>;
+  using param_table_entry = std::map<token_pos_type, token_type>;
   std::set<param_table_entry> param_table_{};
   std::set<token_pos_type> token_positions_with_max_num_tokens_exceeded_{};
   unsigned int max_param_table_entries_{500};
+  template_id id_{0};
+  std::uint64_t last_used_{0};
 
 public:
   templ_node(M templ, const configuration& config,
-             std::map<unsigned int, std::set<M>> params_to_store =
-                 std::map<unsigned int, std::set<M>>{})
+             std::map<unsigned int, std::set<token_type>> params_to_store =
+                 std::map<unsigned int, std::set<token_type>>{})
       : templ_(templ), config_(config), params_(params_to_store) {
     using namespace flt::string::iterator;
     templ_length_ = 0;
@@ -70,7 +189,16 @@ public:
 
   bool templ_was_split() const { return templ_was_split_; }
 
-  void update(const M& logline) {
+  const M& templ() const { return templ_; }
+
+  template_id id() const { return id_; }
+  void set_id(template_id id) { id_ = id; }
+
+  std::uint64_t last_used() const { return last_used_; }
+  void touch(std::uint64_t tick) { last_used_ = std::max(last_used_, tick); }
+
+  // Returns whether the template was generalized
+  bool update(const M& logline, dictionary_type& dictionary) {
     auto num_tokens_templ = count_tokens(templ_);
     assert(num_tokens_templ == count_tokens(logline));
 
@@ -82,28 +210,33 @@ public:
     auto token_pos = 0u;
     auto params_in_templ_replaced = param_table_entry{};
     auto params_in_logline_replaced = param_table_entry{};
+    auto generalized = false;
 
     while (logline_it != logline_it_last) {
       if (token_pos == 0)
         new_templ += logline_it.get_prev_seps();
       if (*logline_it != *templ_it && *templ_it != wildcard_) {
+        generalized = true;
         if (token_positions_with_max_num_tokens_exceeded_.find(token_pos) ==
             token_positions_with_max_num_tokens_exceeded_.end()) {
+          const auto logline_token = dictionary.intern(*logline_it);
+          const auto templ_token = dictionary.intern(*templ_it);
           if (config_.store_params()) {
-            params_[token_pos].insert(M(*logline_it));
-            params_[token_pos].insert(M(*templ_it));
+            params_[token_pos].insert(logline_token);
+            params_[token_pos].insert(templ_token);
           }
-          params_in_templ_replaced[token_pos] = *templ_it;
-          params_in_logline_replaced[token_pos] = *logline_it;
+          params_in_templ_replaced[token_pos] = templ_token;
+          params_in_logline_replaced[token_pos] = logline_token;
         }
         new_templ += wildcard_;
       } else {
         if (*templ_it == wildcard_) {
           if (token_positions_with_max_num_tokens_exceeded_.find(token_pos) ==
               token_positions_with_max_num_tokens_exceeded_.end()) {
-            params_in_logline_replaced[token_pos] = *logline_it;
+            const auto logline_token = dictionary.intern(*logline_it);
+            params_in_logline_replaced[token_pos] = logline_token;
             if (config_.store_params())
-              params_[token_pos].insert(M(*logline_it));
+              params_[token_pos].insert(logline_token);
           }
         }
         new_templ += *templ_it;
@@ -115,6 +248,7 @@ public:
     }
     templ_ = new_templ;
     update_param_table(params_in_templ_replaced, params_in_logline_replaced);
+    return generalized;
   }
 
   double get_similarity(const M& logline) const {
@@ -147,6 +281,187 @@ public:
     return double(num_equal_tokens) / num_tokens_templ - config_.threshold();
   }
 
+  // A logline matches if updating with it would leave the template unchanged,
+  // i.e. it differs from the template only at wildcard positions.
+  bool matches(const M& logline) const {
+    using namespace flt::string::iterator;
+    auto logline_it = cbegin_wordwise_special_seps(logline);
+    auto logline_it_last = cend_wordwise_special_seps(logline);
+    auto templ_it = cbegin_wordwise_special_seps(templ_);
+
+    if (logline_it != logline_it_last &&
+        logline_it.get_prev_seps() != templ_it.get_prev_seps())
+      return false;
+    while (logline_it != logline_it_last) {
+      if (*templ_it != wildcard_ && *logline_it != *templ_it)
+        return false;
+      if (logline_it.get_next_seps() != templ_it.get_next_seps())
+        return false;
+      ++logline_it;
+      ++templ_it;
+    }
+    return true;
+  }
+
+  unsigned int num_tokens() const { return templ_length_; }
+
+  unsigned int num_wildcards() const {
+    using namespace flt::string::iterator;
+    return unsigned(std::count(cbegin_wordwise_special_seps(templ_),
+                               cend_wordwise_special_seps(templ_), wildcard_));
+  }
+
+  bool is_wildcard_at(token_pos_type pos) const {
+    using namespace flt::string::iterator;
+    return *std::next(cbegin_wordwise_special_seps(templ_), pos) == wildcard_;
+  }
+
+  // Hashes of the template, one per token position, with the token at that
+  // position left out. Two templates differing only in the token at some
+  // position share the hash for that position.
+  std::vector<std::size_t> masked_hashes() const {
+    using namespace flt::string::iterator;
+    using flt::util::hash_combine;
+    using view_type = std::basic_string_view<typename M::value_type,
+                                             typename M::traits_type>;
+    auto hasher = std::hash<view_type>{};
+    auto token_hashes = std::vector<std::size_t>{};
+    auto seps_hashes = std::vector<std::size_t>{};
+    auto templ_it = cbegin_wordwise_special_seps(templ_);
+    auto lead_hash = hasher(templ_it.get_prev_seps());
+    for (; templ_it != cend_wordwise_special_seps(templ_); ++templ_it) {
+      token_hashes.push_back(hasher(*templ_it));
+      seps_hashes.push_back(hasher(templ_it.get_next_seps()));
+    }
+
+    const auto num_tokens = token_hashes.size();
+    auto prefix_hashes = std::vector<std::size_t>(num_tokens + 1, lead_hash);
+    auto suffix_hashes = std::vector<std::size_t>(num_tokens + 1, 0);
+    for (auto pos = 0u; pos < num_tokens; ++pos)
+      prefix_hashes[pos + 1] = hash_combine(
+          prefix_hashes[pos], token_hashes[pos], seps_hashes[pos]);
+    for (auto pos = num_tokens; pos-- > 0;)
+      suffix_hashes[pos] = hash_combine(token_hashes[pos], seps_hashes[pos],
+                                        suffix_hashes[pos + 1]);
+
+    auto masked = std::vector<std::size_t>(num_tokens);
+    for (auto pos = 0u; pos < num_tokens; ++pos)
+      masked[pos] = hash_combine(prefix_hashes[pos], std::size_t{pos},
+                                 seps_hashes[pos], suffix_hashes[pos + 1]);
+    return masked;
+  }
+
+  bool differs_only_at(const templ_node& other, token_pos_type pos) const {
+    using namespace flt::string::iterator;
+    auto other_it = cbegin_wordwise_special_seps(other.templ_);
+    auto other_it_last = cend_wordwise_special_seps(other.templ_);
+    auto templ_it = cbegin_wordwise_special_seps(templ_);
+    auto templ_it_last = cend_wordwise_special_seps(templ_);
+    if (other_it != other_it_last &&
+        other_it.get_prev_seps() != templ_it.get_prev_seps())
+      return false;
+    for (auto token_pos = 0u; other_it != other_it_last;
+         ++other_it, ++templ_it, ++token_pos) {
+      if (templ_it == templ_it_last ||
+          (token_pos != pos && *other_it != *templ_it) ||
+          other_it.get_next_seps() != templ_it.get_next_seps())
+        return false;
+    }
+    return templ_it == templ_it_last;
+  }
+
+  // Merges another template of the same length into this one. Differing
+  // tokens are replaced by wildcards and stored as parameters, just as if the
+  // other template was a logline passed to update(). Positions frozen on
+  // either side take no more parameters.
+  void merge(const templ_node& other, dictionary_type& dictionary) {
+    assert(templ_length_ == other.templ_length_);
+
+    token_positions_with_max_num_tokens_exceeded_.insert(
+        other.token_positions_with_max_num_tokens_exceeded_.begin(),
+        other.token_positions_with_max_num_tokens_exceeded_.end());
+
+    using namespace flt::string::iterator;
+    auto other_it = cbegin_wordwise_special_seps(other.templ_);
+    auto other_it_last = cend_wordwise_special_seps(other.templ_);
+    auto templ_it = cbegin_wordwise_special_seps(templ_);
+    auto new_templ = M{};
+    auto token_pos = 0u;
+    auto params_in_templ_replaced = param_table_entry{};
+    auto params_in_other_replaced = param_table_entry{};
+
+    while (other_it != other_it_last) {
+      if (token_pos == 0)
+        new_templ += other_it.get_prev_seps();
+      const auto is_param = *templ_it == wildcard_ || *other_it != *templ_it;
+      if (is_param &&
+          token_positions_with_max_num_tokens_exceeded_.find(token_pos) ==
+              token_positions_with_max_num_tokens_exceeded_.end()) {
+        if (*templ_it != wildcard_) {
+          const auto templ_token = dictionary.intern(*templ_it);
+          if (config_.store_params())
+            params_[token_pos].insert(templ_token);
+          params_in_templ_replaced[token_pos] = templ_token;
+        }
+        if (*other_it != wildcard_) {
+          const auto other_token = dictionary.intern(*other_it);
+          if (config_.store_params())
+            params_[token_pos].insert(other_token);
+          params_in_other_replaced[token_pos] = other_token;
+        }
+      }
+      if (is_param)
+        new_templ += wildcard_;
+      else
+        new_templ += *templ_it;
+      new_templ += other_it.get_next_seps();
+      ++other_it;
+      ++templ_it;
+      ++token_pos;
+    }
+    templ_ = new_templ;
+
+    touch(other.last_used_);
+
+    // A template without parameter table entries stands for loglines without
+    // parameters, which now have parameters at the replaced positions.
+    auto merged_param_table = decltype(param_table_){};
+    auto merge_entries = [&](const auto& param_table,
+                             const param_table_entry& replaced) {
+      if (param_table.empty()) {
+        merged_param_table.insert(replaced);
+        return;
+      }
+      for (auto entry : param_table) {
+        entry.insert(replaced.begin(), replaced.end());
+        merged_param_table.insert(std::move(entry));
+      }
+    };
+    merge_entries(param_table_, params_in_templ_replaced);
+    merge_entries(other.param_table_, params_in_other_replaced);
+    if (!token_positions_with_max_num_tokens_exceeded_.empty()) {
+      param_table_ = decltype(param_table_){};
+      for (auto entry : merged_param_table) {
+        for (auto pos : token_positions_with_max_num_tokens_exceeded_)
+          entry.erase(pos);
+        param_table_.insert(std::move(entry));
+      }
+    } else {
+      param_table_ = std::move(merged_param_table);
+    }
+    if (param_table_.size() > max_param_table_entries_)
+      reduce_param_table();
+
+    // Positions frozen by the merge keep the parameters stored before
+    if (config_.store_params())
+      for (const auto& params_at_pos : other.params_)
+        if (token_positions_with_max_num_tokens_exceeded_.find(
+                params_at_pos.first) ==
+            token_positions_with_max_num_tokens_exceeded_.end())
+          params_[params_at_pos.first].insert(params_at_pos.second.begin(),
+                                              params_at_pos.second.end());
+  }
+
   void save_templ(std::ofstream& fout, bool save_params = false,
                   M prefix = M{}) const {
     fout << prefix << templ_ << '\n';
@@ -161,6 +476,7 @@ public:
         fout << "  Positions with max num of tokens exceeded:";
         for (auto pos : token_positions_with_max_num_tokens_exceeded_)
           fout << " " << pos;
+        fout << '\n';
       }
     }
   }
@@ -177,7 +493,7 @@ public:
     auto param_positions = get_param_positions_in_param_table();
 
     for (auto param_pos : param_positions) {
-      auto uniq_toks = std::set<M>{};
+      auto uniq_toks = std::set<token_type>{};
       auto param_at_all_pos = true;
       for (auto param_table_entry : param_table_) {
         auto token_at_pos = param_table_entry[param_pos];
@@ -209,7 +525,7 @@ public:
                ++pos2) {
             if (pos1 != pos2) {
               auto possible_bijection = true;
-              auto par1_par2 = std::map<M, M>{};
+              auto par1_par2 = std::map<token_type, token_type>{};
               auto par1_eq_par2_for_all_entries = true;
               for (auto param_table_entry : param_table_) {
                 if (param_table_entry[*pos1] != param_table_entry[*pos2])
@@ -256,7 +572,7 @@ public:
                  token_positions_w_same_num_uniq_params[token_positions
                                                             .first]) {
               auto possible_bijection = true;
-              auto par1_par2 = std::map<M, M>{};
+              auto par1_par2 = std::map<token_type, token_type>{};
               for (auto param_table_entry : param_table_) {
                 if (par1_par2.find(param_table_entry[pos1]) ==
                     par1_par2.end()) {
@@ -286,7 +602,7 @@ public:
       for (auto param_tbl_entr : param_table_) {
         auto cur_token_pos = 0u;
         auto new_templ = M{};
-        auto params_to_store = std::map<unsigned int, M>{};
+        auto params_to_store = std::map<unsigned int, token_type>{};
         using namespace flt::string::iterator;
         for (auto templ_it = cbegin_wordwise_special_seps(templ_);
              templ_it != cend_wordwise_special_seps(templ_); ++templ_it) {
@@ -309,10 +625,11 @@ public:
             if (token_positions_with_max_num_tokens_exceeded_.find(
                     param.first) !=
                 token_positions_with_max_num_tokens_exceeded_.end())
-              new_templ_params[new_templ][param.first] = std::set<M>{"*"};
+              new_templ_params[new_templ][param.first] =
+                  std::set<token_type>{"*"};
             else
               new_templ_params[new_templ][param.first] =
-                  std::set<M>{param.second};
+                  std::set<token_type>{param.second};
           }
         } else {
           for (const auto& param : params_to_store)
@@ -334,6 +651,96 @@ public:
     return (templ_ < other.templ_);
   }
 
+  // Approximate number of bytes allocated by the node, without the node
+  // itself and the interned tokens.
+  std::size_t memory_usage() const {
+    auto bytes = templ_.capacity() * sizeof(typename M::value_type);
+    for (const auto& params_at_pos : params_)
+      bytes += tree_node_size<typename decltype(params_)::value_type> +
+               params_at_pos.second.size() * tree_node_size<token_type>;
+    for (const auto& entry : param_table_)
+      bytes += tree_node_size<param_table_entry> +
+               entry.size() *
+                   tree_node_size<typename param_table_entry::value_type>;
+    bytes += token_positions_with_max_num_tokens_exceeded_.size() *
+             tree_node_size<token_pos_type>;
+    return bytes;
+  }
+
+  // Points all parameters to the same tokens in another dictionary
+  void reintern(dictionary_type& dictionary) {
+    for (auto& params_at_pos : params_) {
+      auto reinterned = std::set<token_type>{};
+      for (auto param : params_at_pos.second)
+        reinterned.insert(reinterned.end(), dictionary.intern(param));
+      params_at_pos.second = std::move(reinterned);
+    }
+    auto reinterned_table = decltype(param_table_){};
+    for (auto entry : param_table_) {
+      for (auto& param : entry)
+        param.second = dictionary.intern(param.second);
+      reinterned_table.insert(reinterned_table.end(), std::move(entry));
+    }
+    param_table_ = std::move(reinterned_table);
+  }
+
+  // The id and whether the template was split are not part of the state
+  void save_state(std::ostream& out) const {
+    write_token(out, templ_);
+    write_varint(out, last_used_);
+    write_varint(out, params_.size());
+    for (const auto& params_at_pos : params_) {
+      write_varint(out, params_at_pos.first);
+      write_varint(out, params_at_pos.second.size());
+      for (const auto& param : params_at_pos.second)
+        write_token(out, param);
+    }
+    write_varint(out, param_table_.size());
+    for (const auto& entry : param_table_) {
+      write_varint(out, entry.size());
+      for (const auto& param : entry) {
+        write_varint(out, param.first);
+        write_token(out, param.second);
+      }
+    }
+    write_varint(out, token_positions_with_max_num_tokens_exceeded_.size());
+    for (auto pos : token_positions_with_max_num_tokens_exceeded_)
+      write_varint(out, pos);
+  }
+
+  static templ_node load_state(std::istream& in, const configuration& config,
+                               dictionary_type& dictionary) {
+    auto node = templ_node{read_token<M>(in), config};
+    const auto read_pos = [&] {
+      const auto pos = read_varint(in);
+      if (pos >= node.templ_length_)
+        throw_corrupt_state();
+      return token_pos_type(pos);
+    };
+    const auto read_param = [&] {
+      return dictionary.intern(read_token<M>(in));
+    };
+    node.last_used_ = read_varint(in);
+    for (auto num_positions = read_varint(in); num_positions > 0;
+         --num_positions) {
+      auto& params_at_pos = node.params_[read_pos()];
+      for (auto num_params = read_varint(in); num_params > 0; --num_params)
+        params_at_pos.insert(read_param());
+    }
+    for (auto num_entries = read_varint(in); num_entries > 0; --num_entries) {
+      auto entry = param_table_entry{};
+      for (auto num_params = read_varint(in); num_params > 0; --num_params) {
+        const auto pos = read_pos();
+        entry[pos] = read_param();
+      }
+      node.param_table_.insert(std::move(entry));
+    }
+    for (auto num_positions = read_varint(in); num_positions > 0;
+         --num_positions)
+      node.token_positions_with_max_num_tokens_exceeded_.insert(read_pos());
+    return node;
+  }
+
 private:
   std::set<unsigned int> get_param_positions_in_param_table() const {
     std::set<unsigned int> param_positions{};
@@ -366,8 +773,12 @@ private:
   }
 
   void reduce_param_table() {
+#ifdef FLT_TEMPLATER_STATS
+    ++config_.stats().param_table_reductions;
+#endif
     auto param_positions = get_param_positions_in_param_table();
-    auto uniq_params_at_positions = std::map<token_pos_type, std::set<M>>{};
+    auto uniq_params_at_positions =
+        std::map<token_pos_type, std::set<token_type>>{};
 
     for (const auto& param_table_entry : param_table_) {
       for (const auto& param_table_entry_pos : param_table_entry) {
@@ -418,19 +829,49 @@ template <typename M> class templ_layer {
   std::vector<templ_node<M>> nodes;
   std::vector<templ_node<M>> split_nodes;
   configuration config_;
+  templater_context<M>* context_;
 
 public:
-  templ_layer(const configuration& config) : config_(config) {}
+  templ_layer(const configuration& config, templater_context<M>* context)
+      : config_(config), context_(context) {}
 
+  // Templates split off again in the same way keep their ids and are not
+  // reported a second time.
   void split_templs() {
+    auto prev_split_ids = std::unordered_map<M, template_id>{};
+    for (const auto& node : split_nodes)
+      prev_split_ids.emplace(node.templ(), node.id());
     split_nodes = decltype(split_nodes){};
     for (auto& node : nodes) {
+#ifdef FLT_TEMPLATER_STATS
+      auto t_start = std::chrono::steady_clock::now();
+#endif
       auto new_templs = node.split_templ();
-      split_nodes.insert(split_nodes.end(), new_templs.begin(),
-                         new_templs.end());
+#ifdef FLT_TEMPLATER_STATS
+      config_.stats().split_templ_ns.add(elapsed_ns(t_start));
+      config_.stats().templates_split += node.templ_was_split();
+#endif
+      for (auto new_templ : new_templs) {
+        new_templ.touch(node.last_used());
+        if (auto prev_id = prev_split_ids.find(new_templ.templ());
+            prev_id != prev_split_ids.end()) {
+          new_templ.set_id(prev_id->second);
+        } else {
+          auto& events = context_->events;
+          new_templ.set_id(events.next_id());
+          if (events.has_callbacks(template_event_kind::split))
+            events.notify(template_event_kind::split, new_templ.id(),
+                          node.id(), new_templ.templ());
+        }
+        split_nodes.push_back(std::move(new_templ));
+      }
     }
   }
 
+  std::size_t num_templs() const { return nodes.size(); }
+
+  bool empty() const { return nodes.empty() && split_nodes.empty(); }
+
   void print_templs() const {
     for (const auto& node : nodes)
       if (!node.templ_was_split())
@@ -464,26 +905,231 @@ public:
         node_to_update = node;
       }
     }
+#ifdef FLT_TEMPLATER_STATS
+    config_.stats().similarity_calls += nodes.size();
+    config_.stats().similarity_calls_per_line.add(nodes.size());
+#endif
     if (max_similarity > 0) {
-      node_to_update->update(logline);
+#ifdef FLT_TEMPLATER_STATS
+      ++config_.stats().templates_updated;
+#endif
+      node_to_update->touch(context_->tick);
+      auto& events = context_->events;
+      if (node_to_update->update(logline, *context_->dictionary) &&
+          events.has_callbacks(template_event_kind::generalized))
+        events.notify(template_event_kind::generalized, node_to_update->id(),
+                      node_to_update->id(), node_to_update->templ());
     } else {
+#ifdef FLT_TEMPLATER_STATS
+      ++config_.stats().templates_added;
+#endif
       add_node(logline);
     }
   }
 
+  // Merges templates that differ in a single token, as long as the merged
+  // template keeps more than min_constant_ratio of its tokens constant.
+  // Candidates are found via an index on the templates with one token masked
+  // out, which avoids comparing all pairs of templates. Every index key is
+  // visited once, a template taking part in a merge is not considered again
+  // within the same pass.
+  std::size_t consolidate(double min_constant_ratio) {
+    if (nodes.size() < 2)
+      return 0;
+
+    auto masked_hashes = std::vector<std::vector<std::size_t>>{};
+    masked_hashes.reserve(nodes.size());
+    auto candidates =
+        std::unordered_map<std::size_t, std::vector<std::size_t>>{};
+    for (auto node_i = std::size_t{0}; node_i < nodes.size(); ++node_i) {
+      masked_hashes.push_back(nodes[node_i].masked_hashes());
+      for (auto hash : masked_hashes.back())
+        candidates[hash].push_back(node_i);
+    }
+
+    auto merged = std::vector<bool>(nodes.size(), false);
+    auto touched = std::vector<bool>(nodes.size(), false);
+    auto num_merged = std::size_t{0};
+    for (auto node_i = std::size_t{0}; node_i < nodes.size(); ++node_i) {
+      if (touched[node_i])
+        continue;
+      auto& node = nodes[node_i];
+      const auto num_tokens = node.num_tokens();
+      for (auto pos = 0u; pos < num_tokens && !touched[node_i]; ++pos) {
+        auto candidate_list = candidates.find(masked_hashes[node_i][pos]);
+        if (candidate_list == candidates.end())
+          continue;
+        const auto num_wildcards =
+            node.num_wildcards() + !node.is_wildcard_at(pos);
+        if (double(num_tokens - num_wildcards) / num_tokens >
+            min_constant_ratio) {
+          for (auto other_i : candidate_list->second) {
+            if (other_i == node_i || touched[other_i] ||
+                !node.differs_only_at(nodes[other_i], pos))
+              continue;
+            node.merge(nodes[other_i], *context_->dictionary);
+            merged[other_i] = touched[other_i] = true;
+            touched[node_i] = true;
+            ++num_merged;
+          }
+          if (touched[node_i] && context_->events.has_callbacks(
+                                     template_event_kind::generalized))
+            context_->events.notify(template_event_kind::generalized,
+                                    node.id(), node.id(), node.templ());
+        }
+        candidates.erase(candidate_list);
+      }
+    }
+
+    if (num_merged > 0) {
+      auto remaining = decltype(nodes){};
+      remaining.reserve(nodes.size() - num_merged);
+      for (auto node_i = std::size_t{0}; node_i < nodes.size(); ++node_i)
+        if (!merged[node_i])
+          remaining.push_back(std::move(nodes[node_i]));
+      nodes = std::move(remaining);
+    }
+    return num_merged;
+  }
+
+  node_type* match(const M& logline) {
+    for (auto& node : nodes)
+      if (node.matches(logline))
+        return &node;
+    return nullptr;
+  }
+
+  void collect_last_used(std::vector<std::uint64_t>& last_used) const {
+    for (const auto& node : nodes)
+      last_used.push_back(node.last_used());
+  }
+
+  // Removes all templates last used before the given tick, split off
+  // templates included. Returns the number of evicted templates.
+  std::size_t evict(std::uint64_t min_last_used) {
+    auto is_recent = [min_last_used](const node_type& node) {
+      return node.last_used() >= min_last_used;
+    };
+    auto evicted = std::stable_partition(nodes.begin(), nodes.end(), is_recent);
+    const auto num_evicted = std::size_t(nodes.end() - evicted);
+    if (context_->events.has_callbacks(template_event_kind::evicted))
+      for (auto node = evicted; node != nodes.end(); ++node)
+        context_->events.notify(template_event_kind::evicted, node->id(),
+                                node->id(), node->templ());
+    nodes.erase(evicted, nodes.end());
+    split_nodes.erase(
+        std::stable_partition(split_nodes.begin(), split_nodes.end(),
+                              is_recent),
+        split_nodes.end());
+    if (num_evicted > 0) {
+      nodes.shrink_to_fit();
+      split_nodes.shrink_to_fit();
+    }
+    return num_evicted;
+  }
+
+  std::size_t memory_usage() const {
+    auto bytes =
+        (nodes.capacity() + split_nodes.capacity()) * sizeof(node_type);
+    for (const auto* templ_nodes : {&nodes, &split_nodes})
+      for (const auto& node : *templ_nodes)
+        bytes += node.memory_usage();
+    return bytes;
+  }
+
+  void reintern(typename templater_context<M>::dictionary_type& dictionary) {
+    for (auto* templ_nodes : {&nodes, &split_nodes})
+      for (auto& node : *templ_nodes)
+        node.reintern(dictionary);
+  }
+
+  // Split off templates are left out, they are derived by split_templs
+  void save_state(std::ostream& out) const {
+    write_varint(out, nodes.size());
+    for (const auto& node : nodes)
+      node.save_state(out);
+  }
+
+  void load_state(std::istream& in) {
+    for (auto num_nodes = read_varint(in); num_nodes > 0; --num_nodes)
+      insert_node(
+          node_type::load_state(in, config_, *context_->dictionary));
+  }
+
+  // Each template of the other layer is merged into the most similar
+  // template, like a logline updating it. A template generalized this way is
+  // merged with further templates it has become similar to, so no two
+  // templates of the layer are similar afterwards if none were before.
+  // Templates without a similar one are added. Last use ticks of the other
+  // layer are shifted by tick_offset.
+  void merge(const templ_layer& other, std::uint64_t tick_offset) {
+    auto& dictionary = *context_->dictionary;
+    for (auto node : other.nodes) {
+      node.reintern(dictionary);
+      node.touch(node.last_used() + tick_offset);
+      auto target = most_similar(node.templ(), nodes.size());
+      if (target == nodes.size()) {
+        insert_node(std::move(node));
+        continue;
+      }
+      nodes[target].merge(node, dictionary);
+      for (auto similar = most_similar(nodes[target].templ(), target);
+           similar != nodes.size();
+           similar = most_similar(nodes[target].templ(), target)) {
+        nodes[target].merge(nodes[similar], dictionary);
+        nodes.erase(nodes.begin() + std::ptrdiff_t(similar));
+        target -= similar < target;
+      }
+      if (context_->events.has_callbacks(template_event_kind::generalized))
+        context_->events.notify(template_event_kind::generalized,
+                                nodes[target].id(), nodes[target].id(),
+                                nodes[target].templ());
+    }
+  }
+
 private:
   void add_node(const M& logline) {
-    nodes.push_back(templ_node(logline, config_));
+    insert_node(node_type{logline, config_}).touch(context_->tick);
+  }
+
+  node_type& insert_node(node_type node) {
+    auto& inserted = nodes.emplace_back(std::move(node));
+    inserted.set_id(context_->events.next_id());
+    if (context_->events.has_callbacks(template_event_kind::added))
+      context_->events.notify(template_event_kind::added, inserted.id(),
+                              inserted.id(), inserted.templ());
+    return inserted;
+  }
+
+  // Index of the template most similar to templ other than skip, the number
+  // of templates if none is similar
+  std::size_t most_similar(const M& templ, std::size_t skip) const {
+    auto best = nodes.size();
+    auto max_similarity = 0.;
+    for (auto node_i = std::size_t{0}; node_i < nodes.size(); ++node_i) {
+      if (node_i == skip)
+        continue;
+      const auto similarity = nodes[node_i].get_similarity(templ);
+      if (similarity > max_similarity) {
+        max_similarity = similarity;
+        best = node_i;
+      }
+    }
+    return best;
   }
 };
 
 template <typename M> class token_layer {
-  std::unordered_map<M, templ_layer<M>> nodes_first;
-  std::unordered_map<M, templ_layer<M>> nodes_last;
+  using dictionary_type = typename templater_context<M>::dictionary_type;
+  using token_type = typename dictionary_type::view_type;
+  std::unordered_map<token_type, templ_layer<M>> nodes_first;
+  std::unordered_map<token_type, templ_layer<M>> nodes_last;
   configuration config_;
+  templater_context<M>* context_;
 
 public:
-  token_layer(const configuration& config) : config_(config) {}
+  token_layer(const configuration& config, templater_context<M>* context)
+      : config_(config), context_(context) {}
 
   void update(const M& logline) {
     auto& templs_nodes = get_templ_nodes(logline);
@@ -497,6 +1143,15 @@ public:
       node.second.split_templs();
   }
 
+  std::size_t consolidate(double min_constant_ratio) {
+    auto num_merged = std::size_t{0};
+    for (auto& node : nodes_first)
+      num_merged += node.second.consolidate(min_constant_ratio);
+    for (auto& node : nodes_last)
+      num_merged += node.second.consolidate(min_constant_ratio);
+    return num_merged;
+  }
+
   void print_templs() const {
     std::cout << "  Token layer with first token as key\n";
     for (const auto& node : nodes_first) {
@@ -520,45 +1175,181 @@ public:
     }
   }
 
+  templ_node<M>* match(const M& logline) {
+    auto templs_nodes = find_templ_nodes(logline);
+    return templs_nodes ? templs_nodes->match(logline) : nullptr;
+  }
+
+  std::size_t collect_stats(templater_stats& stats) const {
+    auto num_templs = std::size_t{0};
+    for (const auto* token_nodes : {&nodes_first, &nodes_last}) {
+      for (const auto& node : *token_nodes) {
+        ++stats.token_buckets;
+        stats.templates_per_token_bucket.add(node.second.num_templs());
+        num_templs += node.second.num_templs();
+      }
+    }
+    return num_templs;
+  }
+
+  std::size_t num_buckets() const {
+    return nodes_first.size() + nodes_last.size();
+  }
+
+  void collect_last_used(std::vector<std::uint64_t>& last_used) const {
+    for (const auto* token_nodes : {&nodes_first, &nodes_last})
+      for (const auto& node : *token_nodes)
+        node.second.collect_last_used(last_used);
+  }
+
+  // Buckets left without templates are removed as well
+  std::size_t evict(std::uint64_t min_last_used) {
+    auto num_evicted = std::size_t{0};
+    for (auto* token_nodes : {&nodes_first, &nodes_last}) {
+      for (auto node = token_nodes->begin(); node != token_nodes->end();) {
+        num_evicted += node->second.evict(min_last_used);
+        node = node->second.empty() ? token_nodes->erase(node) : ++node;
+      }
+    }
+    return num_evicted;
+  }
+
+  std::size_t memory_usage() const {
+    return hash_map_memory_usage(nodes_first) +
+           hash_map_memory_usage(nodes_last);
+  }
+
+  void reintern(dictionary_type& dictionary) {
+    for (auto* token_nodes : {&nodes_first, &nodes_last}) {
+      auto reinterned = std::decay_t<decltype(*token_nodes)>{};
+      reinterned.reserve(token_nodes->size());
+      for (auto& node : *token_nodes) {
+        node.second.reintern(dictionary);
+        reinterned.emplace(dictionary.intern(node.first),
+                           std::move(node.second));
+      }
+      *token_nodes = std::move(reinterned);
+    }
+  }
+
+  void save_state(std::ostream& out) const {
+    for (const auto* token_nodes : {&nodes_first, &nodes_last}) {
+      write_varint(out, token_nodes->size());
+      for (const auto& node : *token_nodes) {
+        write_token(out, node.first);
+        node.second.save_state(out);
+      }
+    }
+  }
+
+  void load_state(std::istream& in) {
+    for (auto* token_nodes : {&nodes_first, &nodes_last})
+      for (auto num_nodes = read_varint(in); num_nodes > 0; --num_nodes) {
+        const auto key = read_token<M>(in);
+        find_or_add(*token_nodes, key).load_state(in);
+      }
+  }
+
+  void merge(const token_layer& other, std::uint64_t tick_offset) {
+    for (const auto& node : other.nodes_first)
+      find_or_add(nodes_first, node.first).merge(node.second, tick_offset);
+    for (const auto& node : other.nodes_last)
+      find_or_add(nodes_last, node.first).merge(node.second, tick_offset);
+  }
+
 private:
-  templ_layer<M>& get_templ_nodes(const M& logline) {
+  // Returns the map the logline is sorted into, together with its key.
+  // The key is a view into the logline.
+  template <typename Self>
+  static auto select_nodes(Self& self, const M& logline) {
     using namespace flt::string::iterator;
     auto token_it = cbegin_wordwise_special_seps(logline);
-    auto first_token = M{*token_it};
-    auto first_token_param = is_possible_param(first_token);
-    using mapped_type = typename decltype(nodes_first)::mapped_type;
-    if (first_token_param) {
-      for (int i = 1; i < count_tokens(logline); ++i) {
+    auto first_token = token_type{*token_it};
+    if (is_possible_param(first_token)) {
+      for (auto i = 1, num_tokens = int(count_tokens(logline)); i < num_tokens;
+           ++i) {
         token_it++;
       }
-      auto last_token = M(*token_it);
-      auto last_token_param = is_possible_param(last_token);
-      if (last_token_param) {
-        nodes_first.insert(std::make_pair("*", mapped_type{config_}));
-        return nodes_first.find("*")->second;
-      } else {
-        nodes_last.insert(std::make_pair(last_token, mapped_type{config_}));
-        return nodes_last.find(last_token)->second;
-      }
-    } else {
-      nodes_first.insert(std::make_pair(first_token, mapped_type{config_}));
-      return nodes_first.find(first_token)->second;
+      auto last_token = token_type{*token_it};
+      if (is_possible_param(last_token))
+        return std::make_pair(&self.nodes_first, token_type{"*"});
+      else
+        return std::make_pair(&self.nodes_last, last_token);
     }
+    return std::make_pair(&self.nodes_first, first_token);
+  }
+
+  templ_layer<M>& get_templ_nodes(const M& logline) {
+    auto [nodes, key] = select_nodes(*this, logline);
+#ifdef FLT_TEMPLATER_STATS
+    if (nodes == &nodes_last)
+      ++config_.stats().token_layer_lookups_last;
+    else if (key == "*")
+      ++config_.stats().token_layer_lookups_wildcard;
+    else
+      ++config_.stats().token_layer_lookups_first;
+#endif
+    return find_or_add(*nodes, key);
+  }
+
+  templ_layer<M>& find_or_add(decltype(nodes_first)& nodes, token_type key) {
+    auto node = nodes.find(key);
+    if (node == nodes.end()) {
+#ifdef FLT_TEMPLATER_STATS
+      ++config_.stats().token_layer_buckets_added;
+#endif
+      using mapped_type = typename decltype(nodes_first)::mapped_type;
+      node = nodes
+                 .emplace(context_->dictionary->intern(key),
+                          mapped_type{config_, context_})
+                 .first;
+    }
+    return node->second;
+  }
+
+  templ_layer<M>* find_templ_nodes(const M& logline) {
+    auto [nodes, key] = select_nodes(*this, logline);
+    auto node = nodes->find(key);
+    return node != nodes->end() ? &node->second : nullptr;
   }
 };
 
 template <typename M> class length_layer {
   configuration config_;
+  templater_context<M>* context_;
   std::unordered_map<unsigned int, token_layer<M>> nodes;
 
 public:
-  length_layer(const configuration& config) : config_{config} {}
+  length_layer(const configuration& config, templater_context<M>* context)
+      : config_{config}, context_{context} {}
 
   void update(const M& logline) {
     auto num_logline_tokens = count_tokens(logline);
     using mapped_type = typename decltype(nodes)::mapped_type;
-    nodes.insert(std::make_pair(num_logline_tokens, mapped_type{config_}));
-    nodes.find(num_logline_tokens)->second.update(logline);
+    auto [node, inserted] =
+        nodes.try_emplace(num_logline_tokens, mapped_type{config_, context_});
+#ifdef FLT_TEMPLATER_STATS
+    ++config_.stats().length_layer_lookups;
+    config_.stats().length_layer_buckets_added += inserted;
+#else
+    static_cast<void>(inserted);
+#endif
+    node->second.update(logline);
+  }
+
+  void collect_stats(templater_stats& stats) const {
+    for (const auto& node : nodes) {
+      ++stats.length_buckets;
+      auto num_templs = node.second.collect_stats(stats);
+      stats.token_buckets_per_length_bucket.add(node.second.num_buckets());
+      stats.templates_per_length_bucket.add(num_templs);
+      stats.templates += num_templs;
+    }
+  }
+
+  templ_node<M>* match(const M& logline) {
+    auto node = nodes.find(count_tokens(logline));
+    return node != nodes.end() ? node->second.match(logline) : nullptr;
   }
 
   void split_templs() {
@@ -566,6 +1357,52 @@ public:
       node.second.split_templs();
   }
 
+  std::size_t consolidate(double min_constant_ratio) {
+    auto num_merged = std::size_t{0};
+    for (auto& node : nodes)
+      num_merged += node.second.consolidate(min_constant_ratio);
+    return num_merged;
+  }
+
+  void collect_last_used(std::vector<std::uint64_t>& last_used) const {
+    for (const auto& node : nodes)
+      node.second.collect_last_used(last_used);
+  }
+
+  std::size_t evict(std::uint64_t min_last_used) {
+    auto num_evicted = std::size_t{0};
+    for (auto node = nodes.begin(); node != nodes.end();) {
+      num_evicted += node->second.evict(min_last_used);
+      node = node->second.num_buckets() == 0 ? nodes.erase(node) : ++node;
+    }
+    return num_evicted;
+  }
+
+  std::size_t memory_usage() const { return hash_map_memory_usage(nodes); }
+
+  void reintern(typename templater_context<M>::dictionary_type& dictionary) {
+    for (auto& node : nodes)
+      node.second.reintern(dictionary);
+  }
+
+  void save_state(std::ostream& out) const {
+    write_varint(out, nodes.size());
+    for (const auto& node : nodes) {
+      write_varint(out, node.first);
+      node.second.save_state(out);
+    }
+  }
+
+  void load_state(std::istream& in) {
+    for (auto num_nodes = read_varint(in); num_nodes > 0; --num_nodes)
+      find_or_add(unsigned(read_varint(in))).load_state(in);
+  }
+
+  void merge(const length_layer& other, std::uint64_t tick_offset) {
+    for (const auto& node : other.nodes)
+      find_or_add(node.first).merge(node.second, tick_offset);
+  }
+
   void print_lengths() const {
     for (const auto& node : nodes) {
       std::cout << "Length layer with length = " << node.first << '\n';
@@ -579,32 +1416,308 @@ public:
       node.second.save_templs(fout, save_params, prefix);
     }
   }
+
+private:
+  token_layer<M>& find_or_add(unsigned int num_tokens) {
+    using mapped_type = typename decltype(nodes)::mapped_type;
+    return nodes.try_emplace(num_tokens, mapped_type{config_, context_})
+        .first->second;
+  }
 };
 
 } // namespace detail
 
+class sampling_configuration {
+  double max_rate_;
+  double min_rate_;
+  double backoff_;
+  double novelty_threshold_;
+  unsigned int window_;
+
+public:
+  sampling_configuration(double max_rate = 1., double min_rate = 0.01,
+                         double backoff = 0.5,
+                         double novelty_threshold = 0.001,
+                         unsigned int window = 10000)
+      : max_rate_(max_rate), min_rate_(min_rate), backoff_(backoff),
+        novelty_threshold_(novelty_threshold), window_(window) {
+    if (!(min_rate_ > 0. && min_rate_ <= max_rate_ && max_rate_ <= 1.))
+      throw std::invalid_argument{
+          "Sampling rates must satisfy 0 < min_rate <= max_rate <= 1"};
+    if (!(backoff_ > 0. && backoff_ <= 1.))
+      throw std::invalid_argument{"Sampling backoff must be in (0, 1]"};
+    if (window_ == 0)
+      throw std::invalid_argument{"Sampling window must not be empty"};
+  }
+
+  double max_rate() const { return max_rate_; }
+  double min_rate() const { return min_rate_; }
+  double backoff() const { return backoff_; }
+  double novelty_threshold() const { return novelty_threshold_; }
+  unsigned int window() const { return window_; }
+};
+
+struct sampling_stats {
+  std::uint64_t lines{0};
+  // Lines covered by an existing template without changing it
+  std::uint64_t matched{0};
+  // Lines no template covered, these are always learned from
+  std::uint64_t novel{0};
+  // Matched lines picked by the sampling rate and learned from anyway
+  std::uint64_t sampled{0};
+  std::uint64_t skipped{0};
+  double sampling_rate{1.};
+  // Ratio of novel lines in the last completed window
+  double novelty_rate{0.};
+};
+
 template <typename M> class online_templater {
+#ifdef FLT_TEMPLATER_STATS
+  std::unique_ptr<templater_stats> stats_{
+      std::make_unique<templater_stats>()};
+#endif
   detail::configuration config_;
+  std::unique_ptr<detail::templater_context<M>> context_{
+      std::make_unique<detail::templater_context<M>>()};
+  // Only set if the templater does not share a dictionary
+  std::unique_ptr<typename detail::templater_context<M>::dictionary_type>
+      own_dictionary_;
   detail::length_layer<M> length_nodes;
 
+  std::optional<sampling_configuration> sampling_config_;
+  sampling_stats sampling_stats_;
+  double sampling_credit_{0.};
+  std::uint64_t window_lines_{0};
+  std::uint64_t window_novel_{0};
+
 public:
+  using dictionary_type =
+      typename detail::templater_context<M>::dictionary_type;
+
   online_templater(double threshold = 0.5, bool store_params = false)
-      : config_{threshold, store_params}, length_nodes(config_) {}
+      : online_templater(threshold, store_params, nullptr) {}
+
+  // The dictionary can be shared between templaters and must outlive them.
+  online_templater(double threshold, bool store_params,
+                   dictionary_type& dictionary)
+      : online_templater(threshold, store_params, &dictionary) {}
 
   void operator()(const M& logline) {
-    if (!logline.empty()) {
+#ifdef FLT_TEMPLATER_STATS
+    auto t_start = std::chrono::steady_clock::now();
+    ++stats_->lines;
+#endif
+    ++context_->tick;
+    if (!logline.empty() && (!sampling_config_ || sample(logline))) {
       length_nodes.update(logline);
     }
+#ifdef FLT_TEMPLATER_STATS
+    stats_->line_latency_ns.add(detail::elapsed_ns(t_start));
+#endif
+  }
+
+  // Counters are only collected if FLT_TEMPLATER_STATS is defined, the bucket
+  // size distributions are gathered from the templates on every call.
+  templater_stats get_stats() const {
+#ifdef FLT_TEMPLATER_STATS
+    auto stats = *stats_;
+#else
+    auto stats = templater_stats{};
+#endif
+    length_nodes.collect_stats(stats);
+    return stats;
+  }
+
+  // In adaptive sampling mode, loglines are first matched against the
+  // existing templates. Only loglines no template matches and a fraction of
+  // the matched ones, given by the sampling rate, are learned from. The rate
+  // backs off while the novelty rate stays below the threshold and is reset
+  // to its maximum as soon as it is exceeded.
+  void enable_adaptive_sampling(sampling_configuration config = {}) {
+    sampling_config_ = std::move(config);
+    sampling_stats_ = sampling_stats{};
+    sampling_stats_.sampling_rate = sampling_config_->max_rate();
+    sampling_credit_ = 0.;
+    window_lines_ = 0;
+    window_novel_ = 0;
+  }
+
+  void disable_adaptive_sampling() { sampling_config_.reset(); }
+
+  const sampling_stats& get_sampling_stats() const { return sampling_stats_; }
+
+  // Approximate number of bytes allocated by the templates, without the
+  // interned tokens they refer to.
+  std::size_t memory_usage() const {
+    return sizeof(*this) + sizeof(*context_) + length_nodes.memory_usage();
+  }
+
+  // Evicts the least recently used templates until memory_usage() is at most
+  // max_bytes. Returns the number of evicted templates.
+  std::size_t evict_templs(std::size_t max_bytes) {
+    auto num_evicted = std::size_t{0};
+    auto last_used = std::vector<std::uint64_t>{};
+    while (memory_usage() > max_bytes) {
+      last_used.clear();
+      length_nodes.collect_last_used(last_used);
+      if (last_used.empty())
+        break;
+      // Each round evicts at least the least recently used quarter
+      auto cutoff = last_used.begin() + last_used.size() / 4;
+      std::nth_element(last_used.begin(), cutoff, last_used.end());
+      num_evicted += length_nodes.evict(*cutoff + 1);
+    }
+    return num_evicted;
+  }
+
+  const dictionary_type& dictionary() const { return *context_->dictionary; }
+
+  // Moves all tokens the templater refers to into the given dictionary, which
+  // is used from then on.
+  void reintern(dictionary_type& dictionary) {
+    length_nodes.reintern(dictionary);
+    context_->dictionary = &dictionary;
+    if (own_dictionary_.get() != &dictionary)
+      own_dictionary_.reset();
+  }
+
+  // The dictionary only grows, evicted templates leave their tokens behind.
+  // Rebuilds the templater's own dictionary from the tokens still referred to.
+  void compact_dictionary() {
+    if (!own_dictionary_)
+      throw std::logic_error{
+          "Shared dictionaries are compacted by their owner"};
+    auto compacted = std::make_unique<dictionary_type>();
+    reintern(*compacted);
+    own_dictionary_ = std::move(compacted);
+  }
+
+  using template_event_type = typename detail::template_events<M>::event_type;
+  using template_callback_type =
+      typename detail::template_events<M>::callback_type;
+
+  // Callbacks are invoked synchronously on the templating thread whenever a
+  // template is created, generalized by a logline, split off or evicted.
+  // Template ids are stable for the lifetime of the templater.
+  void on_template_added(template_callback_type callback) {
+    context_->events.add_callback(template_event_kind::added,
+                                  std::move(callback));
+  }
+
+  void on_template_generalized(template_callback_type callback) {
+    context_->events.add_callback(template_event_kind::generalized,
+                                  std::move(callback));
+  }
+
+  void on_template_split(template_callback_type callback) {
+    context_->events.add_callback(template_event_kind::split,
+                                  std::move(callback));
+  }
+
+  void on_template_evicted(template_callback_type callback) {
+    context_->events.add_callback(template_event_kind::evicted,
+                                  std::move(callback));
   }
 
   auto split_templs() { length_nodes.split_templs(); }
 
+  // Writes the templates learned so far with their parameters, the state can
+  // be loaded or merged into a templater elsewhere. Split off templates are
+  // not part of the state.
+  void save_state(std::ostream& out) const {
+    out.write(detail::state_magic.data(),
+              std::streamsize(detail::state_magic.size()));
+    detail::write_varint(out, context_->tick);
+    length_nodes.save_state(out);
+  }
+
+  // Adds the templates of a saved state as they are, also if they are equal
+  // or similar to existing ones. Throws std::runtime_error if the state is
+  // corrupt, templates read up to then are kept.
+  void load_state(std::istream& in) {
+    auto magic = std::string(detail::state_magic.size(), '\0');
+    if (!in.read(magic.data(), std::streamsize(magic.size())) ||
+        magic != detail::state_magic)
+      detail::throw_corrupt_state();
+    context_->tick += detail::read_varint(in);
+    length_nodes.load_state(in);
+  }
+
+  // Merges the templates of another templater as if its loglines were seen
+  // after the ones of this templater, see detail::templ_layer::merge. The
+  // order of merges matters, merging the same templaters in the same order
+  // gives the same templates.
+  void merge(const online_templater& other) {
+    length_nodes.merge(other.length_nodes, context_->tick);
+    context_->tick += other.context_->tick;
+  }
+
+  // Merges near-duplicate templates within each length and token bucket, see
+  // detail::templ_layer::consolidate. Should be called before split_templs.
+  // Returns the number of templates merged away.
+  auto consolidate_templs(double min_constant_ratio = 0.5) {
+    return length_nodes.consolidate(min_constant_ratio);
+  }
+
   auto print_templs() const { length_nodes.print_lengths(); }
 
   auto save_templs(std::ofstream& fout, bool save_params = false,
                    const M prefix = M{}) const {
     length_nodes.save_lengths(fout, save_params, prefix);
   }
+
+private:
+  online_templater(double threshold, bool store_params,
+                   dictionary_type* dictionary)
+      : config_{threshold, store_params
+#ifdef FLT_TEMPLATER_STATS
+                ,
+                stats_.get()
+#endif
+        },
+        length_nodes(config_, context_.get()) {
+    if (!dictionary) {
+      own_dictionary_ = std::make_unique<dictionary_type>();
+      dictionary = own_dictionary_.get();
+    }
+    context_->dictionary = dictionary;
+  }
+
+  bool sample(const M& logline) {
+    auto& stats = sampling_stats_;
+    auto learn = true;
+    ++stats.lines;
+    ++window_lines_;
+    // Lines skipped still count as a use of their template for eviction
+    if (auto* node = length_nodes.match(logline)) {
+      node->touch(context_->tick);
+      ++stats.matched;
+      sampling_credit_ += stats.sampling_rate;
+      if (sampling_credit_ >= 1.) {
+        sampling_credit_ -= 1.;
+        ++stats.sampled;
+      } else {
+        ++stats.skipped;
+        learn = false;
+      }
+    } else {
+      ++stats.novel;
+      ++window_novel_;
+    }
+
+    if (window_lines_ >= sampling_config_->window()) {
+      stats.novelty_rate = double(window_novel_) / window_lines_;
+      if (stats.novelty_rate <= sampling_config_->novelty_threshold())
+        stats.sampling_rate =
+            std::max(sampling_config_->min_rate(),
+                     stats.sampling_rate * sampling_config_->backoff());
+      else
+        stats.sampling_rate = sampling_config_->max_rate();
+      window_lines_ = 0;
+      window_novel_ = 0;
+    }
+    return learn;
+  }
 };
 
 } // namespace online
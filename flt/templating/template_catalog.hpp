@@ -0,0 +1,227 @@
+#ifndef FLT_TEMPLATING_TEMPLATE_CATALOG_HPP
+#define FLT_TEMPLATING_TEMPLATE_CATALOG_HPP
+
+#include <flt/templating/template_events.hpp>
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace flt::templating {
+namespace detail {
+// The separators of the templater's tokenization, i.e. whitespace of the
+// classic locale and the special separators
+inline constexpr auto catalog_separators = [] {
+  auto separators = std::array<bool, 256>{};
+  for (auto c : std::string_view{" \t\n\v\f\r=;,'\"()[]{}"})
+    separators[static_cast<unsigned char>(c)] = true;
+  return separators;
+}();
+
+// Splits a line into its leading separators and its tokens, each followed by
+// its separators, like the word iterator of the templater.
+class token_cursor {
+public:
+  explicit token_cursor(std::string_view line)
+      : line_(line), lead_end_(skip(0, true)), pos_(lead_end_) {}
+
+  std::string_view leading_seps() const { return line_.substr(0, lead_end_); }
+
+  bool next(std::string_view& token, std::string_view& seps) {
+    if (pos_ == line_.size())
+      return false;
+    const auto token_end = skip(pos_, false);
+    const auto seps_end = skip(token_end, true);
+    token = line_.substr(pos_, token_end - pos_);
+    seps = line_.substr(token_end, seps_end - token_end);
+    pos_ = seps_end;
+    return true;
+  }
+
+private:
+  std::size_t skip(std::size_t pos, bool separators) const {
+    while (pos < line_.size() &&
+           catalog_separators[static_cast<unsigned char>(line_[pos])] ==
+               separators)
+      ++pos;
+    return pos;
+  }
+
+  std::string_view line_;
+  std::size_t lead_end_;
+  std::size_t pos_;
+};
+} // namespace detail
+
+// Templates saved by the online templater, compiled for classifying loglines
+// without learning from them. A logline matches a template if it has the same
+// tokens and separators, except at the template's wildcards, which match any
+// token. Template ids are the positions of the templates in the catalog.
+class template_catalog {
+public:
+  static constexpr std::string_view wildcard{"<*>"};
+
+  template_catalog() = default;
+  template_catalog(const template_catalog&) = delete;
+  template_catalog(template_catalog&&) = default;
+  template_catalog& operator=(const template_catalog&) = delete;
+  template_catalog& operator=(template_catalog&&) = default;
+
+  // Reads templates as written by online_templater::save_templs, with or
+  // without their parameters
+  explicit template_catalog(std::istream& in, bool with_params = false) {
+    for (auto line = std::string{}; std::getline(in, line);) {
+      if (line.empty())
+        continue;
+      if (with_params) {
+        if (line.rfind("  Params at pos ", 0) == 0 ||
+            line.rfind("  Positions with max num of tokens exceeded:", 0) == 0)
+          continue;
+        if (line.rfind("Split: ", 0) == 0)
+          line.erase(0, 7);
+      }
+      add(std::move(line));
+    }
+  }
+
+  template_id add(std::string templ) {
+    const auto id = static_cast<template_id>(templates_.size());
+    auto& entry = templates_.emplace_back();
+    entry.text = std::move(templ);
+    auto cursor = detail::token_cursor{entry.text};
+    entry.leading_seps = cursor.leading_seps();
+    auto token = std::string_view{};
+    auto seps = std::string_view{};
+    while (cursor.next(token, seps)) {
+      entry.items.push_back({token, seps, token == wildcard});
+      entry.num_wildcards += token == wildcard;
+    }
+
+    // Indexed like the templater's token layer, by the first token or, if
+    // that is a wildcard, by the last one
+    auto& bucket = buckets_[entry.items.size()];
+    auto* candidates = &bucket.others;
+    if (!entry.items.empty() && !entry.items.front().is_wildcard)
+      candidates = &bucket.by_first[entry.items.front().token];
+    else if (!entry.items.empty() && !entry.items.back().is_wildcard)
+      candidates = &bucket.by_last[entry.items.back().token];
+    // Kept sorted by the number of wildcards, the first match is the most
+    // specific one
+    auto pos = candidates->end();
+    while (pos != candidates->begin() &&
+           templates_[*std::prev(pos)].num_wildcards > entry.num_wildcards)
+      --pos;
+    candidates->insert(pos, id);
+    return id;
+  }
+
+  std::size_t size() const { return templates_.size(); }
+
+  const std::string& templ(template_id id) const {
+    return templates_[id].text;
+  }
+
+  // Returns the id of the most specific template matching the logline, the
+  // one with the fewest wildcards and of these the first one. The tokens of
+  // the logline at the template's wildcards are appended to params if given.
+  std::optional<template_id>
+  match(std::string_view logline,
+        std::vector<std::string_view>* params = nullptr) const {
+    auto cursor = detail::token_cursor{logline};
+    auto num_tokens = std::size_t{0};
+    auto first = std::string_view{};
+    auto last = std::string_view{};
+    auto seps = std::string_view{};
+    while (cursor.next(last, seps))
+      if (num_tokens++ == 0)
+        first = last;
+    const auto bucket = buckets_.find(num_tokens);
+    if (bucket == buckets_.end())
+      return std::nullopt;
+
+    auto best = std::optional<template_id>{};
+    const auto search = [&](const std::vector<template_id>& candidates) {
+      for (auto id : candidates) {
+        if (best && !more_specific(id, *best))
+          return;
+        if (matches(templates_[id], logline)) {
+          best = id;
+          return;
+        }
+      }
+    };
+    const auto& by_first = bucket->second.by_first;
+    if (const auto found = by_first.find(first); found != by_first.end())
+      search(found->second);
+    const auto& by_last = bucket->second.by_last;
+    if (const auto found = by_last.find(last); found != by_last.end())
+      search(found->second);
+    search(bucket->second.others);
+
+    if (best && params) {
+      auto params_cursor = detail::token_cursor{logline};
+      auto token = std::string_view{};
+      for (const auto& item : templates_[*best].items) {
+        params_cursor.next(token, seps);
+        if (item.is_wildcard)
+          params->push_back(token);
+      }
+    }
+    return best;
+  }
+
+private:
+  struct template_item {
+    std::string_view token;
+    std::string_view seps;
+    bool is_wildcard;
+  };
+
+  // The views point into the text, the deque keeps the entries in place
+  struct catalog_entry {
+    std::string text;
+    std::string_view leading_seps;
+    std::vector<template_item> items;
+    std::size_t num_wildcards{0};
+  };
+
+  struct length_bucket {
+    std::unordered_map<std::string_view, std::vector<template_id>> by_first;
+    std::unordered_map<std::string_view, std::vector<template_id>> by_last;
+    std::vector<template_id> others;
+  };
+
+  bool more_specific(template_id id, template_id other) const {
+    const auto wildcards = templates_[id].num_wildcards;
+    const auto other_wildcards = templates_[other].num_wildcards;
+    return wildcards < other_wildcards ||
+           (wildcards == other_wildcards && id < other);
+  }
+
+  static bool matches(const catalog_entry& entry, std::string_view logline) {
+    auto cursor = detail::token_cursor{logline};
+    if (cursor.leading_seps() != entry.leading_seps)
+      return false;
+    auto token = std::string_view{};
+    auto seps = std::string_view{};
+    for (const auto& item : entry.items) {
+      cursor.next(token, seps);
+      if ((!item.is_wildcard && token != item.token) || seps != item.seps)
+        return false;
+    }
+    return true;
+  }
+
+  std::deque<catalog_entry> templates_;
+  std::unordered_map<std::size_t, length_bucket> buckets_;
+};
+} // namespace flt::templating
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef FLT_TEMPLATING_TEMPLATE_EVENTS_HPP
+#define FLT_TEMPLATING_TEMPLATE_EVENTS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace flt::templating {
+inline namespace online {
+using template_id = std::uint64_t;
+
+enum class template_event_kind { added, generalized, split, evicted };
+
+// The view on the template is only valid during the callback.
+template <typename View> struct template_event {
+  template_event_kind kind;
+  template_id id;
+  // Template the event's template was split from, equal to id otherwise
+  template_id parent_id;
+  View templ;
+};
+
+namespace detail {
+template <typename M> class template_events {
+public:
+  using view_type = std::basic_string_view<typename M::value_type,
+                                           typename M::traits_type>;
+  using event_type = template_event<view_type>;
+  using callback_type = std::function<void(const event_type&)>;
+
+  template_id next_id() { return next_id_++; }
+
+  void add_callback(template_event_kind kind, callback_type callback) {
+    callbacks_[index(kind)].push_back(std::move(callback));
+  }
+
+  bool has_callbacks(template_event_kind kind) const {
+    return !callbacks_[index(kind)].empty();
+  }
+
+  void notify(template_event_kind kind, template_id id, template_id parent_id,
+              const M& templ) const {
+    const auto event = event_type{kind, id, parent_id, view_type{templ}};
+    for (const auto& callback : callbacks_[index(kind)])
+      callback(event);
+  }
+
+private:
+  static constexpr auto index(template_event_kind kind) {
+    return static_cast<std::size_t>(kind);
+  }
+
+  template_id next_id_{0};
+  std::array<std::vector<callback_type>, 4> callbacks_;
+};
+} // namespace detail
+} // namespace online
+} // namespace flt::templating
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef FLT_TEMPLATING_TEMPLATER_STATS_HPP
+#define FLT_TEMPLATING_TEMPLATER_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace flt::templating {
+inline namespace online {
+// Histogram with power of two bucket bounds. Bucket 0 counts zeros, bucket
+// i > 0 counts values in [2^(i-1), 2^i - 1].
+class log2_histogram {
+public:
+  static constexpr auto num_buckets = 65u;
+
+  void add(std::uint64_t value) {
+    auto bucket = 0u;
+    for (auto rest = value; rest != 0; rest >>= 1)
+      ++bucket;
+    ++buckets_[bucket];
+    ++count_;
+    sum_ += value;
+    max_ = std::max(max_, value);
+  }
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t sum() const { return sum_; }
+  std::uint64_t max() const { return max_; }
+  std::uint64_t bucket(unsigned int index) const { return buckets_[index]; }
+
+  static std::uint64_t upper_bound(unsigned int index) {
+    return index == 0 ? 0 : (std::uint64_t{1} << (index - 1)) * 2 - 1;
+  }
+
+private:
+  std::array<std::uint64_t, num_buckets> buckets_{};
+  std::uint64_t count_{0};
+  std::uint64_t sum_{0};
+  std::uint64_t max_{0};
+};
+
+struct templater_stats {
+#ifdef FLT_TEMPLATER_STATS
+  static constexpr bool enabled = true;
+#else
+  static constexpr bool enabled = false;
+#endif
+
+  // Counters, only collected if FLT_TEMPLATER_STATS is defined
+  std::uint64_t lines{0};
+  std::uint64_t length_layer_lookups{0};
+  std::uint64_t length_layer_buckets_added{0};
+  std::uint64_t token_layer_lookups_first{0};
+  std::uint64_t token_layer_lookups_last{0};
+  std::uint64_t token_layer_lookups_wildcard{0};
+  std::uint64_t token_layer_buckets_added{0};
+  std::uint64_t similarity_calls{0};
+  std::uint64_t templates_added{0};
+  std::uint64_t templates_updated{0};
+  std::uint64_t param_table_reductions{0};
+  std::uint64_t templates_split{0};
+  log2_histogram similarity_calls_per_line;
+  log2_histogram line_latency_ns;
+  log2_histogram split_templ_ns;
+
+  // Bucket sizes, always available as they are gathered on query
+  std::uint64_t length_buckets{0};
+  std::uint64_t token_buckets{0};
+  std::uint64_t templates{0};
+  log2_histogram token_buckets_per_length_bucket;
+  log2_histogram templates_per_length_bucket;
+  log2_histogram templates_per_token_bucket;
+};
+
+namespace detail {
+inline void write_histogram(std::ostream& os, std::string_view name,
+                            const log2_histogram& hist) {
+  auto last_bucket = 0u;
+  for (auto i = 0u; i < log2_histogram::num_buckets; ++i)
+    if (hist.bucket(i) != 0)
+      last_bucket = i;
+  auto cumulative = std::uint64_t{0};
+  for (auto i = 0u; i <= last_bucket && hist.count() != 0; ++i) {
+    cumulative += hist.bucket(i);
+    os << name << "_bucket{le=\"" << log2_histogram::upper_bound(i) << "\"} "
+       << cumulative << '\n';
+  }
+  os << name << "_bucket{le=\"+Inf\"} " << hist.count() << '\n';
+  os << name << "_count " << hist.count() << '\n';
+  os << name << "_sum " << hist.sum() << '\n';
+  os << name << "_max " << hist.max() << '\n';
+}
+} // namespace detail
+
+// Writes the stats as one "name value" pair per line, histograms as
+// cumulative buckets in the Prometheus text exposition style.
+inline void write_stats(std::ostream& os, const templater_stats& stats) {
+  using detail::write_histogram;
+  os << "flt_templater_stats_enabled " << templater_stats::enabled << '\n';
+  if constexpr (templater_stats::enabled) {
+    os << "flt_templater_lines " << stats.lines << '\n'
+       << "flt_templater_length_layer_lookups " << stats.length_layer_lookups
+       << '\n'
+       << "flt_templater_length_layer_buckets_added "
+       << stats.length_layer_buckets_added << '\n'
+       << "flt_templater_token_layer_lookups{key=\"first\"} "
+       << stats.token_layer_lookups_first << '\n'
+       << "flt_templater_token_layer_lookups{key=\"last\"} "
+       << stats.token_layer_lookups_last << '\n'
+       << "flt_templater_token_layer_lookups{key=\"wildcard\"} "
+       << stats.token_layer_lookups_wildcard << '\n'
+       << "flt_templater_token_layer_buckets_added "
+       << stats.token_layer_buckets_added << '\n'
+       << "flt_templater_similarity_calls " << stats.similarity_calls << '\n'
+       << "flt_templater_templates_added " << stats.templates_added << '\n'
+       << "flt_templater_templates_updated " << stats.templates_updated
+       << '\n'
+       << "flt_templater_param_table_reductions "
+       << stats.param_table_reductions << '\n'
+       << "flt_templater_templates_split " << stats.templates_split << '\n';
+    write_histogram(os, "flt_templater_similarity_calls_per_line",
+                    stats.similarity_calls_per_line);
+    write_histogram(os, "flt_templater_line_latency_ns",
+                    stats.line_latency_ns);
+    write_histogram(os, "flt_templater_split_templ_ns", stats.split_templ_ns);
+  }
+  os << "flt_templater_length_buckets " << stats.length_buckets << '\n'
+     << "flt_templater_token_buckets " << stats.token_buckets << '\n'
+     << "flt_templater_templates " << stats.templates << '\n';
+  write_histogram(os, "flt_templater_token_buckets_per_length_bucket",
+                  stats.token_buckets_per_length_bucket);
+  write_histogram(os, "flt_templater_templates_per_length_bucket",
+                  stats.templates_per_length_bucket);
+  write_histogram(os, "flt_templater_templates_per_token_bucket",
+                  stats.templates_per_token_bucket);
+}
+} // namespace online
+} // namespace flt::templating
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef FLT_UTIL_BOUNDED_QUEUE_HPP
+#define FLT_UTIL_BOUNDED_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace flt::util {
+inline namespace queues {
+// Bounded lock-free multi-producer multi-consumer queue after Dmitry Vyukov.
+// Every cell carries a sequence number telling producers and consumers
+// whether it is free for the current lap, so both sides only contend on
+// their own position counter.
+template <typename T> class bounded_queue {
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+public:
+  // The capacity is rounded up to a power of two
+  explicit bounded_queue(std::size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument{"Queue capacity must not be zero"};
+    auto size = std::size_t{2};
+    while (size < capacity)
+      size *= 2;
+    cells_ = std::make_unique<cell[]>(size);
+    mask_ = size - 1;
+    for (auto i = std::size_t{0}; i < size; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bounded_queue(const bounded_queue&) = delete;
+  bounded_queue& operator=(const bounded_queue&) = delete;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  // Only a snapshot while other threads use the queue
+  std::size_t size() const {
+    const auto dequeue_pos = dequeue_pos_.load(std::memory_order_relaxed);
+    const auto enqueue_pos = enqueue_pos_.load(std::memory_order_relaxed);
+    return enqueue_pos > dequeue_pos
+               ? std::min(enqueue_pos - dequeue_pos, capacity())
+               : 0;
+  }
+
+  // The value is only moved from if it was pushed
+  bool try_push(T& value) {
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& c = cells_[pos & mask_];
+      const auto sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          c.value = std::move(value);
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& value) {
+    auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto& c = cells_[pos & mask_];
+      const auto sequence = c.sequence.load(std::memory_order_acquire);
+      const auto diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          value = std::move(c.value);
+          c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Blocking variants, they yield while the queue is full or empty and sleep
+  // once it stays so, so idle threads don't keep a core busy. Return whether
+  // they had to wait.
+  bool push(T value) {
+    auto num_waits = 0u;
+    while (!try_push(value))
+      wait(num_waits++);
+    return num_waits > 0;
+  }
+
+  bool pop(T& value) {
+    auto num_waits = 0u;
+    while (!try_pop(value))
+      wait(num_waits++);
+    return num_waits > 0;
+  }
+
+private:
+  static void wait(unsigned int num_waits) {
+    if (num_waits < 64)
+      std::this_thread::yield();
+    else if (num_waits < 256)
+      std::this_thread::sleep_for(std::chrono::microseconds{50});
+    else
+      std::this_thread::sleep_for(std::chrono::milliseconds{5});
+  }
+
+  std::unique_ptr<cell[]> cells_;
+  std::size_t mask_;
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+};
+} // namespace queues
+} // namespace flt::util
+
+#endif
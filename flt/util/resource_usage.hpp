@@ -0,0 +1,50 @@
+#ifndef FLT_UTIL_RESOURCE_USAGE_HPP
+#define FLT_UTIL_RESOURCE_USAGE_HPP
+
+#include <cstddef>
+#include <ctime>
+
+#if __has_include(<sys/resource.h>)
+#define FLT_UTIL_HAVE_RUSAGE
+#include <sys/resource.h>
+#endif
+
+namespace flt::util {
+// CPU time the calling thread has used, 0 where not available
+inline double thread_cpu_seconds() {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+  auto time = timespec{};
+  if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+    return double(time.tv_sec) + double(time.tv_nsec) * 1e-9;
+#endif
+  return 0.;
+}
+
+// User and system CPU time of all threads of the process
+inline double process_cpu_seconds() {
+#ifdef FLT_UTIL_HAVE_RUSAGE
+  auto usage = rusage{};
+  if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+  return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// Peak resident set size of the process in bytes, 0 where not available
+inline std::size_t peak_rss_bytes() {
+#ifdef FLT_UTIL_HAVE_RUSAGE
+  auto usage = rusage{};
+  if (::getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef __APPLE__
+    return std::size_t(usage.ru_maxrss);
+#else
+    // Linux and the BSDs report kilobytes
+    return std::size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+  return 0;
+}
+} // namespace flt::util
+
+#endif
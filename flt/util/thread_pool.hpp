@@ -0,0 +1,118 @@
+#ifndef FLT_UTIL_THREAD_POOL_HPP
+#define FLT_UTIL_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace flt::util {
+inline namespace pools {
+// Threads kept for running batches of indexed tasks. The calling thread runs
+// tasks too, so a pool of n threads starts n - 1. Tasks are handed out one
+// index at a time, so uneven tasks balance out.
+class thread_pool {
+public:
+  explicit thread_pool(
+      unsigned int num_threads = std::max(std::thread::hardware_concurrency(),
+                                          1u)) {
+    for (auto i = 1u; i < num_threads; ++i)
+      workers_.emplace_back([this] { work(); });
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  ~thread_pool() {
+    {
+      auto lock = std::lock_guard{mtx_};
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+
+  unsigned int size() const { return unsigned(workers_.size()) + 1; }
+
+  // Calls task(i) for every i in [0, num_tasks) and returns once all calls
+  // returned. The first exception thrown by a task is rethrown, tasks not
+  // started yet are skipped then. Not to be called concurrently.
+  template <typename Task> void run(std::size_t num_tasks, Task task) {
+    if (workers_.empty() || num_tasks <= 1) {
+      for (auto i = std::size_t{0}; i < num_tasks; ++i)
+        task(i);
+      return;
+    }
+    {
+      auto lock = std::lock_guard{mtx_};
+      job_ = &task;
+      call_ = [](void* job, std::size_t i) { (*static_cast<Task*>(job))(i); };
+      num_tasks_ = num_tasks;
+      next_.store(0, std::memory_order_relaxed);
+      busy_ = workers_.size();
+      ++generation_;
+    }
+    start_cv_.notify_all();
+    run_tasks();
+    auto lock = std::unique_lock{mtx_};
+    done_cv_.wait(lock, [this] { return busy_ == 0; });
+    if (error_)
+      std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+
+private:
+  void run_tasks() {
+    for (auto i = next_.fetch_add(1, std::memory_order_relaxed);
+         i < num_tasks_; i = next_.fetch_add(1, std::memory_order_relaxed)) {
+      try {
+        call_(job_, i);
+      } catch (...) {
+        auto lock = std::lock_guard{mtx_};
+        if (!error_)
+          error_ = std::current_exception();
+        next_.store(num_tasks_, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Every worker takes part in every run, so run knows when all are done
+  void work() {
+    auto seen = std::size_t{0};
+    for (;;) {
+      {
+        auto lock = std::unique_lock{mtx_};
+        start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_)
+          return;
+        seen = generation_;
+      }
+      run_tasks();
+      auto lock = std::lock_guard{mtx_};
+      if (--busy_ == 0)
+        done_cv_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mtx_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  bool stop_{false};
+  std::size_t generation_{0};
+  std::size_t busy_{0};
+  void* job_{nullptr};
+  void (*call_)(void*, std::size_t){nullptr};
+  std::size_t num_tasks_{0};
+  std::atomic<std::size_t> next_{0};
+  std::exception_ptr error_;
+};
+} // namespace pools
+} // namespace flt::util
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef FLT_TESTS_ALLOCATION_COUNTER_HPP
+#define FLT_TESTS_ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions to count the allocations of a
+// test. Only to be included by the one translation unit of a test, as the
+// replacements mustn't be defined twice in a program.
+namespace allocation_counter {
+inline std::size_t num_allocations = 0;
+} // namespace allocation_counter
+
+void* operator new(std::size_t size) {
+  ++allocation_counter::num_allocations;
+  if (auto* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return ::operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return ::operator new(size, std::nothrow);
+}
+
+// Not inlined, as GCC would take the freeing of memory from operator new
+// for a mismatch
+[[gnu::noinline]] void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { ::operator delete(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+  ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  ::operator delete(ptr);
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef FLT_TESTS_SAMPLE_LINES_HPP
+#define FLT_TESTS_SAMPLE_LINES_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+// Log lines shared by the filter tests and benchmarks
+namespace sample_lines {
+// Lines with parameters of most of the default filters, and without any
+inline const std::vector<std::string> samples = {
+    "Oct 18 10:00:00 host0 Connection closed by 10.0.32.130 port 8727",
+    "uuid {123e4567-e89b-12d3-a456-426614174000} mac 00:1A:2b:3c:4D:5e",
+    "addr fe80::1ff:fe23:4567:890a and [2001:db8::1]:8080 ::1",
+    "read 12.5 MiB in 300ms, free 2G of 16 kB, took 3 seconds",
+    "pointer 0xDEADbeef <obj at 0x7f> [worker 3] x=-12,y=(7)",
+    "audit(1634551200.123:42): avc denied on eth0",
+    "[at 10.0.0.1 and 0x10] id=99999999999999999999 (-0)",
+    "no parameters in this line at all",
+    ""};
+
+// The samples in turn, each numbered so no two lines are equal
+inline std::vector<std::string> numbered(unsigned int num_lines) {
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i)
+    lines.push_back(samples[i % samples.size()] + " #" + std::to_string(i));
+  return lines;
+}
+
+// Mostly repeated samples like heartbeats, every tenth numbered
+inline std::vector<std::string> repeated(unsigned int num_lines,
+                                         unsigned int seed) {
+  auto rng = std::mt19937{seed};
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    auto line = samples[rng() % samples.size()];
+    if (rng() % 10 == 0)
+      line += " #" + std::to_string(i);
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+// The samples and the extra ones in turn with random text between them,
+// which has a sample spliced into every third line. The text is made of
+// characters the filters look for, to get close to their corner cases.
+inline std::vector<std::string>
+noisy(unsigned int num_lines, const std::vector<std::string>& extra,
+      unsigned int seed) {
+  auto all = samples;
+  all.insert(all.end(), extra.begin(), extra.end());
+  const auto alphabet =
+      std::string{"0123456789abcdefxABCDEFMKGTPiBms :.-/[]<>(){}=,#@%+"
+                  "\"'\\\tetnhwlopsuadiAug\r_"};
+  auto rng = std::mt19937{seed};
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    if (i % 2 == 0) {
+      lines.push_back(all[i / 2 % all.size()]);
+      continue;
+    }
+    auto line = std::string{};
+    const auto length = rng() % 60;
+    for (auto j = 0u; j < length; ++j)
+      line += alphabet[rng() % alphabet.size()];
+    if (i % 3 == 0)
+      line.insert(line.size() / 2, all[rng() % all.size()]);
+    lines.push_back(std::move(line));
+  }
+  return lines;
+}
+
+inline double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+} // namespace sample_lines
+
+#endif
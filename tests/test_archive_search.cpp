@@ -0,0 +1,166 @@
+#include <flt/io/archive_search.hpp>
+#include <flt/io/template_archive.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct log_line {
+  std::string text;
+  bool is_login;
+  unsigned int port;
+};
+
+std::vector<log_line> make_log(unsigned int num_lines) {
+  auto lines = std::vector<log_line>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    const auto prefix = "Oct 18 10:" + std::to_string(10 + i / 6000 % 50) +
+                        ":" + std::to_string(10 + i / 100 % 50) + " host" +
+                        std::to_string(i % 7);
+    const auto port = 40000 + i * 7919 % 20000;
+    switch (i % 5) {
+    case 0:
+      lines.push_back({prefix + " sshd[" + std::to_string(1000 + i % 97) +
+                           "]: Accepted publickey for user" +
+                           std::to_string(i % 31) + " port " +
+                           std::to_string(port) + " ssh2",
+                       true, port});
+      break;
+    case 1:
+      lines.push_back({prefix + " kernel: eth0: link up, speed " +
+                           std::to_string(i % 2 ? 1000 : 100) + " Mbps",
+                       false, 0});
+      break;
+    case 2:
+      lines.push_back({prefix + " cron[" + std::to_string(2000 + i % 89) +
+                           "]: (root) CMD (run-parts /etc/cron.hourly)",
+                       false, 0});
+      break;
+    case 3:
+      lines.push_back({prefix + " app: request id=" + std::to_string(i) +
+                           " user=alice" + std::to_string(i % 3) +
+                           " status=200",
+                       false, 0});
+      break;
+    default:
+      lines.push_back({prefix + " app: cache miss for key session:" +
+                           std::to_string(i % 1000),
+                       false, 0});
+    }
+  }
+  return lines;
+}
+
+std::vector<std::string> search(const std::string& data,
+                                const flt::io::archive_query& query) {
+  auto in = std::istringstream{data};
+  auto reader = flt::io::archive_reader{in};
+  auto block = flt::io::archive_block{};
+  auto lines = std::vector<std::string>{};
+  while (reader.next_block(block))
+    query.search(block, &lines);
+  return lines;
+}
+
+std::vector<std::string> grep(const std::vector<log_line>& log,
+                              const std::string& text) {
+  auto lines = std::vector<std::string>{};
+  for (const auto& line : log)
+    if (line.text.find(text) != std::string::npos)
+      lines.push_back(line.text);
+  return lines;
+}
+
+template <typename F> double time_it(F f) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+  f();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(t_end - t_start).count();
+}
+} // namespace
+
+int main() {
+  using flt::io::archive_query;
+  using flt::io::compare_op;
+
+  const auto log = make_log(200000);
+  auto data = std::string{};
+  {
+    auto out = std::ostringstream{};
+    auto writer = flt::io::archive_writer{out, {16384, 6}};
+    for (const auto& line : log)
+      writer.add(line.text);
+    writer.close();
+    data = out.str();
+  }
+
+  // Texts within static pieces, spanning parameters and within parameters
+  for (const auto* text :
+       {"Accepted publickey", "user1 port 4", "=alice2 ", "ssion:99",
+        "host3 kernel", "10:11:1", "7 cron[20", "no such text", "", " ",
+        "s:0", "run-parts /etc"}) {
+    if (search(data, archive_query{text}) != grep(log, text)) {
+      std::cerr << "Search for \"" << text << "\" differs from grep"
+                << std::endl;
+      return -1;
+    }
+  }
+
+  // Parameter predicates, the slots count the parameters of the timestamp
+  // and host name too
+  {
+    auto query = archive_query{"Accepted"};
+    query.template_contains("port <*> <*>")
+        .where(7, compare_op::greater_equal, "55000")
+        .where(7, compare_op::less, "56000");
+    auto expected = std::vector<std::string>{};
+    for (const auto& line : log)
+      if (line.is_login && line.port >= 55000 && line.port < 56000)
+        expected.push_back(line.text);
+    const auto found = search(data, query);
+    if (found != expected || found.empty()) {
+      std::cerr << "Parameter search found " << found.size() << " instead of "
+                << expected.size() << " lines" << std::endl;
+      return -1;
+    }
+  }
+  {
+    auto query = archive_query{};
+    query.template_contains("user=<*> status=<*>")
+        .where(6, compare_op::equal, "alice2");
+    auto expected = std::vector<std::string>{};
+    for (const auto& line : grep(log, " user=alice2 "))
+      expected.push_back(line);
+    if (search(data, query) != expected) {
+      std::cerr << "String parameter search differs" << std::endl;
+      return -1;
+    }
+  }
+
+  // A rare message type only needs the template ids of most blocks
+  const auto text = std::string{"Accepted publickey for user7 port 4"};
+  auto num_found = std::size_t{0};
+  auto search_time = time_it([&] {
+    num_found = search(data, archive_query{text}).size();
+  });
+  auto num_grepped = std::size_t{0};
+  auto grep_time = time_it([&] { num_grepped = grep(log, text).size(); });
+  auto in = std::istringstream{data};
+  auto reader = flt::io::archive_reader{in};
+  auto block = flt::io::archive_block{};
+  auto lines = std::vector<std::string>{};
+  auto decode_time = time_it([&] {
+    while (reader.next_block(block))
+      block.decode_lines(lines);
+  });
+  std::cout << num_found << " lines found in " << search_time
+            << " s, decoding all lines takes " << decode_time
+            << " s, searching the raw lines " << grep_time << " s"
+            << std::endl;
+  if (num_found != num_grepped)
+    return -1;
+}
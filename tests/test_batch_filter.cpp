@@ -0,0 +1,85 @@
+#include <flt/parameter_filter/batch_filter.hpp>
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/util/thread_pool.hpp>
+
+#include "sample_lines.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main() {
+  namespace pf = flt::parameter_filter;
+
+  // Every task runs once, the first exception is passed on
+  {
+    auto pool = flt::util::thread_pool{4};
+    auto counts = std::vector<std::atomic<int>>(1000);
+    pool.run(counts.size(), [&](std::size_t i) { ++counts[i]; });
+    pool.run(counts.size(), [&](std::size_t i) { ++counts[i]; });
+    for (const auto& count : counts)
+      if (count != 2) {
+        std::cerr << "Tasks not run once per batch" << std::endl;
+        return -1;
+      }
+    auto thrown = false;
+    try {
+      pool.run(100, [](std::size_t i) {
+        if (i == 42)
+          throw std::runtime_error{"task failed"};
+      });
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    if (!thrown || pool.size() != 4) {
+      std::cerr << "Task exception not passed on" << std::endl;
+      return -1;
+    }
+  }
+
+  // Batches give the same lines as filtering one by one, for any number of
+  // threads and chunk size
+  const auto lines = sample_lines::numbered(70000);
+  auto in = pf::line_buffer{};
+  for (const auto& line : lines)
+    in.push_back(line);
+  auto expected = std::vector<std::string>{};
+  const auto filters = pf::default_filters();
+  const auto t_sequential = std::chrono::steady_clock::now();
+  for (const auto& line : lines)
+    expected.push_back(filters(line));
+  const auto sequential_seconds = sample_lines::seconds_since(t_sequential);
+  std::cout << lines.size() / sequential_seconds << " lines/s one by one"
+            << std::endl;
+
+  for (const auto& [num_threads, chunk_lines] :
+       {std::pair{1u, 256u}, {2u, 7u}, {4u, 256u}, {8u, 1u}}) {
+    auto batch = pf::batch_filter{pf::default_filters(), num_threads,
+                                  chunk_lines};
+    auto out = pf::line_buffer{};
+    batch(pf::line_buffer{}, out);
+    if (!out.empty()) {
+      std::cerr << "Empty batch gives lines" << std::endl;
+      return -1;
+    }
+    const auto t_batch = std::chrono::steady_clock::now();
+    batch(in, out);
+    const auto batch_seconds = sample_lines::seconds_since(t_batch);
+    if (out.size() != expected.size()) {
+      std::cerr << "Batch gives " << out.size() << " lines" << std::endl;
+      return -1;
+    }
+    for (auto i = std::size_t{0}; i < expected.size(); ++i)
+      if (out[i] != expected[i]) {
+        std::cerr << "Batch filtered differently: " << lines[i] << std::endl;
+        return -1;
+      }
+    std::cout << lines.size() / batch_seconds << " lines/s with "
+              << num_threads << " threads" << std::endl;
+  }
+}
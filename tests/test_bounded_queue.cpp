@@ -0,0 +1,84 @@
+#include <flt/util/bounded_queue.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+  using flt::util::bounded_queue;
+
+  {
+    auto queue = bounded_queue<int>(3);
+    auto value = 0;
+    for (auto i = 0; i < 4; ++i) {
+      value = i;
+      if (!queue.try_push(value)) {
+        std::cerr << "Push to non-full queue failed" << std::endl;
+        return -1;
+      }
+    }
+    value = 4;
+    if (queue.capacity() != 4 || queue.try_push(value) || value != 4) {
+      std::cerr << "Push to full queue succeeded" << std::endl;
+      return -1;
+    }
+    for (auto i = 0; i < 4; ++i) {
+      if (!queue.try_pop(value) || value != i) {
+        std::cerr << "Values not popped in order" << std::endl;
+        return -1;
+      }
+    }
+    if (queue.try_pop(value)) {
+      std::cerr << "Pop from empty queue succeeded" << std::endl;
+      return -1;
+    }
+  }
+
+  // Every value pushed by several producers is popped exactly once
+  const auto num_producers = 4u;
+  const auto num_consumers = 4u;
+  const auto values_per_producer = std::uint64_t{250000};
+  auto queue = bounded_queue<std::uint64_t>(64);
+  auto sums = std::vector<std::uint64_t>(num_consumers, 0);
+  auto counts = std::vector<std::uint64_t>(num_consumers, 0);
+  auto t_start = std::chrono::high_resolution_clock::now();
+  auto threads = std::vector<std::thread>{};
+  for (auto p = 0u; p < num_producers; ++p)
+    threads.emplace_back([&queue, p, values_per_producer] {
+      for (auto i = std::uint64_t{0}; i < values_per_producer; ++i)
+        queue.push(p * values_per_producer + i + 1);
+    });
+  for (auto c = 0u; c < num_consumers; ++c)
+    threads.emplace_back([&, c] {
+      auto value = std::uint64_t{0};
+      // A zero tells the consumer to stop
+      for (queue.pop(value); value != 0; queue.pop(value)) {
+        sums[c] += value;
+        ++counts[c];
+      }
+    });
+  for (auto p = 0u; p < num_producers; ++p)
+    threads[p].join();
+  for (auto c = 0u; c < num_consumers; ++c)
+    queue.push(0);
+  for (auto c = 0u; c < num_consumers; ++c)
+    threads[num_producers + c].join();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> duration = t_end - t_start;
+
+  const auto num_values = num_producers * values_per_producer;
+  auto sum = std::uint64_t{0};
+  auto count = std::uint64_t{0};
+  for (auto c = 0u; c < num_consumers; ++c) {
+    sum += sums[c];
+    count += counts[c];
+  }
+  std::cout << count << " values in " << duration.count() << " s"
+            << std::endl;
+  if (count != num_values || sum != num_values * (num_values + 1) / 2) {
+    std::cerr << "Values lost or duplicated" << std::endl;
+    return -1;
+  }
+}
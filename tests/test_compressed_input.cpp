@@ -0,0 +1,193 @@
+#include <flt/io/line_reader.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::vector<std::string> reader_lines(const std::string& filename,
+                                      bool allow_mmap,
+                                      std::size_t buffer_size = 1 << 20) {
+  auto reader = flt::io::line_reader{filename, allow_mmap, buffer_size};
+  auto lines = std::vector<std::string>{};
+  for (auto line = std::string_view{}; reader.next(line);)
+    lines.emplace_back(line);
+  return lines;
+}
+
+std::string make_log(unsigned int num_lines, unsigned int offset = 0) {
+  auto log = std::string{};
+  for (auto i = offset; i < offset + num_lines; ++i)
+    log += "Oct 18 10:00:00 host" + std::to_string(i % 7) +
+           " sshd[1234]: Accepted publickey for user" +
+           std::to_string(i % 31) + " port " + std::to_string(i) + " ssh2\n";
+  return log;
+}
+
+std::vector<std::string> split_lines(const std::string& text) {
+  auto lines = std::vector<std::string>{};
+  for (auto begin = std::size_t{0}, end = text.find('\n', begin);
+       end != std::string::npos; begin = end + 1, end = text.find('\n', begin))
+    lines.push_back(text.substr(begin, end - begin));
+  return lines;
+}
+
+#ifdef FLT_HAVE_ZLIB
+// Appends a gzip member to the file
+void write_gzip(const std::string& filename, const std::string& text) {
+  auto* file = gzopen(filename.c_str(), "ab6");
+  gzwrite(file, text.data(), unsigned(text.size()));
+  gzclose(file);
+}
+#endif
+
+// Writes the first size bytes of the file to a new file
+void write_prefix(const std::string& filename, const std::string& prefix_name,
+                  std::size_t size) {
+  auto fin = std::ifstream{filename, std::ios::binary};
+  auto data = std::string{std::istreambuf_iterator<char>{fin},
+                          std::istreambuf_iterator<char>{}};
+  auto fout = std::ofstream{prefix_name, std::ios::binary};
+  fout << data.substr(0, size);
+}
+
+bool reading_throws(const std::string& filename) {
+  try {
+    reader_lines(filename, true);
+  } catch (const std::exception&) {
+    return true;
+  }
+  return false;
+}
+
+template <typename F> double time_it(F f) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+  f();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(t_end - t_start).count();
+}
+} // namespace
+
+int main() {
+  using namespace flt::io;
+
+  if (detect_compression("\x1f\x8b\x08") != compression::gzip ||
+      detect_compression("\x28\xb5\x2f\xfd") != compression::zstd ||
+      detect_compression("Oct 18") != compression::none ||
+      detect_compression("\x1f") != compression::none) {
+    std::cerr << "Wrong compression detected" << std::endl;
+    return -1;
+  }
+
+#ifdef FLT_HAVE_ZLIB
+  {
+    // Two gzip members, as left behind by appending to a compressed log
+    const auto filename = std::string{"test_compressed_input.gz"};
+    std::remove(filename.c_str());
+    const auto first = make_log(1000);
+    const auto second = make_log(1000, 1000);
+    write_gzip(filename, first);
+    write_gzip(filename, second);
+    const auto expected = split_lines(first + second);
+    for (auto allow_mmap : {true, false}) {
+      for (auto buffer_size : {std::size_t{7}, std::size_t{1} << 20}) {
+        if (reader_lines(filename, allow_mmap, buffer_size) != expected) {
+          std::cerr << "Decompressed lines differ, mmap " << allow_mmap
+                    << ", buffer size " << buffer_size << std::endl;
+          return -1;
+        }
+      }
+    }
+
+    // Corrupt input is reported, at the latest by the checksum
+    {
+      auto fin = std::ifstream{filename, std::ios::binary};
+      auto compressed = std::string{std::istreambuf_iterator<char>{fin},
+                                    std::istreambuf_iterator<char>{}};
+      auto fout = std::ofstream{"test_compressed_input_corrupt.gz",
+                                std::ios::binary};
+      compressed[compressed.size() / 2] ^= 0x55;
+      fout << compressed;
+    }
+    if (!reading_throws("test_compressed_input_corrupt.gz")) {
+      std::cerr << "Corrupt input not detected" << std::endl;
+      return -1;
+    }
+
+    // Input ending within a member is reported instead of giving less lines
+    write_prefix(filename, "test_compressed_input_truncated.gz", 400);
+    if (!reading_throws("test_compressed_input_truncated.gz")) {
+      std::cerr << "Truncated input not detected" << std::endl;
+      return -1;
+    }
+  }
+
+  {
+    // Throughput compared to decompressing with zlib alone
+    const auto filename = std::string{"test_compressed_input_large.gz"};
+    std::remove(filename.c_str());
+    write_gzip(filename, make_log(1000000));
+    auto raw_bytes = std::size_t{0};
+    auto raw_time = time_it([&] {
+      auto* file = gzopen(filename.c_str(), "rb");
+      gzbuffer(file, 1 << 20);
+      auto buffer = std::vector<char>(1 << 20);
+      for (int num_read; (num_read = gzread(file, buffer.data(),
+                                            unsigned(buffer.size()))) > 0;)
+        raw_bytes += std::size_t(num_read);
+      gzclose(file);
+    });
+    auto reader_bytes = std::size_t{0};
+    auto reader_time = time_it([&] {
+      auto reader = line_reader{filename};
+      for (auto line = std::string_view{}; reader.next(line);)
+        reader_bytes += line.size() + 1;
+    });
+    std::cout << "gzip: line_reader " << reader_time << " s, gzread "
+              << raw_time << " s for " << raw_bytes << " bytes" << std::endl;
+    if (reader_bytes != raw_bytes) {
+      std::cerr << "Byte counts differ from gzread" << std::endl;
+      return -1;
+    }
+  }
+#else
+  std::cout << "Built without zlib, skipping gzip tests" << std::endl;
+#endif
+
+#ifdef FLT_HAVE_ZSTD
+  {
+    const auto filename = std::string{"test_compressed_input.zst"};
+    const auto text = make_log(1000);
+    auto compressed = std::string(ZSTD_compressBound(text.size()), '\0');
+    compressed.resize(ZSTD_compress(compressed.data(), compressed.size(),
+                                    text.data(), text.size(), 3));
+    {
+      auto fout = std::ofstream{filename, std::ios::binary};
+      fout << compressed << compressed;
+    }
+    auto expected = split_lines(text + text);
+    for (auto allow_mmap : {true, false}) {
+      if (reader_lines(filename, allow_mmap) != expected) {
+        std::cerr << "Decompressed lines differ for zstd, mmap " << allow_mmap
+                  << std::endl;
+        return -1;
+      }
+    }
+
+    write_prefix(filename, "test_compressed_input_truncated.zst",
+                 compressed.size() + compressed.size() / 2);
+    if (!reading_throws("test_compressed_input_truncated.zst")) {
+      std::cerr << "Truncated zstd input not detected" << std::endl;
+      return -1;
+    }
+  }
+#else
+  std::cout << "Built without libzstd, skipping zstd tests" << std::endl;
+#endif
+}
@@ -0,0 +1,115 @@
+#include <flt/logline/event_assembler.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+using flt::logline::event_assembler;
+using flt::logline::event_start;
+
+std::vector<std::string> assemble(event_assembler& assembler,
+                                  const std::vector<std::string>& lines) {
+  auto events = std::vector<std::string>{};
+  for (const auto& line : lines)
+    if (assembler.push(line))
+      events.emplace_back(assembler.event());
+  if (assembler.flush())
+    events.emplace_back(assembler.event());
+  return events;
+}
+} // namespace
+
+int main() {
+  using flt::logline::starts_event;
+
+  for (const auto* line :
+       {"2024-03-01 12:00:01,123 ERROR boom", "[2024/03/01 12:00:01] x",
+        "12:00:01.5 INFO started", "Mar  1 12:00:01 host sshd[1]: y"})
+    if (!starts_event(line, event_start::timestamp)) {
+      std::cerr << "No event started by " << line << std::endl;
+      return -1;
+    }
+  for (const auto* line :
+       {"\tat com.example.Main.run(Main.java:12)", "Caused by: boom", "",
+        "2024-3-1 12:00 short", "java.lang.IllegalStateException: boom"})
+    if (starts_event(line, event_start::timestamp)) {
+      std::cerr << "Event started by " << line << std::endl;
+      return -1;
+    }
+  for (const auto* line :
+       {"\tat com.example.Main.run(Main.java:12)", "Caused by: boom", ""})
+    if (starts_event(line, event_start::unindented)) {
+      std::cerr << "Event started by " << line << std::endl;
+      return -1;
+    }
+  if (!starts_event("<13>Mar  1 12:00:01 host app: x",
+                    event_start::syslog_header) ||
+      !starts_event("Mar 11 12:00:01 host app: x",
+                    event_start::syslog_header) ||
+      starts_event("<13 x", event_start::syslog_header) ||
+      starts_event("  wrapped text", event_start::syslog_header)) {
+    std::cerr << "Wrong syslog header detection" << std::endl;
+    return -1;
+  }
+
+  // Stack traces are joined to the line starting them
+  {
+    const auto lines = std::vector<std::string>{
+        "continued before the first event",
+        "2024-03-01 12:00:01 ERROR request failed",
+        "java.lang.IllegalStateException: boom",
+        "\tat com.example.Main.run(Main.java:12)",
+        "Caused by: java.io.IOException: closed",
+        "\t... 3 more",
+        "2024-03-01 12:00:02 INFO done"};
+    auto assembler = event_assembler{event_start::timestamp};
+    const auto expected = std::vector<std::string>{
+        "continued before the first event",
+        "2024-03-01 12:00:01 ERROR request failed "
+        "java.lang.IllegalStateException: boom "
+        "at com.example.Main.run(Main.java:12) "
+        "Caused by: java.io.IOException: closed ... 3 more",
+        "2024-03-01 12:00:02 INFO done"};
+    if (assemble(assembler, lines) != expected ||
+        assembler.num_joined() != 4 || assembler.num_events() != 3) {
+      std::cerr << "Wrong events" << std::endl;
+      return -1;
+    }
+  }
+
+  // Pending events are bounded
+  {
+    auto assembler = event_assembler{event_start::unindented, 3};
+    const auto events = assemble(
+        assembler, {"start", " a", " b", " c", " d", "next", " e"});
+    const auto expected =
+        std::vector<std::string>{"start a b", "c d", "next e"};
+    if (events != expected || assembler.num_cut() != 1) {
+      std::cerr << "Pending event not bounded" << std::endl;
+      return -1;
+    }
+  }
+
+  // Lines without continuations pass through unchanged
+  {
+    auto lines = std::vector<std::string>{};
+    for (auto i = 0; i < 200000; ++i)
+      lines.push_back("Mar  1 12:00:01 host" + std::to_string(i % 13) +
+                      " app[" + std::to_string(i) + "]: request " +
+                      std::to_string(i * 7) + " served in 12 ms");
+    auto assembler = event_assembler{event_start::syslog_header};
+    const auto t_start = std::chrono::steady_clock::now();
+    const auto events = assemble(assembler, lines);
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - t_start)
+                             .count();
+    std::cout << lines.size() / seconds << " lines/s assembled" << std::endl;
+    if (events != lines) {
+      std::cerr << "Single line events changed" << std::endl;
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,114 @@
+#include <flt/io/file_follower.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+void write_file(const std::string& filename, const std::string& text,
+                bool append = true) {
+  auto fout = std::ofstream{filename, append ? std::ios::binary | std::ios::app
+                                             : std::ios::binary};
+  fout << text;
+}
+
+// Returns the lines available without waiting
+std::vector<std::string> available_lines(flt::io::file_follower& follower) {
+  auto lines = std::vector<std::string>{};
+  for (auto line = std::string_view{};
+       follower.next(line, std::chrono::milliseconds{0});)
+    lines.emplace_back(line);
+  return lines;
+}
+
+bool expect(flt::io::file_follower& follower,
+            const std::vector<std::string>& expected, const char* what) {
+  const auto lines = available_lines(follower);
+  if (lines == expected)
+    return true;
+  std::cerr << "Wrong lines after " << what << ":";
+  for (const auto& line : lines)
+    std::cerr << " \"" << line << '"';
+  std::cerr << std::endl;
+  return false;
+}
+} // namespace
+
+int main() {
+  const auto filename = std::string{"test_file_follower.log"};
+  const auto rotated = filename + ".1";
+  std::remove(rotated.c_str());
+  write_file(filename, "a\nb\npart", false);
+  auto follower = flt::io::file_follower{filename};
+
+  // Partial lines wait for their newline
+  if (!expect(follower, {"a", "b"}, "opening") ||
+      (write_file(filename, "ial\nc\n"),
+       !expect(follower, {"partial", "c"}, "appending")))
+    return -1;
+
+  // Truncated in place, like logrotate's copytruncate does
+  write_file(filename, "d\n", false);
+  if (!expect(follower, {"d"}, "truncation") ||
+      follower.num_truncations() != 1)
+    return -1;
+
+  // Renamed and replaced, lines written to the old file after the rename and
+  // a partial line at its end are read before the new file
+  write_file(filename, "e\nf");
+  std::rename(filename.c_str(), rotated.c_str());
+  write_file(rotated, "g\nh");
+  write_file(filename, "i\n", false);
+  if (!expect(follower, {"e", "fg", "h", "i"}, "rotation") ||
+      follower.num_rotations() != 1)
+    return -1;
+
+  // Deleted and only recreated later
+  std::remove(filename.c_str());
+  if (!expect(follower, {}, "deletion"))
+    return -1;
+  write_file(filename, "j\n", false);
+  if (!expect(follower, {"j"}, "recreation") ||
+      follower.num_rotations() != 2)
+    return -1;
+
+  // Lines appended by another process arrive while waiting
+  for (auto i = 0; i < 5; ++i) {
+    auto t_write = std::chrono::steady_clock::now();
+    auto writer = std::thread{[&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+      t_write = std::chrono::steady_clock::now();
+      write_file(filename, "k\n");
+    }};
+    auto line = std::string_view{};
+    const auto found = follower.next(line, std::chrono::seconds{5});
+    const auto t_read = std::chrono::steady_clock::now();
+    writer.join();
+    if (!found || line != "k") {
+      std::cerr << "Appended line not read while waiting" << std::endl;
+      return -1;
+    }
+    std::cout << (follower.uses_inotify() ? "inotify" : "polling")
+              << " latency: "
+              << std::chrono::duration<double, std::milli>(t_read - t_write)
+                     .count()
+              << " ms" << std::endl;
+  }
+
+  // Followers starting at the end skip the existing lines
+  auto tail = flt::io::file_follower{filename, false};
+  write_file(filename, "l\n");
+  if (!expect(tail, {"l"}, "starting at the end") ||
+      !expect(follower, {"l"}, "appending"))
+    return -1;
+  auto line = std::string_view{};
+  if (follower.next(line, std::chrono::milliseconds{50})) {
+    std::cerr << "Line read without being appended" << std::endl;
+    return -1;
+  }
+}
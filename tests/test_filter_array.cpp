@@ -0,0 +1,84 @@
+#include <flt/parameter_filter/default_filters.hpp>
+
+#include "allocation_counter.hpp"
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int main() {
+  using allocation_counter::num_allocations;
+  using params_type = std::vector<std::string>;
+  const auto filters = flt::parameter_filter::default_filters<
+      std::back_insert_iterator<params_type>>();
+  const auto lines = sample_lines::numbered(70000);
+
+  // Filtering into buffers gives the same lines and parameters
+  auto expected = std::vector<std::string>{};
+  auto expected_params = params_type{};
+  const auto t_returned = std::chrono::steady_clock::now();
+  for (const auto& line : lines)
+    expected.push_back(filters(line, std::back_inserter(expected_params)));
+  const auto returned_seconds = sample_lines::seconds_since(t_returned);
+  auto params = params_type{};
+  auto filtered = std::string{};
+  for (auto i = std::size_t{0}; i < lines.size(); ++i) {
+    filters.filter_into(lines[i], filtered, std::back_inserter(params));
+    auto in_place = lines[i];
+    filters.filter_into(in_place, in_place);
+    if (filtered != expected[i] || in_place != expected[i]) {
+      std::cerr << "Filtered into buffer differently: " << lines[i]
+                << std::endl;
+      return -1;
+    }
+  }
+  if (params != expected_params) {
+    std::cerr << "Different parameters extracted into buffer" << std::endl;
+    return -1;
+  }
+
+  // Lines without parameters are skipped by every filter
+  {
+    auto hits = std::vector<std::uint64_t>{};
+    auto skips = std::vector<std::uint64_t>{};
+    const auto line = std::string{"ok"};
+    if (filters.filter_and_count(line, filtered, hits, &skips) ||
+        skips != std::vector<std::uint64_t>(filters.size(), 1) ||
+        hits != std::vector<std::uint64_t>(filters.size(), 0)) {
+      std::cerr << "Wrong filter counts" << std::endl;
+      return -1;
+    }
+  }
+
+  // Buffers keep their capacity, so filtering doesn't allocate once they
+  // are large enough. Only the regexes of filters without a scanner still
+  // allocate internally.
+  const auto t_buffered = std::chrono::steady_clock::now();
+  const auto allocations_start = num_allocations;
+  for (const auto& line : lines)
+    filters.filter_into(line, filtered);
+  const auto allocations_per_line =
+      double(num_allocations - allocations_start) / double(lines.size());
+  const auto buffered_seconds = sample_lines::seconds_since(t_buffered);
+  std::cout << lines.size() / returned_seconds << " lines/s returned, "
+            << lines.size() / buffered_seconds << " lines/s into buffers, "
+            << allocations_per_line << " allocations per line" << std::endl;
+  const auto scanned_lines = std::vector<std::string>{
+      "read 12.5 MiB in 300ms, free 2G of 16 kB, took 3 seconds",
+      "pointer 0xDEADbeef <obj at 0x7f> [worker 3] x=-12,y=(7)"};
+  for (const auto& line : scanned_lines)
+    filters.filter_into(line, filtered);
+  const auto scanned_start = num_allocations;
+  for (auto i = 0; i < 1000; ++i)
+    for (const auto& line : scanned_lines)
+      filters.filter_into(line, filtered);
+  if (num_allocations != scanned_start) {
+    std::cerr << "Filtering into buffers allocates" << std::endl;
+    return -1;
+  }
+}
@@ -0,0 +1,85 @@
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/parameter_filter/filter_cache.hpp>
+
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main() {
+  namespace pf = flt::parameter_filter;
+  using namespace std::literals::string_literals;
+  using params_type = std::vector<std::string>;
+
+  // Entries hit since the clock hand passed them are kept
+  {
+    const auto cache = pf::filter_cache{
+        pf::filter_array<std::back_insert_iterator<params_type>, std::string>{
+            pf::regex_filter{"[0-9]+"s}},
+        2, 1};
+    auto params = params_type{};
+    if (cache("a 1"s) != "a $v" || cache("b 2"s) != "b $v" ||
+        cache("a 1"s) != "a $v" || cache("c 3"s) != "c $v" ||
+        cache("a 1"s) != "a $v" ||
+        cache("a 1"s, std::back_inserter(params)) != "a $v" ||
+        params != params_type{"1"} || cache.stats().hits != 2 ||
+        cache.stats().misses != 4 || cache.stats().evictions != 1) {
+      std::cerr << "Wrong cache hits" << std::endl;
+      return -1;
+    }
+  }
+
+  // Cached lines and parameters are the same as filtered ones, also with
+  // more lines than fit into the cache and from several threads
+  const auto cache = pf::filter_cache{
+      pf::default_filters<std::back_insert_iterator<params_type>>(), 1000};
+  const auto& filters = cache.filters();
+  const auto lines = sample_lines::repeated(100000, 48);
+  auto expected = std::vector<std::string>{};
+  auto expected_params = params_type{};
+  const auto t_filtered = std::chrono::steady_clock::now();
+  for (const auto& line : lines)
+    expected.push_back(filters(line, std::back_inserter(expected_params)));
+  const auto filtered_seconds = sample_lines::seconds_since(t_filtered);
+
+  auto filtered = std::vector<std::string>{};
+  auto params = params_type{};
+  const auto t_cached = std::chrono::steady_clock::now();
+  for (const auto& line : lines)
+    filtered.push_back(cache(line, std::back_inserter(params)));
+  const auto cached_seconds = sample_lines::seconds_since(t_cached);
+  if (filtered != expected || params != expected_params) {
+    std::cerr << "Cache filters differently" << std::endl;
+    return -1;
+  }
+
+  const auto num_threads = 4u;
+  auto threads = std::vector<std::thread>{};
+  auto thread_filtered = std::vector<std::string>(lines.size());
+  for (auto t = 0u; t < num_threads; ++t)
+    threads.emplace_back([&, t] {
+      for (auto i = std::size_t{t}; i < lines.size(); i += num_threads) {
+        thread_filtered[i] = lines[i];
+        cache.filter_into(thread_filtered[i], thread_filtered[i]);
+      }
+    });
+  for (auto& thread : threads)
+    thread.join();
+  if (thread_filtered != expected) {
+    std::cerr << "Cache filters differently from several threads"
+              << std::endl;
+    return -1;
+  }
+
+  const auto stats = cache.stats();
+  std::cout << lines.size() / filtered_seconds << " lines/s filtered, "
+            << lines.size() / cached_seconds << " lines/s cached, "
+            << 100. * stats.hit_rate() << "% hits, " << stats.evictions
+            << " evictions" << std::endl;
+}
@@ -0,0 +1,119 @@
+#include <flt/io/line_reader.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::vector<std::string> getline_lines(const std::string& filename) {
+  auto fin = std::ifstream{filename};
+  auto lines = std::vector<std::string>{};
+  for (auto line = std::string{}; std::getline(fin, line);)
+    lines.push_back(line);
+  return lines;
+}
+
+std::vector<std::string> reader_lines(const std::string& filename,
+                                      bool allow_mmap,
+                                      std::size_t buffer_size) {
+  auto reader = flt::io::line_reader{filename, allow_mmap, buffer_size};
+  auto lines = std::vector<std::string>{};
+  for (auto line = std::string_view{}; reader.next(line);)
+    lines.emplace_back(line);
+  return lines;
+}
+
+template <typename F> double time_it(F f) {
+  auto t_start = std::chrono::high_resolution_clock::now();
+  f();
+  auto t_end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double>(t_end - t_start).count();
+}
+} // namespace
+
+int main() {
+  const auto filename = std::string{"test_line_reader.txt"};
+  const auto contents = std::vector<std::string>{
+      "", "a\nb", "a\n\nb\n", "\n\n", "no newline at end",
+      "line\nlonger than the buffer " + std::string(100, 'x') + "\nend\n"};
+  for (const auto& content : contents) {
+    {
+      auto fout = std::ofstream{filename, std::ios::binary};
+      fout << content;
+    }
+    const auto expected = getline_lines(filename);
+    for (auto allow_mmap : {true, false}) {
+      for (auto buffer_size : {std::size_t{1}, std::size_t{7},
+                               std::size_t{1} << 20}) {
+        if (reader_lines(filename, allow_mmap, buffer_size) != expected) {
+          std::cerr << "Lines differ from std::getline for \"" << content
+                    << "\", mmap " << allow_mmap << ", buffer size "
+                    << buffer_size << std::endl;
+          return -1;
+        }
+      }
+    }
+
+    // A last line without a newline is told apart from one with a newline
+    const auto missing_newline = !content.empty() && content.back() != '\n';
+    for (auto allow_mmap : {true, false}) {
+      auto reader = flt::io::line_reader{filename, allow_mmap, 7};
+      for (auto line = std::string_view{}; reader.next(line);) {
+      }
+      if (reader.missing_newline() != missing_newline) {
+        std::cerr << "Missing final newline not reported for \"" << content
+                  << "\", mmap " << allow_mmap << std::endl;
+        return -1;
+      }
+    }
+
+    // Every line belongs to exactly one part of the file
+    for (auto num_parts = std::size_t{1}; !content.empty() && num_parts <= 9;
+         ++num_parts) {
+      auto lines = std::vector<std::string>{};
+      for (auto part = std::size_t{0}; part < num_parts; ++part) {
+        auto reader = flt::io::line_reader{filename};
+        reader.select_part(part, num_parts);
+        for (auto line = std::string_view{}; reader.next(line);)
+          lines.emplace_back(line);
+      }
+      if (lines != expected) {
+        std::cerr << "Lines of " << num_parts << " parts differ for \""
+                  << content << '"' << std::endl;
+        return -1;
+      }
+    }
+  }
+
+  {
+    auto fout = std::ofstream{filename, std::ios::binary};
+    for (auto i = 0u; i < 1000000u; ++i)
+      fout << "Oct 18 10:00:00 host" << i % 7
+           << " sshd[1234]: Accepted publickey for user" << i % 31
+           << " from 10.0.0." << i % 255 << " port " << i << " ssh2\n";
+  }
+  auto num_bytes = std::size_t{0};
+  auto getline_time = time_it([&] {
+    auto fin = std::ifstream{filename};
+    for (auto line = std::string{}; std::getline(fin, line);)
+      num_bytes += line.size();
+  });
+  for (auto allow_mmap : {true, false}) {
+    auto reader_bytes = std::size_t{0};
+    auto reader_time = time_it([&] {
+      auto reader = flt::io::line_reader{filename, allow_mmap};
+      for (auto line = std::string_view{}; reader.next(line);)
+        reader_bytes += line.size();
+    });
+    std::cout << (allow_mmap ? "mmap" : "read") << ": " << reader_time
+              << " s, std::getline: " << getline_time << " s" << std::endl;
+    if (reader_bytes != num_bytes) {
+      std::cerr << "Byte counts differ from std::getline" << std::endl;
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,120 @@
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/parameter_filter/param_spans.hpp>
+
+#include "allocation_counter.hpp"
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <vector>
+
+int main() {
+  namespace pf = flt::parameter_filter;
+  using namespace std::literals::string_literals;
+  using params_type = std::vector<std::string>;
+
+  // Spans cover the text earlier filters replaced, numbers are parsed
+  {
+    const auto filters = pf::static_filter_pipeline{
+        pf::regex_filter{"b+"s, std::regex_constants::ECMAScript, "X"s},
+        pf::regex_filter{"aXc"s}, pf::scanner_filters::number_constant_filter(),
+        pf::scanner_filters::hexadec_constant_filter()};
+    auto spans = pf::param_spans{};
+    auto filtered = std::string{};
+    filters.filter_spans("abbbc at:12 0x1F"s, filtered, spans);
+    const auto& s = spans.spans;
+    if (filtered != "$v at:$v $v" || s.size() != 4 ||
+        s[0].filter != 0 || s[0].begin != 1 || s[0].length != 3 ||
+        s[1].filter != 1 || s[1].begin != 0 || s[1].length != 5 ||
+        s[2].kind != pf::value_kind::integer || s[2].begin != 9 ||
+        spans.integers[s[2].value] != 12 ||
+        s[3].kind != pf::value_kind::integer || s[3].begin != 12 ||
+        spans.integers[s[3].value] != 31) {
+      std::cerr << "Wrong spans" << std::endl;
+      return -1;
+    }
+  }
+
+  // The spans of the default filters are where the extracted parameters
+  // were in the line, the same for both kinds of pipelines
+  const auto filters =
+      pf::default_filters<std::back_insert_iterator<params_type>>();
+  const auto static_filters = pf::static_default_filters();
+  const auto lines = sample_lines::numbered(70000);
+  auto params = params_type{};
+  auto filtered = std::string{};
+  const auto t_params = std::chrono::steady_clock::now();
+  for (const auto& line : lines) {
+    params.clear();
+    filters.filter_into(line, filtered, std::back_inserter(params));
+  }
+  const auto params_seconds = sample_lines::seconds_since(t_params);
+  auto spans = pf::param_spans{};
+  const auto t_spans = std::chrono::steady_clock::now();
+  for (const auto& line : lines) {
+    spans.clear();
+    filters.filter_spans(line, filtered, spans);
+  }
+  const auto spans_seconds = sample_lines::seconds_since(t_spans);
+
+  auto static_spans = pf::param_spans{};
+  auto static_filtered = std::string{};
+  for (const auto& line : lines) {
+    params.clear();
+    const auto expected = filters(line, std::back_inserter(params));
+    spans.clear();
+    static_spans.clear();
+    filters.filter_spans(line, filtered, spans);
+    static_filters.filter_spans(line, static_filtered, static_spans);
+    if (filtered != expected || static_filtered != expected ||
+        spans.spans.size() != params.size() ||
+        static_spans.spans.size() != params.size()) {
+      std::cerr << "Filtered differently with spans: " << line << std::endl;
+      return -1;
+    }
+    for (auto i = std::size_t{0}; i < params.size(); ++i) {
+      const auto& span = spans.spans[i];
+      const auto& static_span = static_spans.spans[i];
+      const auto text = line.substr(span.begin, span.length);
+      const auto wrong_value =
+          span.kind == pf::value_kind::integer &&
+          spans.integers[span.value] !=
+              std::stoll(params[i], nullptr,
+                         params[i].rfind("0x", 0) == 0 ? 16 : 10);
+      if ((params[i].find('$') == std::string::npos && text != params[i]) ||
+          wrong_value || span.filter != static_span.filter ||
+          span.begin != static_span.begin ||
+          span.length != static_span.length ||
+          span.kind != static_span.kind) {
+        std::cerr << "Wrong span " << text << " for " << params[i] << " in "
+                  << line << std::endl;
+        return -1;
+      }
+    }
+  }
+
+  // Once the buffers are large enough, spans are recorded without allocating
+  const auto scanned_lines = std::vector<std::string>{
+      "read 12.5 MiB in 300ms, free 2G of 16 kB, took 3 seconds",
+      "pointer 0xDEADbeef <obj at 0x7f> [worker 3] x=-12,y=(7)"};
+  for (const auto& line : scanned_lines)
+    filters.filter_spans(line, filtered, spans);
+  const auto scanned_start = allocation_counter::num_allocations;
+  for (auto i = 0; i < 1000; ++i) {
+    spans.clear();
+    for (const auto& line : scanned_lines)
+      filters.filter_spans(line, filtered, spans);
+  }
+  if (allocation_counter::num_allocations != scanned_start) {
+    std::cerr << "Recording spans allocates" << std::endl;
+    return -1;
+  }
+  std::cout << lines.size() / params_seconds << " lines/s extracting strings, "
+            << lines.size() / spans_seconds << " lines/s extracting spans"
+            << std::endl;
+}
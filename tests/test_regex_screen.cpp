@@ -0,0 +1,124 @@
+#include <flt/parameter_filter/common_regex_filters.hpp>
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/parameter_filter/ipv6_address_filter.hpp>
+#include <flt/parameter_filter/regex_screen.hpp>
+
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+using line_filter = std::function<std::string(
+    const std::string&, std::back_insert_iterator<std::vector<std::string>>)>;
+
+// The default filters in the order they are applied
+std::vector<line_filter> unscreened_filters() {
+  using namespace flt::parameter_filter::regex_filters;
+  return {extended_date_filter(),
+          long_date_filter(),
+          date_filter(),
+          time_filter(),
+          UUID_filter(),
+          libvirtd_filter(),
+          flt::parameter_filter::ipv6_address_filter<>(),
+          linux_kernel_audit_filter(),
+          linux_mem_size_filter(),
+          data_size_filter(),
+          time_duration_filter(),
+          linux_netif_filter(),
+          mac_address_filter(),
+          ipv4_address_filter(),
+          hexadec_constant_filter(),
+          square_bracket_filter(),
+          pointed_bracket_filter(),
+          number_constant_filter()};
+}
+
+// Lines with the parameters of the filters the common samples lack
+const std::vector<std::string> extra_samples = {
+    "Mon Oct 18 10:00:00 2021 UTC started",
+    "2021-10-18 10:00:00.123+0000: 4242: info : libvirt version: 7.0",
+    "Tue Oct  5 2021-10-05 10:00:00 CET job done",
+    "link eth0 up, enp0s31f6 down, wlp2s0 at 10/18/21",
+    "GET /index.html?id=99#frag \"user\" 'quoted' 100% @host:22"};
+} // namespace
+
+int main() {
+  using namespace flt::parameter_filter;
+
+  for (const auto* pattern : {R"(\b\d{2}:\d{2}:\d{2}\b)", R"(\[.*?\])",
+                              R"(^\d{4}-\d{2}-\d{2} \d{2})"})
+    if (regex_screen(pattern, false).empty()) {
+      std::cerr << "No clauses for " << pattern << std::endl;
+      return -1;
+    }
+  for (const auto* pattern : {R"((?<=x)y)", R"(\x41)", R"(a*)", R"(.+)"})
+    if (!regex_screen(pattern, false).empty()) {
+      std::cerr << "Clauses for " << pattern << std::endl;
+      return -1;
+    }
+  {
+    const auto screen = multi_screen{{literal_screen("0x"),
+                                      literal_screen("audit(", true)}};
+    if (!screen.may_match(0, screen.scan("at 0x1f")) ||
+        screen.may_match(0, screen.scan("x0 0 x")) ||
+        !screen.may_match(1, screen.scan("AUDIT(1.2:3)")) ||
+        screen.may_match(1, screen.scan("audit 1"))) {
+      std::cerr << "Wrong literal screen" << std::endl;
+      return -1;
+    }
+  }
+  {
+    const auto screen =
+        multi_screen{{regex_screen(R"(\b\d{2}:\d{2}\b)", false),
+                      regex_screen(R"(^x)", false),
+                      regex_screen(R"(\d+\s*[GKM]\b)", true)}};
+    const auto mask = screen.scan("at 10:42 xg 5 k");
+    if (!screen.may_match(0, mask) || screen.may_match(1, mask) ||
+        !screen.may_match(2, mask) ||
+        screen.may_match(0, screen.scan("12: 3"))) {
+      std::cerr << "Wrong screen" << std::endl;
+      return -1;
+    }
+  }
+
+  // Screened filters give the same lines and parameters as applying all
+  // filters in order
+  const auto lines = sample_lines::noisy(20000, extra_samples, 42);
+  const auto filters = unscreened_filters();
+  auto expected = std::vector<std::string>{};
+  auto expected_params = std::vector<std::string>{};
+  const auto t_unscreened = std::chrono::steady_clock::now();
+  for (const auto& line : lines) {
+    auto filtered = line;
+    for (const auto& filter : filters)
+      filtered = filter(filtered, std::back_inserter(expected_params));
+    expected.push_back(std::move(filtered));
+  }
+  const auto unscreened_seconds = sample_lines::seconds_since(t_unscreened);
+
+  auto params = std::vector<std::string>{};
+  const auto screened_filters =
+      default_filters<std::back_insert_iterator<std::vector<std::string>>>();
+  const auto t_screened = std::chrono::steady_clock::now();
+  for (auto i = std::size_t{0}; i < lines.size(); ++i)
+    if (screened_filters(lines[i], std::back_inserter(params)) !=
+        expected[i]) {
+      std::cerr << "Screened filters differ on " << lines[i] << std::endl;
+      return -1;
+    }
+  const auto screened_seconds = sample_lines::seconds_since(t_screened);
+  if (params != expected_params) {
+    std::cerr << "Screened filters extract different parameters" << std::endl;
+    return -1;
+  }
+  std::cout << lines.size() / unscreened_seconds << " lines/s unscreened, "
+            << lines.size() / screened_seconds << " lines/s screened"
+            << std::endl;
+}
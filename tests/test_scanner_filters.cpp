@@ -0,0 +1,114 @@
+#include <flt/parameter_filter/common_regex_filters.hpp>
+#include <flt/parameter_filter/scanner_filters.hpp>
+
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+using line_filter = std::function<std::string(
+    const std::string&, std::back_insert_iterator<std::vector<std::string>>)>;
+
+struct filter_pair {
+  const char* name;
+  line_filter regex;
+  line_filter scanner;
+};
+
+std::vector<filter_pair> filter_pairs() {
+  namespace rf = flt::parameter_filter::regex_filters;
+  namespace sf = flt::parameter_filter::scanner_filters;
+  return {{"pointed_bracket", rf::pointed_bracket_filter(),
+           sf::pointed_bracket_filter()},
+          {"square_bracket", rf::square_bracket_filter(),
+           sf::square_bracket_filter()},
+          {"hexadec_constant", rf::hexadec_constant_filter(),
+           sf::hexadec_constant_filter()},
+          {"mac_address", rf::mac_address_filter(), sf::mac_address_filter()},
+          {"ipv4_address", rf::ipv4_address_filter(),
+           sf::ipv4_address_filter()},
+          {"time_duration", rf::time_duration_filter(),
+           sf::time_duration_filter()},
+          {"data_size", rf::data_size_filter(), sf::data_size_filter()},
+          {"UUID", rf::UUID_filter(), sf::UUID_filter()},
+          {"number_constant", rf::number_constant_filter(),
+           sf::number_constant_filter()},
+          {"time", rf::time_filter(), sf::time_filter()},
+          {"date", rf::date_filter(), sf::date_filter()},
+          {"linux_mem_size", rf::linux_mem_size_filter(),
+           sf::linux_mem_size_filter()}};
+}
+
+// Corner cases of the scanners
+const std::vector<std::string> extra_samples = {
+    "connect to 192.168.0.1:8080, 256.1.1.1, 1.2.3.4:123456 and 10.0.0.1234",
+    "ips 0.0.0.0 01.2.3.4 249.250.255.199 2.25.205.1:0 1.1.1.1.1",
+    "uuid {123e4567-e89b-12d3-a456-426614174000} x{123e4567-e89b-12d3-"
+    "a456-426614174000}y 123e4567-e89b-12d3-a456-426614174000}",
+    "mac 00:1A:2b:3c:4D:5e and 00-1a-2b-3c-4d-5e, 00:1a:2b:3c:4d:5e:6f",
+    "read 12.5 MiB in 300ms, free 2G of 16 kB, took 3 seconds, 1second",
+    "took -5ms x-5ms 5 s 1.s 2.5.3s 7 msec 10 pb 3 iB 4 Kib 5 kbs 6 M",
+    "pointer 0xDEADbeef <obj at 0x7f> [worker 3] x=-12,y=(7) 0x12g",
+    "GET /index.html?id=99#frag \"user\" 'quoted' 100% @host:22 a.5 -3",
+    "at 10/18/21 10:00:00 and 1:2:3 101:00:00 10:00:00:00",
+    "[unclosed <also unclosed\r] >",
+    "42"};
+
+double filter_lines(const line_filter& filter,
+                    const std::vector<std::string>& lines,
+                    std::vector<std::string>& filtered,
+                    std::vector<std::string>& params) {
+  const auto t_start = std::chrono::steady_clock::now();
+  for (const auto& line : lines)
+    filtered.push_back(filter(line, std::back_inserter(params)));
+  return sample_lines::seconds_since(t_start);
+}
+} // namespace
+
+int main() {
+  namespace sf = flt::parameter_filter::scanner_filters;
+  using namespace std::literals::string_literals;
+
+  if (sf::number_constant_filter()("id 12 at:7"s) != "id $v at:$v" ||
+      sf::ipv4_address_filter()("to 10.0.0.1:80."s) != "to $v." ||
+      flt::parameter_filter::scanner_filter<
+          flt::parameter_filter::scanners::time>("<$&|$`|$'|$0$9$x$>")(
+          "at 10:00:00 ok"s) != "at <10:00:00|at | ok|10:00:00$x$> ok") {
+    std::cerr << "Wrong replacement" << std::endl;
+    return -1;
+  }
+
+  // Scanners give the same lines and parameters as the regexes
+  const auto lines = sample_lines::noisy(20000, extra_samples, 44);
+  for (const auto& filters : filter_pairs()) {
+    auto expected = std::vector<std::string>{};
+    auto expected_params = std::vector<std::string>{};
+    const auto regex_seconds =
+        filter_lines(filters.regex, lines, expected, expected_params);
+    auto filtered = std::vector<std::string>{};
+    auto params = std::vector<std::string>{};
+    const auto scanner_seconds =
+        filter_lines(filters.scanner, lines, filtered, params);
+    for (auto i = std::size_t{0}; i < lines.size(); ++i)
+      if (filtered[i] != expected[i]) {
+        std::cerr << filters.name << " scanner gives " << filtered[i]
+                  << " instead of " << expected[i] << " on " << lines[i]
+                  << std::endl;
+        return -1;
+      }
+    if (params != expected_params) {
+      std::cerr << filters.name << " scanner extracts different parameters"
+                << std::endl;
+      return -1;
+    }
+    std::cout << filters.name << ": " << lines.size() / regex_seconds
+              << " lines/s regex, " << lines.size() / scanner_seconds
+              << " lines/s scanner" << std::endl;
+  }
+}
@@ -0,0 +1,79 @@
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/parameter_filter/static_filter_pipeline.hpp>
+
+#include "sample_lines.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename Filters>
+double filter_lines(const Filters& filters,
+                    const std::vector<std::string>& lines,
+                    std::vector<std::string>& filtered,
+                    std::vector<std::string>& params) {
+  auto res = std::string{};
+  const auto t_start = std::chrono::steady_clock::now();
+  for (const auto& line : lines) {
+    filters.filter_into(line, res, std::back_inserter(params));
+    filtered.push_back(res);
+  }
+  return sample_lines::seconds_since(t_start);
+}
+} // namespace
+
+int main() {
+  namespace pf = flt::parameter_filter;
+  using namespace std::literals::string_literals;
+  using params_type = std::vector<std::string>;
+
+  // Filters are applied in the order they are given
+  {
+    const auto filters = pf::static_filter_pipeline{
+        pf::regex_filter{"a"s, std::regex_constants::ECMAScript, "b"s},
+        pf::regex_filter{"b"s, std::regex_constants::ECMAScript, "c"s}};
+    auto params = params_type{};
+    if (filters("ab"s) != "cc" ||
+        filters("xa"s, std::back_inserter(params)) != "xc" ||
+        params != params_type{"a", "b"} || filters.size() != 2) {
+      std::cerr << "Wrong filter order" << std::endl;
+      return -1;
+    }
+  }
+
+  // The static default filters give the same lines and parameters as
+  // default_filters()
+  const auto dynamic_filters =
+      pf::default_filters<std::back_insert_iterator<params_type>>();
+  const auto static_filters = pf::static_default_filters();
+  const auto lines = sample_lines::numbered(70000);
+  auto expected = std::vector<std::string>{};
+  auto expected_params = params_type{};
+  const auto dynamic_seconds =
+      filter_lines(dynamic_filters, lines, expected, expected_params);
+  auto filtered = std::vector<std::string>{};
+  auto params = params_type{};
+  const auto static_seconds =
+      filter_lines(static_filters, lines, filtered, params);
+  for (auto i = std::size_t{0}; i < lines.size(); ++i) {
+    auto in_place = lines[i];
+    static_filters.filter_into(in_place, in_place);
+    if (filtered[i] != expected[i] || in_place != expected[i] ||
+        static_filters(lines[i]) != expected[i]) {
+      std::cerr << "Filtered differently: " << lines[i] << std::endl;
+      return -1;
+    }
+  }
+  if (params != expected_params) {
+    std::cerr << "Different parameters extracted" << std::endl;
+    return -1;
+  }
+  std::cout << lines.size() / dynamic_seconds << " lines/s filter_array, "
+            << lines.size() / static_seconds
+            << " lines/s static_filter_pipeline" << std::endl;
+}
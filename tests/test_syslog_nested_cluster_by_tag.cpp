@@ -2,6 +2,7 @@
 #include <flt/clustering/cluster_utils.hpp>
 #include <flt/clustering/distance_classifier.hpp>
 #include <flt/logline/syslog.hpp>
+#include <flt/parameter_filter/batch_filter.hpp>
 #include <flt/parameter_filter/common_regex_filters.hpp>
 #include <flt/parameter_filter/filter_array.hpp>
 #include <flt/parameter_filter/ipv6_address_filter.hpp>
@@ -24,10 +25,6 @@
 #include <unordered_map>
 #include <unordered_set>
 
-#if __has_include(<execution> )
-#include <execution>
-#endif
-
 int main(int argc, char** argv) {
   auto t_start_tot = std::chrono::high_resolution_clock::now();
 
@@ -80,17 +77,19 @@ int main(int argc, char** argv) {
   auto f16 = long_date_filter();
   auto f17 = extended_date_filter();
   auto f99 = aggressive_number_constant_filter();
-  auto w = filter_array<std::vector<std::string>::iterator, std::string>{
-      f99, f1,  f2,  f3,  f4,  f5,  f6,  f7,  f8,
-      f9,  f10, f11, f12, f13, f14, f15, f16, f17};
+  auto w = batch_filter{
+      filter_array<std::vector<std::string>::iterator, std::string>{
+          f99, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14,
+          f15, f16, f17}};
 
   auto t_start_filts = std::chrono::high_resolution_clock::now();
-  std::for_each(
-#if __has_include(<execution>)
-      std::execution::par_unseq,
-#endif
-      std::begin(linesvec), std::end(linesvec),
-      [&](auto&& logline) { logline.set_message(w(logline.get_message())); });
+  auto messages = line_buffer{};
+  for (auto&& logline : linesvec)
+    messages.push_back(logline.get_message());
+  auto filtered = line_buffer{};
+  w(messages, filtered);
+  for (auto i = std::size_t{0}; i < std::size(linesvec); ++i)
+    linesvec[i].set_message(std::string{filtered[i]});
   auto t_end_filts = std::chrono::high_resolution_clock::now();
   std::chrono::duration<double> duration_filts = t_end_filts - t_start_filts;
 
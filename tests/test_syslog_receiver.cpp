@@ -0,0 +1,166 @@
+#include <flt/io/syslog_receiver.hpp>
+#include <flt/logline/syslog.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef FLT_IO_HAVE_SYSLOG_RECEIVER
+namespace {
+using namespace std::chrono_literals;
+
+void send_all(int fd, std::string_view data) {
+  while (!data.empty()) {
+    const auto num_sent = ::send(fd, data.data(), data.size(), 0);
+    if (num_sent <= 0)
+      throw std::runtime_error{"Couldn't send"};
+    data.remove_prefix(std::size_t(num_sent));
+  }
+}
+
+std::vector<std::string> receive(flt::io::syslog_receiver& receiver,
+                                 std::size_t num_messages) {
+  auto messages = std::vector<std::string>{};
+  for (auto message = std::string_view{};
+       messages.size() < num_messages && receiver.next(message, 1000ms);)
+    messages.emplace_back(message);
+  return messages;
+}
+
+bool expect(const std::vector<std::string>& messages,
+            const std::vector<std::string>& expected, const char* what) {
+  if (messages == expected)
+    return true;
+  std::cerr << "Wrong messages " << what << ":";
+  for (const auto& message : messages)
+    std::cerr << " \"" << message << '"';
+  std::cerr << std::endl;
+  return false;
+}
+} // namespace
+
+int main() {
+  auto config = flt::io::receiver_config{};
+  config.udp_address = "127.0.0.1:0";
+  config.tcp_address = "127.0.0.1:0";
+  config.max_message_size = 64;
+  auto receiver = flt::io::syslog_receiver{config};
+  const auto udp_address = "127.0.0.1:" + std::to_string(receiver.udp_port());
+  const auto tcp_address = "127.0.0.1:" + std::to_string(receiver.tcp_port());
+
+  // One message per datagram, trailing line breaks are removed
+  {
+    const auto fd = flt::io::detail::open_socket(udp_address, SOCK_DGRAM,
+                                                 false);
+    for (const auto* text : {"<13>first", "<13>second\n", "<13>third\r\n"})
+      send_all(fd, text);
+    send_all(fd, std::string(100, 'x'));
+    ::close(fd);
+    if (!expect(receive(receiver, 4),
+                {"<13>first", "<13>second", "<13>third", std::string(64, 'x')},
+                "over UDP") ||
+        receiver.stats().truncated != 1)
+      return -1;
+  }
+
+  // Octet counted and newline framed messages, split across writes
+  {
+    const auto fd = flt::io::detail::open_socket(tcp_address, SOCK_STREAM,
+                                                 false);
+    send_all(fd, "12 <13>line one");
+    std::this_thread::sleep_for(10ms);
+    send_all(fd, "<13>line two\n<13>li");
+    std::this_thread::sleep_for(10ms);
+    send_all(fd, "ne three\n1");
+    std::this_thread::sleep_for(10ms);
+    send_all(fd, "9 <13>with\nline break");
+    send_all(fd, "2024-10-18 not counted\n");
+    send_all(fd, std::string(70, 'y'));
+    std::this_thread::sleep_for(10ms);
+    send_all(fd, "yy\n<13>rest without line break");
+    ::close(fd);
+    if (!expect(receive(receiver, 7),
+                {"<13>line one", "<13>line two", "<13>line three",
+                 "<13>with\nline break", "2024-10-18 not counted",
+                 std::string(64, 'y'), "<13>rest without line break"},
+                "over TCP"))
+      return -1;
+  }
+
+  // Octet counts beyond the maximum message size close the connection
+  {
+    const auto fd = flt::io::detail::open_socket(tcp_address, SOCK_STREAM,
+                                                 false);
+    send_all(fd, "100 <13>too long\n");
+    ::close(fd);
+    if (!expect(receive(receiver, 1), {}, "after a framing error") ||
+        receiver.stats().framing_errors != 1)
+      return -1;
+  }
+
+  // Received messages are parsed with the syslog format
+  {
+    using namespace flt::logline::syslog;
+    auto parser = logline_parser{"<${PRIORITY}>${DATE} ${ORIGIN} ${MESSAGE}"};
+    auto in = std::istringstream{
+        "<34>Oct 11 22:14:15 mymachine su[42]: 'su root' failed"};
+    auto parsed = logline{};
+    in >> parser(parsed);
+    if (in.fail() || parsed.get_facility() != logline::Facility::auth ||
+        parsed.get_severity() != logline::Severity::crit ||
+        parsed.get_full_message() != "su[42]: 'su root' failed") {
+      std::cerr << "Syslog message not parsed" << std::endl;
+      return -1;
+    }
+  }
+
+  // Every datagram of a burst is either received or counted as dropped
+  {
+    constexpr auto num_messages = 200000u;
+    auto sender = std::thread{[&] {
+      const auto fd = flt::io::detail::open_socket(udp_address, SOCK_DGRAM,
+                                                   false);
+      auto text = std::string{};
+      for (auto i = 0u; i < num_messages; ++i) {
+        text = "<13>Oct 18 10:00:00 host" + std::to_string(i % 7) +
+               " app[1]: request " + std::to_string(i);
+        send_all(fd, text);
+      }
+      std::this_thread::sleep_for(100ms);
+      send_all(fd, "end");
+      ::close(fd);
+    }};
+    const auto t_start = std::chrono::steady_clock::now();
+    auto num_received = std::uint64_t{0};
+    for (auto message = std::string_view{};
+         receiver.next(message, 2000ms) && message != "end";)
+      ++num_received;
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - t_start)
+                             .count();
+    sender.join();
+    const auto num_dropped = receiver.stats().kernel_drops;
+    std::cout << num_received << " of " << num_messages
+              << " datagrams received in " << seconds << " s, "
+              << num_received / seconds << " messages/s, " << num_dropped
+              << " dropped" << std::endl;
+#ifdef SO_RXQ_OVFL
+    if (num_received + num_dropped != num_messages) {
+      std::cerr << "Datagrams lost without being counted" << std::endl;
+      return -1;
+    }
+#endif
+  }
+}
+#else
+int main() {
+  std::cout << "Receiving syslog messages is not supported here" << std::endl;
+}
+#endif
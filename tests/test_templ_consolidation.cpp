@@ -0,0 +1,47 @@
+#include <flt/templating/online_templater.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main() {
+  using namespace flt::templating::online;
+
+  {
+    // With a strict threshold, these stay separate templates online
+    auto templater = online_templater<std::string>(0.9, true);
+    templater("Disk sda1 is full now");
+    templater("Disk sdb2 is full now");
+    templater("Disk sdc3 is full now");
+    templater("Disk sdc3 is empty now");
+    templater("Service sshd was stopped by admin");
+    auto num_merged = templater.consolidate_templs();
+    std::cout << "Merged " << num_merged << " templates" << std::endl;
+    templater.split_templs();
+    auto fout = std::ofstream{"test_templ_consolidation.txt"};
+    templater.save_templs(fout, true);
+    if (num_merged != 2) {
+      std::cerr << "Expected 2 templates to be merged" << std::endl;
+      return -1;
+    }
+  }
+
+  // Consolidation time should grow linearly with the number of templates
+  for (auto num_templs : {50000u, 100000u, 200000u}) {
+    auto templater = online_templater<std::string>(0.9, false);
+    for (auto i = 0u; i < num_templs; ++i)
+      templater("svc" + std::to_string(i / 20) + " worker w" +
+                std::to_string(i % 20) + " failed with code");
+    auto t_start = std::chrono::high_resolution_clock::now();
+    auto num_merged = templater.consolidate_templs();
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = t_end - t_start;
+    std::cout << num_templs << " templates: merged " << num_merged << " in "
+              << duration.count() << " s" << std::endl;
+    if (num_merged != num_templs - num_templs / 20) {
+      std::cerr << "Unexpected number of merged templates" << std::endl;
+      return -1;
+    }
+  }
+}
@@ -0,0 +1,65 @@
+#include <flt/templating/online_templater.hpp>
+
+#include <iostream>
+#include <map>
+#include <string>
+
+int main() {
+  using namespace flt::templating::online;
+
+  auto templater = online_templater<std::string>(0.34, true);
+  auto templs = std::map<template_id, std::string>{};
+  auto num_events = std::map<template_event_kind, int>{};
+
+  auto print_event = [&](const auto& event) {
+    ++num_events[event.kind];
+    templs[event.id] = std::string{event.templ};
+    switch (event.kind) {
+    case template_event_kind::added:
+      std::cout << "Added " << event.id << ": ";
+      break;
+    case template_event_kind::generalized:
+      std::cout << "Generalized " << event.id << ": ";
+      break;
+    case template_event_kind::split:
+      std::cout << "Split " << event.id << " from " << event.parent_id << ": ";
+      break;
+    case template_event_kind::evicted:
+      std::cout << "Evicted " << event.id << ": ";
+      break;
+    }
+    std::cout << event.templ << std::endl;
+  };
+  templater.on_template_added(print_event);
+  templater.on_template_generalized(print_event);
+  templater.on_template_split(print_event);
+  templater.on_template_evicted(print_event);
+
+  templater("User A logged on successfully");
+  templater("User B logged on successfully");
+  templater("User C saved state successfully");
+  templater("User D saved state successfully");
+  templater("User E saved state successfully");
+  templater("Directory /home/user_x/dir_a was successfully created");
+  templater.split_templs();
+  // Splitting again must neither report the split templates twice nor
+  // change their ids
+  templater.split_templs();
+
+  if (num_events[template_event_kind::added] != 2 ||
+      num_events[template_event_kind::generalized] != 2 ||
+      num_events[template_event_kind::split] != 2 || templs.size() != 4) {
+    std::cerr << "Unexpected template events" << std::endl;
+    return -1;
+  }
+
+  // Evicting everything reports each evicted template once
+  const auto num_evicted = templater.evict_templs(0);
+  if (num_evicted == 0 ||
+      num_events[template_event_kind::evicted] != int(num_evicted) ||
+      templater.evict_templs(0) != 0 ||
+      num_events[template_event_kind::evicted] != int(num_evicted)) {
+    std::cerr << "Unexpected eviction events" << std::endl;
+    return -1;
+  }
+}
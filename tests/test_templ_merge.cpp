@@ -0,0 +1,220 @@
+#include <flt/io/worker_states.hpp>
+#include <flt/templating/online_templater.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+using templater_type = flt::templating::online_templater<std::string>;
+
+std::vector<std::string> make_log(unsigned int num_lines) {
+  const char* objects[] = {"service", "worker", "job", "session"};
+  const char* verbs[] = {"started", "stopped", "failed", "reloaded"};
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    const auto host = "host" + std::to_string(i * 7 % 13);
+    const auto kind = i * 31 % 17;
+    if (kind < 4)
+      lines.push_back(host + " app: " + objects[kind] + " " +
+                      (i % 3 ? "alpha" : "beta") + " " + verbs[kind] +
+                      " after " + std::to_string(i % 977) + " ms");
+    else if (kind < 8)
+      lines.push_back(host + " sshd[" + std::to_string(i % 9973) +
+                      "]: Accepted " + (i % 2 ? "publickey" : "password") +
+                      " for user" + std::to_string(i % 41) + " from 10.0.0." +
+                      std::to_string(i % 251) + " port " +
+                      std::to_string(i % 60000) + " ssh2");
+    else if (kind < 11)
+      lines.push_back(host + " kernel: eth" + std::to_string(kind % 3) +
+                      ": link " + (i % 5 ? "up" : "down") + ", speed " +
+                      std::to_string(i % 4 ? 1000 : 100) + " Mbps");
+    else
+      lines.push_back(host + " db: query on table " +
+                      (i % 3 ? "users" : "orders") + " took " +
+                      std::to_string(i % 499) + " ms rows=" +
+                      std::to_string(i % 1009));
+  }
+  return lines;
+}
+
+// Unique MAC addresses exceed the parameter table size of the templates
+std::vector<std::string> make_capped_log(unsigned int num_lines) {
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i)
+    lines.push_back("eth" + std::to_string(i % 3) + ": link up, speed " +
+                    (i % 4 ? "1000" : "100") + " Mbps, mac m" +
+                    std::to_string(i * 2654435761u % 100000));
+  return lines;
+}
+
+// Saved templates in a canonical order
+std::vector<std::string> saved_templs(const templater_type& templater,
+                                      bool save_params) {
+  const auto filename = std::string{"test_templ_merge.txt"};
+  {
+    auto fout = std::ofstream{filename};
+    templater.save_templs(fout, save_params);
+  }
+  auto lines = std::vector<std::string>{};
+  {
+    auto fin = std::ifstream{filename};
+    for (auto line = std::string{}; std::getline(fin, line);)
+      lines.push_back(line);
+  }
+  std::remove(filename.c_str());
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+std::size_t num_saved_params(const std::vector<std::string>& saved) {
+  auto num_params = std::size_t{0};
+  for (const auto& line : saved)
+    if (line.rfind("  Params at pos ", 0) == 0)
+      num_params += std::size_t(std::count(line.begin(), line.end(), ' ')) - 4;
+  return num_params;
+}
+
+std::string state_of(const templater_type& templater) {
+  auto out = std::ostringstream{};
+  templater.save_state(out);
+  return out.str();
+}
+
+// Templates the parts separately and merges their states in order
+templater_type merge_parts(const std::vector<std::string>& lines,
+                           std::size_t num_parts) {
+  auto merged = templater_type(0.34, true);
+  for (auto part = std::size_t{0}; part < num_parts; ++part) {
+    auto part_templater = templater_type(0.34, true);
+    for (auto i = lines.size() * part / num_parts;
+         i < lines.size() * (part + 1) / num_parts; ++i)
+      part_templater(lines[i]);
+    auto in = std::istringstream{state_of(part_templater)};
+    auto loaded = templater_type(0.34, true);
+    loaded.load_state(in);
+    merged.merge(loaded);
+  }
+  merged.split_templs();
+  return merged;
+}
+} // namespace
+
+int main() {
+  const auto lines = make_log(20000);
+  auto single = templater_type(0.34, true);
+  for (const auto& line : lines)
+    single(line);
+
+  // A loaded state gives the same templates and parameters
+  {
+    auto in = std::istringstream{state_of(single)};
+    auto loaded = templater_type(0.34, true);
+    loaded.load_state(in);
+    if (saved_templs(loaded, true) != saved_templs(single, true)) {
+      std::cerr << "Loaded templates differ" << std::endl;
+      return -1;
+    }
+  }
+
+  // The templates don't depend on the number of parts
+  single.split_templs();
+  const auto expected = saved_templs(single, false);
+  std::cout << expected.size() << " templates" << std::endl;
+  for (auto num_parts : {1u, 2u, 3u, 5u, 8u}) {
+    const auto t_start = std::chrono::steady_clock::now();
+    const auto merged = merge_parts(lines, num_parts);
+    const auto seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - t_start)
+                             .count();
+    std::cout << num_parts << " parts templated and merged in " << seconds
+              << " s" << std::endl;
+    if (saved_templs(merged, false) != expected) {
+      std::cerr << "Templates of " << num_parts << " parts differ"
+                << std::endl;
+      return -1;
+    }
+  }
+
+  // Positions frozen in a part take no parameters of later parts, so parts
+  // large enough to freeze them give the parameters of a single run. With
+  // smaller parts they are frozen by the merge and stay as bounded.
+  {
+    const auto capped_lines = make_capped_log(6000);
+    auto capped = templater_type(0.34, true);
+    for (const auto& line : capped_lines)
+      capped(line);
+    capped.split_templs();
+    const auto expected_params = saved_templs(capped, true);
+    const auto frozen = std::count_if(
+        expected_params.begin(), expected_params.end(), [](const auto& line) {
+          return line.rfind("  Positions with max num", 0) == 0;
+        });
+    if (frozen == 0) {
+      std::cerr << "No parameter position exceeds the cap" << std::endl;
+      return -1;
+    }
+    for (auto num_parts : {2u, 3u}) {
+      if (saved_templs(merge_parts(capped_lines, num_parts), true) !=
+          expected_params) {
+        std::cerr << "Parameters of " << num_parts << " parts differ"
+                  << std::endl;
+        return -1;
+      }
+    }
+    for (auto num_parts : {4u, 8u}) {
+      if (num_saved_params(saved_templs(
+              merge_parts(capped_lines, num_parts), true)) >
+          num_saved_params(expected_params)) {
+        std::cerr << "Parameters of " << num_parts << " parts exceed the cap"
+                  << std::endl;
+        return -1;
+      }
+    }
+  }
+
+  // Corrupt states are rejected
+  {
+    const auto state = state_of(single);
+    for (const auto& corrupt :
+         {state.substr(0, state.size() / 2), "X" + state.substr(1)}) {
+      auto in = std::istringstream{corrupt};
+      auto loaded = templater_type(0.34, true);
+      try {
+        loaded.load_state(in);
+        std::cerr << "Corrupt state loaded" << std::endl;
+        return -1;
+      } catch (const std::runtime_error&) {
+      }
+    }
+  }
+
+#ifdef FLT_IO_HAVE_WORKER_STATES
+  // States arrive in any order and are returned ordered by part
+  {
+    auto collector = flt::io::state_collector{"unix:test_templ_merge.sock"};
+    auto sender = std::thread{[&] {
+      for (auto part = std::size_t{3}; part-- > 0;)
+        flt::io::send_worker_state(
+            collector.address(),
+            {part, 3, part * 10, "state " + std::to_string(part)});
+    }};
+    const auto states = collector.collect(3, [] { return false; });
+    sender.join();
+    for (auto part = std::size_t{0}; part < 3; ++part)
+      if (states[part].part != part || states[part].num_lines != part * 10 ||
+          states[part].state != "state " + std::to_string(part)) {
+        std::cerr << "Wrong worker state" << std::endl;
+        return -1;
+      }
+  }
+#endif
+}
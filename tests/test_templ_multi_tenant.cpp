@@ -0,0 +1,174 @@
+#include <flt/templating/multi_tenant_templater.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+std::string read_file(const std::string& filename) {
+  auto fin = std::ifstream{filename};
+  return std::string{std::istreambuf_iterator<char>{fin},
+                     std::istreambuf_iterator<char>{}};
+}
+
+std::multiset<std::string> read_lines(const std::string& filename) {
+  auto fin = std::ifstream{filename};
+  auto lines = std::multiset<std::string>{};
+  for (auto line = std::string{}; std::getline(fin, line);)
+    lines.insert(line);
+  return lines;
+}
+
+std::string logline(unsigned int i) {
+  const auto n = std::to_string(i % 31);
+  switch (i % 4) {
+  case 0:
+    return "Accepted publickey for user" + n + " from $v port $v";
+  case 1:
+    return "Connection closed by $v port $v [preauth]";
+  case 2:
+    return "session opened for user user" + n + " by (uid=$v)";
+  default:
+    return "Disk sd" + n + " is full now";
+  }
+}
+} // namespace
+
+int main() {
+  using namespace flt::templating::online;
+
+  // The dictionary holds the distinct tokens, independent of the number of
+  // tenants seeing them
+  auto dictionary_sizes = std::vector<std::size_t>{};
+  for (auto num_tenants : {10u, 100u, 1000u}) {
+    auto templater = multi_tenant_templater<std::string>(0.34, true);
+    for (auto i = 0u; i < 200u; ++i)
+      for (auto tenant = 0u; tenant < num_tenants; ++tenant)
+        templater("host" + std::to_string(tenant), logline(i));
+    std::cout << num_tenants << " tenants: " << templater.dictionary().size()
+              << " tokens, " << templater.memory_usage() << " bytes"
+              << std::endl;
+    dictionary_sizes.push_back(templater.dictionary().size());
+  }
+  if (dictionary_sizes.front() != dictionary_sizes.back()) {
+    std::cerr << "Dictionary size depends on the number of tenants"
+              << std::endl;
+    return -1;
+  }
+
+  // Tenants learn the same templates as separate templaters
+  {
+    auto templater = multi_tenant_templater<std::string>(0.34, true);
+    auto single_templater = online_templater<std::string>(0.34, true);
+    for (auto i = 0u; i < 1000u; ++i) {
+      templater("a", logline(i));
+      templater("b", logline(i + 1));
+      single_templater(logline(i));
+    }
+    templater.split_templs();
+    single_templater.split_templs();
+    {
+      auto fout = std::ofstream{"test_templ_multi_tenant_a.txt"};
+      templater.tenant("a").save_templs(fout, true);
+      auto fout_single = std::ofstream{"test_templ_multi_tenant_single.txt"};
+      single_templater.save_templs(fout_single, true);
+    }
+    if (read_file("test_templ_multi_tenant_a.txt") !=
+        read_file("test_templ_multi_tenant_single.txt")) {
+      std::cerr << "Tenant templates differ from a separate templater"
+                << std::endl;
+      return -1;
+    }
+  }
+
+  // A tenant with ever new templates stays within its quota, the least
+  // recently used templates are evicted first
+  {
+    const auto quota = std::size_t{64 * 1024};
+    const auto check_interval = 256u;
+    auto templater = multi_tenant_templater<std::string>(0.34, true, quota,
+                                                         check_interval);
+    auto evicted_ids = std::set<template_id>{};
+    templater.tenant("noisy").on_template_evicted(
+        [&](const auto& event) { evicted_ids.insert(event.id); });
+    const auto num_lines = 100u * check_interval;
+    for (auto i = 0u; i < num_lines; ++i) {
+      templater("quiet", logline(i));
+      templater("noisy", "job" + std::to_string(i) + " finished with code " +
+                             std::to_string(i));
+    }
+    const auto noisy_usage = templater.find_tenant("noisy")->memory_usage();
+    std::cout << "Evicted " << templater.num_evicted() << " templates, "
+              << noisy_usage << " bytes in use, "
+              << templater.dictionary().size() << " tokens" << std::endl;
+    if (noisy_usage > quota || templater.num_evicted() == 0 ||
+        templater.num_evicted() != evicted_ids.size()) {
+      std::cerr << "Quota not enforced" << std::endl;
+      return -1;
+    }
+    if (evicted_ids.count(num_lines - 1) != 0) {
+      std::cerr << "Most recent template evicted" << std::endl;
+      return -1;
+    }
+    if (templater.dictionary().size() > num_lines / 4) {
+      std::cerr << "Dictionary not compacted" << std::endl;
+      return -1;
+    }
+
+    // Compaction keeps the tokens of the remaining templates, only the order
+    // of the token buckets may change
+    templater.split_templs();
+    {
+      auto fout = std::ofstream{"test_templ_multi_tenant_quiet.txt"};
+      templater.tenant("quiet").save_templs(fout, true);
+    }
+    templater.compact_dictionary();
+    {
+      auto fout = std::ofstream{"test_templ_multi_tenant_compacted.txt"};
+      templater.tenant("quiet").save_templs(fout, true);
+    }
+    if (read_lines("test_templ_multi_tenant_quiet.txt") !=
+        read_lines("test_templ_multi_tenant_compacted.txt")) {
+      std::cerr << "Compaction changed the templates" << std::endl;
+      return -1;
+    }
+  }
+
+  // Lines skipped by sampling still keep their template in use, so a tenant
+  // sampling its hot templates doesn't evict them first
+  {
+    const auto check_interval = 256u;
+    auto templater = multi_tenant_templater<std::string>(
+        0.34, true, std::size_t{64 * 1024}, check_interval);
+    auto& sampled = templater.tenant("sampled");
+    sampled.enable_adaptive_sampling(
+        flt::templating::sampling_configuration{1., 0.001, 0.5, 0.9, 256});
+    auto hot_ids = std::set<template_id>{};
+    sampled.on_template_added([&](const auto& event) {
+      if (event.templ.rfind("heartbeat", 0) == 0)
+        hot_ids.insert(event.id);
+    });
+    auto evicted_ids = std::set<template_id>{};
+    sampled.on_template_evicted(
+        [&](const auto& event) { evicted_ids.insert(event.id); });
+    for (auto i = 0u; i < 100u * check_interval; ++i) {
+      templater("sampled", "heartbeat from node $v");
+      templater("sampled", "job" + std::to_string(i) + " finished with code " +
+                               std::to_string(i));
+    }
+    if (hot_ids.empty() || sampled.get_sampling_stats().skipped == 0 ||
+        templater.num_evicted() == 0) {
+      std::cerr << "Sampling with a quota not exercised" << std::endl;
+      return -1;
+    }
+    for (auto id : hot_ids)
+      if (evicted_ids.count(id) != 0) {
+        std::cerr << "Template of skipped lines evicted" << std::endl;
+        return -1;
+      }
+  }
+}
@@ -0,0 +1,83 @@
+#include <flt/templating/online_templater.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int main() {
+  using namespace flt::templating::online;
+
+  // A handful of message types with varying parameters. After the first few
+  // hundred lines, no new templates appear any more.
+  auto loglines = std::vector<std::string>{};
+  for (auto i = 0u; i < 200000u; ++i) {
+    const auto n = std::to_string(i % 97);
+    switch (i % 4) {
+    case 0:
+      loglines.push_back("Accepted publickey for user" + n + " from $v port $v");
+      break;
+    case 1:
+      loglines.push_back("Connection closed by $v port $v [preauth]");
+      break;
+    case 2:
+      loglines.push_back("session opened for user user" + n + " by (uid=$v)");
+      break;
+    default:
+      loglines.push_back("Received disconnect from $v port $v:11: disconnected");
+    }
+  }
+
+  auto run = [&](auto& templater, const std::string& name) {
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (const auto& logline : loglines)
+      templater(logline);
+    auto t_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duration = t_end - t_start;
+    std::cout << name << ": " << duration.count() << " s" << std::endl;
+    templater.split_templs();
+    const auto fname = "test_templ_sampling_" + name + ".txt";
+    {
+      auto fout = std::ofstream{fname};
+      templater.save_templs(fout);
+    }
+    auto fin = std::ifstream{fname};
+    return std::string{std::istreambuf_iterator<char>{fin}, {}};
+  };
+
+  auto full_templater = online_templater<std::string>(0.34, true);
+  const auto full_templs = run(full_templater, "full");
+
+  auto sampled_templater = online_templater<std::string>(0.34, true);
+  sampled_templater.enable_adaptive_sampling(
+      sampling_configuration{1., 0.001, 0.5, 0.001, 1000});
+  const auto sampled_templs = run(sampled_templater, "sampled");
+
+  const auto& stats = sampled_templater.get_sampling_stats();
+  std::cout << "Lines: " << stats.lines << '\n'
+            << "Matched: " << stats.matched << '\n'
+            << "Novel: " << stats.novel << '\n'
+            << "Sampled: " << stats.sampled << '\n'
+            << "Skipped: " << stats.skipped << '\n'
+            << "Sampling rate: " << stats.sampling_rate << '\n'
+            << "Novelty rate: " << stats.novelty_rate << std::endl;
+
+  if (stats.lines != stats.matched + stats.novel ||
+      stats.matched != stats.sampled + stats.skipped) {
+    std::cerr << "Inconsistent sampling counters" << std::endl;
+    return -1;
+  }
+  // The templates are all found early on, after which the rate backs off
+  // and most lines are skipped
+  if (stats.skipped == 0 || !(stats.sampling_rate < 1.)) {
+    std::cerr << "Sampling never backed off" << std::endl;
+    return -1;
+  }
+  if (sampled_templs != full_templs) {
+    std::cerr << "Sampling lost templates" << std::endl;
+    return -1;
+  }
+}
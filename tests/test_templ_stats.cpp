@@ -0,0 +1,41 @@
+#ifndef FLT_TEMPLATER_STATS
+#define FLT_TEMPLATER_STATS
+#endif
+#include <flt/templating/online_templater.hpp>
+#include <flt/templating/templater_stats.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+  using namespace flt::templating::online;
+
+  auto templater = online_templater<std::string>(0.34, true);
+  if (argc < 2) {
+    for (auto i = 0u; i < 20000u; ++i) {
+      const auto n = std::to_string(i % 1013);
+      templater("Accepted publickey for user" + n + " from $v port $v");
+      templater("Job " + n + " finished after $v retries");
+      templater("Connection closed by $v port $v [preauth]");
+    }
+  } else {
+    auto is_log = std::ifstream{argv[1]};
+    if (!is_log) {
+      std::cerr << "Couldn't open log file " << argv[1] << std::endl;
+      return -1;
+    }
+    auto logline = std::string{};
+    while (std::getline(is_log, logline))
+      templater(logline);
+  }
+  templater.split_templs();
+
+  const auto stats = templater.get_stats();
+  write_stats(std::cout, stats);
+  if (stats.lines == 0 || stats.similarity_calls_per_line.count() !=
+                              stats.templates_added + stats.templates_updated) {
+    std::cerr << "Inconsistent templater stats" << std::endl;
+    return -1;
+  }
+}
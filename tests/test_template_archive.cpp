@@ -0,0 +1,196 @@
+#include <flt/io/template_archive.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::string archive(const std::vector<std::string>& lines,
+                    flt::io::archive_config config, bool final_newline = true) {
+  auto out = std::ostringstream{};
+  auto writer = flt::io::archive_writer{out, config};
+  for (const auto& line : lines)
+    writer.add(line);
+  writer.close(final_newline);
+  return out.str();
+}
+
+std::vector<std::string> unarchive(const std::string& data) {
+  auto in = std::istringstream{data};
+  auto reader = flt::io::archive_reader{in};
+  auto block = flt::io::archive_block{};
+  auto lines = std::vector<std::string>{};
+  auto block_lines = std::vector<std::string>{};
+  while (reader.next_block(block)) {
+    block.decode_lines(block_lines);
+    lines.insert(lines.end(), block_lines.begin(), block_lines.end());
+  }
+  return lines;
+}
+
+// The log the archive restores, with the newlines the blocks keep
+std::string unarchive_log(const std::string& data) {
+  auto in = std::istringstream{data};
+  auto reader = flt::io::archive_reader{in};
+  auto block = flt::io::archive_block{};
+  auto log = std::string{};
+  auto block_lines = std::vector<std::string>{};
+  while (reader.next_block(block)) {
+    block.decode_lines(block_lines);
+    for (auto i = std::size_t{0}; i < block_lines.size(); ++i) {
+      log += block_lines[i];
+      if (i + 1 < block_lines.size() || block.final_newline())
+        log += '\n';
+    }
+  }
+  return log;
+}
+
+std::vector<std::string> make_log(unsigned int num_lines) {
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    const auto time = "Oct 18 10:" + std::to_string(10 + i / 6000 % 50) + ":" +
+                      std::to_string(10 + i / 100 % 50);
+    if (i % 3 == 0)
+      lines.push_back(time + " host" + std::to_string(i % 7) +
+                      " sshd[" + std::to_string(1000 + i % 97) +
+                      "]: Accepted publickey for user" +
+                      std::to_string(i % 31) + " from 10.0." +
+                      std::to_string(i % 13) + "." + std::to_string(i % 251) +
+                      " port " + std::to_string(40000 + i % 20000) + " ssh2");
+    else if (i % 3 == 1)
+      lines.push_back(time + " host" + std::to_string(i % 7) +
+                      " kernel: eth0: link up, speed " +
+                      std::to_string(i % 2 ? 1000 : 100) + " Mbps, id 0x" +
+                      std::to_string(7000 + i % 4096));
+    else
+      lines.push_back(time + " host" + std::to_string(i % 7) +
+                      " cron[" + std::to_string(2000 + i % 89) +
+                      "]: (root) CMD (run-parts /etc/cron.hourly)");
+  }
+  return lines;
+}
+} // namespace
+
+int main() {
+  using flt::io::archive_config;
+
+  // Edge cases of the tokenization and the parameter encodings
+  const auto edge_cases = std::vector<std::string>{
+      "", " ", "  leading and trailing  ", "tabs\tand\r\nbreaks", "007 -0 -12",
+      "9223372036854775807 9223372036854775808 -9223372036854775808",
+      std::string{"marker \x11 byte 1"}, std::string{"nul \0 byte 2", 12},
+      "\xc3\xa4\xc3\xb6 utf-8 42", "x=1,y=2;z=(3)", "a1b2 c3d4 0x1f", "1",
+      "1 2 3 4 5 6 7 8 9 10", "no parameters at all"};
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < 50; ++i)
+    lines.insert(lines.end(), edge_cases.begin(), edge_cases.end());
+  for (auto block_lines : {std::size_t{1}, std::size_t{7}, std::size_t{1000}})
+    for (auto level : {0, 6})
+      if (unarchive(archive(lines, archive_config{block_lines, level})) !=
+          lines) {
+        std::cerr << "Lines not reconstructed, block lines " << block_lines
+                  << ", level " << level << std::endl;
+        return -1;
+      }
+
+  // Logs are restored byte for byte, with or without a final newline, also
+  // if the last block is full
+  for (auto num_lines : {0u, 1u, 9u, 10u}) {
+    auto log_lines = std::vector<std::string>{};
+    auto log = std::string{};
+    for (auto i = 0u; i < num_lines; ++i) {
+      log_lines.push_back("line " + std::to_string(i));
+      log += log_lines.back() + '\n';
+    }
+    for (auto final_newline : {true, false}) {
+      const auto expected =
+          final_newline || log.empty() ? log : log.substr(0, log.size() - 1);
+      if (unarchive_log(archive(log_lines, archive_config{3, 6},
+                                final_newline)) != expected) {
+        std::cerr << "Log not restored, " << num_lines << " lines, final "
+                  << "newline " << final_newline << std::endl;
+        return -1;
+      }
+    }
+  }
+
+  // Columns are readable on their own
+  {
+    const auto data = archive({"port 22 of a", "user b", "port 80 of a"},
+                              archive_config{});
+    auto in = std::istringstream{data};
+    auto reader = flt::io::archive_reader{in};
+    auto block = flt::io::archive_block{};
+    reader.next_block(block);
+    if (block.templates().size() != 2 ||
+        block.templates()[0].pieces !=
+            std::vector<std::string>{"port ", " of a"} ||
+        block.template_ids() != std::vector<std::uint32_t>{0, 1, 0}) {
+      std::cerr << "Wrong templates" << std::endl;
+      return -1;
+    }
+    const auto column = block.column(0, 0);
+    if (column.kind() != flt::io::column_kind::integers ||
+        column.integers() != std::vector<std::int64_t>{22, 80} ||
+        column[1] != "80") {
+      std::cerr << "Wrong integer column" << std::endl;
+      return -1;
+    }
+  }
+
+  // Corrupt archives are reported instead of decoded
+  {
+    const auto data = archive(make_log(1000), archive_config{});
+    auto num_corrupted = 0;
+    auto num_detected = 0;
+    for (auto pos = std::size_t{8}; pos < data.size();
+         pos += data.size() / 50) {
+      ++num_corrupted;
+      auto corrupt = data;
+      corrupt[pos] ^= 0x5a;
+      try {
+        unarchive(corrupt);
+      } catch (const std::runtime_error&) {
+        ++num_detected;
+      }
+    }
+    try {
+      unarchive(data.substr(0, data.size() - 1));
+      std::cerr << "Truncated archive not detected" << std::endl;
+      return -1;
+    } catch (const std::runtime_error&) {
+    }
+    std::cout << num_detected << " of " << num_corrupted
+              << " corruptions detected" << std::endl;
+  }
+
+  const auto log = make_log(300000);
+  auto log_bytes = std::size_t{0};
+  for (const auto& line : log)
+    log_bytes += line.size() + 1;
+  auto t_start = std::chrono::steady_clock::now();
+  const auto data = archive(log, archive_config{});
+  auto t_archived = std::chrono::steady_clock::now();
+  if (unarchive(data) != log) {
+    std::cerr << "Log not reconstructed" << std::endl;
+    return -1;
+  }
+  auto t_end = std::chrono::steady_clock::now();
+  std::cout << log_bytes << " log bytes archived to " << data.size()
+            << " bytes in "
+            << std::chrono::duration<double>(t_archived - t_start).count()
+            << " s, restored in "
+            << std::chrono::duration<double>(t_end - t_archived).count()
+            << " s" << std::endl;
+#ifdef FLT_HAVE_ZLIB
+  if (data.size() * 10 > log_bytes) {
+    std::cerr << "Archive less than ten times smaller than the log"
+              << std::endl;
+    return -1;
+  }
+#endif
+}
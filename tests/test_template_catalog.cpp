@@ -0,0 +1,181 @@
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/string/word_iterator.hpp>
+#include <flt/templating/online_templater.hpp>
+#include <flt/templating/template_catalog.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+std::vector<std::string> make_log(unsigned int num_lines) {
+  auto lines = std::vector<std::string>{};
+  for (auto i = 0u; i < num_lines; ++i) {
+    const auto host = "host" + std::to_string(i % 7);
+    switch (i % 5) {
+    case 0:
+      lines.push_back(host + " sshd: Accepted publickey for user" +
+                      std::to_string(i % 31) + " from 10.0.0." +
+                      std::to_string(i % 251) + " port " +
+                      std::to_string(40000 + i % 20000) + " ssh2");
+      break;
+    case 1:
+      lines.push_back(host + " kernel: eth0: link up, speed " +
+                      std::to_string(i % 2 ? 1000 : 100) + " Mbps");
+      break;
+    case 2:
+      lines.push_back(host + " cron: (root) CMD (run-parts /etc/cron." +
+                      (i % 3 ? "hourly" : "daily") + ")");
+      break;
+    case 3:
+      lines.push_back(" app: request id=" + std::to_string(i) + " user=" +
+                      (i % 3 ? "alice" : "bob") + " status=200");
+      break;
+    default:
+      lines.push_back(host + " app: cache miss for key session:" +
+                      std::to_string(i % 1000));
+    }
+  }
+  return lines;
+}
+
+// Matching as done by the templater's templates, on its word iterator
+bool templ_matches(const std::string& templ, const std::string& logline) {
+  using namespace flt::string::iterator;
+  auto templ_it = cbegin_wordwise_special_seps(templ);
+  auto templ_last = cend_wordwise_special_seps(templ);
+  auto logline_it = cbegin_wordwise_special_seps(logline);
+  auto logline_last = cend_wordwise_special_seps(logline);
+  if (std::distance(templ_it, templ_last) !=
+      std::distance(logline_it, logline_last))
+    return false;
+  if (templ_it.get_prev_seps() != logline_it.get_prev_seps())
+    return false;
+  for (; logline_it != logline_last; ++logline_it, ++templ_it)
+    if ((*templ_it != "<*>" && *templ_it != *logline_it) ||
+        templ_it.get_next_seps() != logline_it.get_next_seps())
+      return false;
+  return true;
+}
+
+// The template with the fewest wildcards, the first of these
+std::optional<std::size_t>
+expected_match(const flt::templating::template_catalog& catalog,
+               const std::string& logline) {
+  auto best = std::optional<std::size_t>{};
+  auto best_wildcards = std::size_t{0};
+  for (auto id = std::size_t{0}; id < catalog.size(); ++id) {
+    const auto& templ = catalog.templ(id);
+    auto wildcards = std::size_t{0};
+    for (auto pos = templ.find("<*>"); pos != std::string::npos;
+         pos = templ.find("<*>", pos + 3))
+      ++wildcards;
+    if ((!best || wildcards < best_wildcards) &&
+        templ_matches(templ, logline)) {
+      best = id;
+      best_wildcards = wildcards;
+    }
+  }
+  return best;
+}
+} // namespace
+
+int main() {
+  using flt::templating::template_catalog;
+
+  const auto filters = flt::parameter_filter::default_filters();
+  auto filtered = std::vector<std::string>{};
+  for (const auto& line : make_log(5000))
+    filtered.push_back(filters(line));
+
+  auto templater = flt::templating::online_templater<std::string>(0.34, true);
+  for (const auto& line : filtered)
+    templater(line);
+  templater.split_templs();
+  const auto filename = std::string{"test_template_catalog.txt"};
+  for (auto save_params : {false, true}) {
+    auto fout = std::ofstream{save_params ? filename + "_pars" : filename};
+    templater.save_templs(fout, save_params);
+  }
+  auto fin = std::ifstream{filename};
+  const auto catalog = template_catalog{fin};
+  auto fin_pars = std::ifstream{filename + "_pars"};
+  const auto catalog_pars = template_catalog{fin_pars, true};
+  fin.close();
+  fin_pars.close();
+  std::remove(filename.c_str());
+  std::remove((filename + "_pars").c_str());
+
+  std::cout << "Catalog of " << catalog.size() << " templates" << std::endl;
+  if (catalog.size() < 5 || catalog_pars.size() != catalog.size()) {
+    std::cerr << "Templates not read" << std::endl;
+    return -1;
+  }
+  for (auto id = std::size_t{0}; id < catalog.size(); ++id)
+    if (catalog.templ(id) != catalog_pars.templ(id)) {
+      std::cerr << "Templates read with parameters differ" << std::endl;
+      return -1;
+    }
+
+  // Every learned line is matched by the most specific template, filling in
+  // its wildcards with the parameters gives the line again
+  auto params = std::vector<std::string_view>{};
+  for (const auto& line : filtered) {
+    params.clear();
+    const auto id = catalog.match(line, &params);
+    if (!id || id != expected_match(catalog, line)) {
+      std::cerr << "Wrong template for " << line << std::endl;
+      return -1;
+    }
+    auto restored = std::string{};
+    const auto& templ = catalog.templ(*id);
+    auto pos = std::size_t{0};
+    for (const auto& param : params) {
+      const auto wildcard = templ.find("<*>", pos);
+      restored.append(templ, pos, wildcard - pos).append(param);
+      pos = wildcard + 3;
+    }
+    restored.append(templ, pos);
+    if (restored != line) {
+      std::cerr << "Wrong parameters for " << line << std::endl;
+      return -1;
+    }
+  }
+
+  // Differing separators or static tokens don't match
+  {
+    auto in = std::istringstream{"a <*> c\n<*> x=<*>\n<*> <*> <*>\n"};
+    const auto small = template_catalog{in};
+    const auto expect = [&](const std::string& line,
+                            std::optional<std::size_t> id) {
+      if (small.match(line) != id) {
+        std::cerr << "Wrong match for " << line << std::endl;
+        return false;
+      }
+      return true;
+    };
+    if (!expect("a b c", 0) || !expect("a  b c", std::nullopt) ||
+        !expect(" a b c", std::nullopt) || !expect("a b d", 2) ||
+        !expect("y x=1", 1) || !expect("y x=1 ", std::nullopt) ||
+        !expect("a b", std::nullopt) || !expect("", std::nullopt))
+      return -1;
+  }
+
+  auto t_start = std::chrono::steady_clock::now();
+  auto num_matched = std::size_t{0};
+  for (auto i = 0; i < 100; ++i)
+    for (const auto& line : filtered)
+      num_matched += catalog.match(line).has_value();
+  const auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - t_start)
+                           .count();
+  std::cout << num_matched << " lines matched at "
+            << num_matched / seconds << " lines/s" << std::endl;
+}
@@ -0,0 +1,112 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#ifdef FLT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+namespace {
+// The tools return -1 on errors, an abort is seen as exit status 134 from the
+// shell instead
+#ifdef _WIN32
+constexpr auto error_status = -1;
+#else
+constexpr auto error_status = 255;
+#endif
+
+struct tool_result {
+  int status;
+  std::string errors;
+};
+
+// Runs the tool with the arguments, keeping what it wrote to stderr
+tool_result run_tool(const std::string& tool, const std::string& args) {
+  const auto errors_file = std::string{"test_tool_errors_stderr.txt"};
+  const auto command = std::string{FLT_TOOLS_DIR} + "/" + tool + " " + args +
+                       " > test_tool_errors_stdout.txt 2> " + errors_file;
+  auto result = tool_result{std::system(command.c_str()), {}};
+#ifndef _WIN32
+  result.status = WIFEXITED(result.status) ? WEXITSTATUS(result.status) : -1;
+#endif
+  auto fin = std::ifstream{errors_file};
+  result.errors = std::string{std::istreambuf_iterator<char>{fin},
+                              std::istreambuf_iterator<char>{}};
+  return result;
+}
+
+#ifdef FLT_HAVE_ZLIB
+std::string make_log(unsigned int num_lines) {
+  auto log = std::string{};
+  for (auto i = 0u; i < num_lines; ++i)
+    log += "Oct 18 10:00:00 host" + std::to_string(i % 7) +
+           " sshd[1234]: Accepted publickey for user" +
+           std::to_string(i % 31) + " port " + std::to_string(i) + " ssh2\n";
+  return log;
+}
+
+std::string gzip(const std::string& text) {
+  const auto filename = std::string{"test_tool_errors_tmp.gz"};
+  std::remove(filename.c_str());
+  auto* file = gzopen(filename.c_str(), "wb6");
+  gzwrite(file, text.data(), unsigned(text.size()));
+  gzclose(file);
+  auto fin = std::ifstream{filename, std::ios::binary};
+  return std::string{std::istreambuf_iterator<char>{fin},
+                     std::istreambuf_iterator<char>{}};
+}
+
+void write_file(const std::string& filename, const std::string& data) {
+  auto fout = std::ofstream{filename, std::ios::binary};
+  fout << data;
+}
+#endif
+} // namespace
+
+int main() {
+#ifdef FLT_HAVE_ZLIB
+  const auto compressed = gzip(make_log(20000));
+  write_file("test_tool_errors.gz", compressed);
+  write_file("test_tool_errors_truncated.gz",
+             compressed.substr(0, compressed.size() / 2));
+  auto corrupt = compressed;
+  corrupt[corrupt.size() / 2] ^= 0x55;
+  write_file("test_tool_errors_corrupt.gz", corrupt);
+
+  for (const auto* mode : {"", "--stream "}) {
+    const auto good = run_tool(
+        "online_templater",
+        std::string{mode} + "test_tool_errors.gz test_tool_errors_templates");
+    if (good.status != 0) {
+      std::cerr << "online_templater " << mode << "failed on good input: "
+                << good.errors << std::endl;
+      return -1;
+    }
+    // Bad input ends the run with the error instead of an abort
+    for (const auto& [file, message] :
+         {std::pair{"test_tool_errors_truncated.gz", "Truncated gzip input"},
+          {"test_tool_errors_corrupt.gz", "Corrupt gzip input"}}) {
+      const auto bad =
+          run_tool("online_templater", std::string{mode} + file +
+                                           " test_tool_errors_templates");
+      if (bad.status != error_status ||
+          bad.errors.find(message) == std::string::npos) {
+        std::cerr << "online_templater " << mode << "on " << file
+                  << " didn't report \"" << message << "\", exit status "
+                  << bad.status << ": " << bad.errors << std::endl;
+        return -1;
+      }
+    }
+  }
+#else
+  std::cout << "Built without zlib, skipping compressed input errors"
+            << std::endl;
+#endif
+}
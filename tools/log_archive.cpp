@@ -0,0 +1,143 @@
+#include <flt/io/line_reader.hpp>
+#include <flt/io/template_archive.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point start) {
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+void print_usage() {
+  std::cerr << "Usage: log_archive compress [--block-lines N] [--level N] "
+               "<log file> <archive>\n"
+               "       log_archive decompress <archive> <log file>\n"
+               "  A log file of - reads from stdin or writes to stdout, gzip "
+               "and zstd\n"
+               "  compressed logs are decompressed on the fly\n"
+               "  --block-lines N     Lines per independently compressed "
+               "block (default\n"
+               "                      65536)\n"
+               "  --level N           zlib level of the archive sections, 0 "
+               "stores them\n"
+               "                      uncompressed (default 6)\n"
+            << std::flush;
+}
+
+void print_summary(std::uint64_t lines, std::uint64_t log_bytes,
+                   std::uint64_t archive_bytes, double seconds) {
+  std::cerr << lines << " lines, " << log_bytes << " log bytes, "
+            << archive_bytes << " archive bytes, ratio " << std::fixed
+            << std::setprecision(2)
+            << (archive_bytes > 0 ? double(log_bytes) / archive_bytes : 0.)
+            << ", " << std::setprecision(1)
+            << (seconds > 0 ? log_bytes / seconds / 1e6 : 0.) << " MB/s"
+            << std::endl;
+}
+
+int compress(const std::string& log_file, const std::string& archive_file,
+             const flt::io::archive_config& config) {
+  const auto t_start = clock_type::now();
+  auto reader = flt::io::line_reader{log_file};
+  auto fout = std::ofstream{archive_file, std::ios::binary};
+  if (!fout)
+    throw std::runtime_error{"Couldn't open " + archive_file};
+  auto writer = flt::io::archive_writer{fout, config};
+  auto log_bytes = std::uint64_t{0};
+  for (auto line = std::string_view{}; reader.next(line);) {
+    writer.add(line);
+    log_bytes += line.size() + !reader.missing_newline();
+  }
+  writer.close(!reader.missing_newline());
+  print_summary(writer.num_lines(), log_bytes, writer.bytes_written(),
+                seconds_since(t_start));
+  return 0;
+}
+
+int decompress(const std::string& archive_file, const std::string& log_file) {
+  const auto t_start = clock_type::now();
+  auto fin = std::ifstream{archive_file, std::ios::binary};
+  if (!fin)
+    throw std::runtime_error{"Couldn't open " + archive_file};
+  auto reader = flt::io::archive_reader{fin};
+  auto fout = std::optional<std::ofstream>{};
+  if (log_file != "-") {
+    fout.emplace(log_file, std::ios::binary);
+    if (!*fout)
+      throw std::runtime_error{"Couldn't open " + log_file};
+  }
+  auto& out = fout ? *fout : std::cout;
+  auto block = flt::io::archive_block{};
+  auto lines = std::vector<std::string>{};
+  auto num_lines = std::uint64_t{0};
+  auto log_bytes = std::uint64_t{0};
+  while (reader.next_block(block)) {
+    block.decode_lines(lines);
+    for (auto i = std::size_t{0}; i < lines.size(); ++i) {
+      out.write(lines[i].data(), std::streamsize(lines[i].size()));
+      log_bytes += lines[i].size();
+      if (i + 1 < lines.size() || block.final_newline()) {
+        out.put('\n');
+        ++log_bytes;
+      }
+    }
+    num_lines += lines.size();
+  }
+  out.flush();
+  if (!out)
+    throw std::runtime_error{"Couldn't write " + log_file};
+  print_summary(num_lines, log_bytes, reader.bytes_read(),
+                seconds_since(t_start));
+  return 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  auto config = flt::io::archive_config{};
+  auto args = std::vector<std::string>{};
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      const auto arg = std::string{argv[i]};
+      const auto has_value = i + 1 < argc;
+      if (arg == "--block-lines" && has_value)
+        config.block_lines = std::stoull(argv[++i]);
+      else if (arg == "--level" && has_value)
+        config.compression_level = std::stoi(argv[++i]);
+      else if (arg.rfind("--", 0) == 0)
+        throw std::invalid_argument{arg};
+      else
+        args.push_back(arg);
+    }
+    if (config.compression_level < 0 || config.compression_level > 9)
+      throw std::invalid_argument{"level must be between 0 and 9"};
+  } catch (const std::exception& e) {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    print_usage();
+    return -1;
+  }
+
+  if (args.size() != 3 || (args[0] != "compress" && args[0] != "decompress")) {
+    print_usage();
+    return -1;
+  }
+
+  try {
+    return args[0] == "compress" ? compress(args[1], args[2], config)
+                                 : decompress(args[1], args[2]);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+}
@@ -0,0 +1,218 @@
+#include <flt/io/archive_search.hpp>
+#include <flt/io/template_archive.hpp>
+#include <flt/util/bounded_queue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+struct search_job {
+  std::size_t seq{0};
+  // Sent once per search thread after the last block
+  bool last{false};
+  std::string data;
+};
+
+struct search_result {
+  std::size_t seq{0};
+  bool last{false};
+  std::size_t num_matches{0};
+  std::vector<std::string> lines;
+};
+
+// Parses predicates like 2>=1000, the slot is the parameter's position in
+// the template.
+std::pair<std::size_t, flt::io::compare_op>
+parse_predicate(const std::string& arg, std::string& value) {
+  using flt::io::compare_op;
+  auto slot_end = std::size_t{0};
+  const auto slot = std::stoull(arg, &slot_end);
+  static const auto ops = std::vector<std::pair<std::string, compare_op>>{
+      {">=", compare_op::greater_equal}, {"<=", compare_op::less_equal},
+      {"!=", compare_op::not_equal},     {"=", compare_op::equal},
+      {"<", compare_op::less},           {">", compare_op::greater}};
+  for (const auto& [text, op] : ops) {
+    if (arg.compare(slot_end, text.size(), text) == 0) {
+      value = arg.substr(slot_end + text.size());
+      return {slot, op};
+    }
+  }
+  throw std::invalid_argument{arg};
+}
+
+void print_usage() {
+  std::cerr << "Usage: log_search [--template TEXT] [--param SLOTOPVALUE] "
+               "[--count]\n"
+               "                  [--threads N] <archive> [<text>]\n"
+               "  Prints the lines of a template archive containing text, in "
+               "their order\n"
+               "  --template TEXT     Only lines of templates containing TEXT, "
+               "parameters\n"
+               "                      are written as <*>\n"
+               "  --param SLOTOPVALUE Only lines whose parameter at SLOT "
+               "compares to VALUE\n"
+               "                      with OP, one of = != < <= > >=, e.g. "
+               "--param 1>=1000.\n"
+               "                      Integers are compared as numbers. Can "
+               "be repeated\n"
+               "  --count             Only print the number of matching "
+               "lines\n"
+               "  --threads N         Threads searching blocks (default "
+               "number of cores)\n"
+            << std::flush;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  auto query = flt::io::archive_query{};
+  auto count_only = false;
+  auto num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  auto args = std::vector<std::string>{};
+  auto template_pattern = std::string{};
+  auto predicates = std::vector<std::string>{};
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      const auto arg = std::string{argv[i]};
+      const auto has_value = i + 1 < argc;
+      if (arg == "--template" && has_value)
+        template_pattern = argv[++i];
+      else if (arg == "--param" && has_value)
+        predicates.emplace_back(argv[++i]);
+      else if (arg == "--count")
+        count_only = true;
+      else if (arg == "--threads" && has_value)
+        num_threads = unsigned(std::stoul(argv[++i]));
+      else if (arg.rfind("--", 0) == 0)
+        throw std::invalid_argument{arg};
+      else
+        args.push_back(arg);
+    }
+    if (num_threads == 0)
+      throw std::invalid_argument{"threads must be > 0"};
+    if (args.empty() || args.size() > 2)
+      throw std::invalid_argument{"need an archive and at most one text"};
+    query = flt::io::archive_query{args.size() == 2 ? args[1] : ""};
+    query.template_contains(template_pattern);
+    for (const auto& predicate : predicates) {
+      auto value = std::string{};
+      const auto [slot, op] = parse_predicate(predicate, value);
+      query.where(slot, op, value);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    print_usage();
+    return -1;
+  }
+
+  auto fin = std::ifstream{args[0], std::ios::binary};
+  if (!fin) {
+    std::cerr << "Couldn't open " << args[0] << std::endl;
+    return -1;
+  }
+
+  const auto t_start = clock_type::now();
+  using flt::util::bounded_queue;
+  auto jobs = bounded_queue<search_job>(4 * num_threads);
+  auto results = bounded_queue<search_result>(4 * num_threads);
+  auto error = std::exception_ptr{};
+  auto error_mutex = std::mutex{};
+  const auto set_error = [&] {
+    auto lock = std::lock_guard{error_mutex};
+    if (!error)
+      error = std::current_exception();
+  };
+
+  auto num_blocks = std::size_t{0};
+  auto archive_bytes = std::uint64_t{0};
+  auto reader_thread = std::thread{[&] {
+    try {
+      auto reader = flt::io::archive_reader{fin};
+      for (auto job = search_job{}; reader.read_block(job.data);) {
+        job.seq = num_blocks++;
+        jobs.push(std::move(job));
+        job = search_job{};
+      }
+      archive_bytes = reader.bytes_read();
+    } catch (...) {
+      set_error();
+    }
+    for (auto i = 0u; i < num_threads; ++i)
+      jobs.push(search_job{0, true, {}});
+  }};
+
+  auto searchers = std::vector<std::thread>{};
+  for (auto i = 0u; i < num_threads; ++i) {
+    searchers.emplace_back([&] {
+      auto block = flt::io::archive_block{};
+      for (auto job = search_job{}; jobs.pop(job), !job.last;) {
+        auto result = search_result{job.seq, false, 0, {}};
+        try {
+          block.parse(std::move(job.data));
+          result.num_matches =
+              query.search(block, count_only ? nullptr : &result.lines);
+        } catch (...) {
+          set_error();
+        }
+        results.push(std::move(result));
+      }
+      results.push(search_result{0, true, 0, {}});
+    });
+  }
+
+  auto pending = std::map<std::size_t, search_result>{};
+  auto next_seq = std::size_t{0};
+  auto num_matches = std::uint64_t{0};
+  auto result = search_result{};
+  for (auto num_last = 0u; num_last < num_threads;) {
+    results.pop(result);
+    if (result.last) {
+      ++num_last;
+      continue;
+    }
+    pending.emplace(result.seq, std::move(result));
+    for (auto next = pending.begin();
+         next != pending.end() && next->first == next_seq;
+         next = pending.erase(next), ++next_seq) {
+      num_matches += next->second.num_matches;
+      for (const auto& line : next->second.lines)
+        std::cout << line << '\n';
+    }
+  }
+  reader_thread.join();
+  for (auto& searcher : searchers)
+    searcher.join();
+  std::cout << std::flush;
+
+  if (error) {
+    try {
+      std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+  }
+  if (count_only)
+    std::cout << num_matches << std::endl;
+  const auto seconds =
+      std::chrono::duration<double>(clock_type::now() - t_start).count();
+  std::cerr << num_matches << " matching lines in " << num_blocks
+            << " blocks, " << archive_bytes << " archive bytes searched in "
+            << std::fixed << std::setprecision(3) << seconds << " s"
+            << std::endl;
+  return 0;
+}
@@ -1,76 +1,1211 @@
-#include <flt/parameter_filter/common_regex_filters.hpp>
+#include <flt/io/file_follower.hpp>
+#include <flt/io/line_reader.hpp>
+#include <flt/io/syslog_receiver.hpp>
+#include <flt/io/worker_states.hpp>
+#include <flt/logline/event_assembler.hpp>
+#include <flt/logline/syslog.hpp>
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/parameter_filter/filter_cache.hpp>
 #include <flt/parameter_filter/filter_array.hpp>
-#include <flt/parameter_filter/ipv6_address_filter.hpp>
 #include <flt/templating/online_templater.hpp>
+#include <flt/util/bounded_queue.hpp>
+#include <flt/util/resource_usage.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(FLT_IO_HAVE_WORKER_STATES) && __has_include(<spawn.h>) &&        \
+    __has_include(<sys/wait.h>)
+#define FLT_HAVE_LOCAL_WORKERS
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+using filter_array_type =
+    flt::parameter_filter::filter_array<std::vector<std::string>::iterator,
+                                        std::string>;
+using filter_cache_type =
+    flt::parameter_filter::filter_cache<filter_array_type>;
+
+// Remembers the most recent distinct lines, the oldest line is forgotten
+// first once the window is full.
+class dedup_window {
+  std::size_t capacity_;
+  std::deque<std::string> lines_;
+  std::unordered_set<std::string_view> seen_;
+
+public:
+  explicit dedup_window(std::size_t capacity) : capacity_(capacity) {}
+
+  // Returns whether the line was not seen within the window
+  bool insert(const std::string& line) {
+    if (capacity_ == 0)
+      return true;
+    if (seen_.find(line) != seen_.end())
+      return false;
+    if (lines_.size() == capacity_) {
+      seen_.erase(lines_.front());
+      lines_.pop_front();
+    }
+    seen_.insert(lines_.emplace_back(line));
+    return true;
+  }
+};
+
+struct pipeline_config {
+  unsigned int filter_threads;
+  std::size_t batch_size;
+  std::size_t queue_size;
+  // Count the lines each filter changes
+  bool collect_stats{false};
+};
+
+struct stage_stats {
+  std::uint64_t lines{0};
+  std::uint64_t bytes{0};
+  double busy_seconds{0.};
+  double cpu_seconds{0.};
+  // Number of times the stage waited on a full or empty queue
+  std::uint64_t waits{0};
+  // Most batches seen queued for the next stage
+  std::size_t max_queued{0};
+  // Lines changed by any filter and by each filter, and the lines each
+  // filter was skipped for by the screen, if collected
+  std::uint64_t changed{0};
+  std::vector<std::uint64_t> hits;
+  std::vector<std::uint64_t> skips;
+
+  stage_stats& operator+=(const stage_stats& other) {
+    lines += other.lines;
+    bytes += other.bytes;
+    busy_seconds += other.busy_seconds;
+    cpu_seconds += other.cpu_seconds;
+    waits += other.waits;
+    max_queued = std::max(max_queued, other.max_queued);
+    changed += other.changed;
+    hits.resize(std::max(hits.size(), other.hits.size()));
+    for (auto i = std::size_t{0}; i < other.hits.size(); ++i)
+      hits[i] += other.hits[i];
+    skips.resize(std::max(skips.size(), other.skips.size()));
+    for (auto i = std::size_t{0}; i < other.skips.size(); ++i)
+      skips[i] += other.skips[i];
+    return *this;
+  }
+};
+
+// Result of reading a line for the pipeline. Idle means no line is available
+// yet, which passes the lines read so far on without waiting for a full batch.
+enum class read_status { line, idle, end };
+
+struct line_batch {
+  std::size_t seq{0};
+  // Sent once per filter thread after the last batch
+  bool last{false};
+  std::vector<std::string> lines;
+};
+
+using clock_type = std::chrono::steady_clock;
+
+double seconds_since(clock_type::time_point start) {
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// Calls f and adds the wall and CPU time it took to the stage
+template <typename F> void time_stage(stage_stats& stats, F f) {
+  const auto t_start = clock_type::now();
+  const auto cpu_start = flt::util::thread_cpu_seconds();
+  f();
+  stats.cpu_seconds += flt::util::thread_cpu_seconds() - cpu_start;
+  stats.busy_seconds += seconds_since(t_start);
+}
+
+// Reads batches of lines on one thread, prepares and filters them on the
+// filter threads and passes the filtered lines in input order to consume,
+// which runs on the calling thread like batch_done, called after each batch.
+// The bounded queues between the stages exert backpressure, which also
+// bounds the batches waiting for reordering. The first error of any stage
+// stops the reading, the batches in flight are drained and the error is
+// rethrown once all threads are joined.
+template <typename ReadLine, typename Prepare, typename Consume,
+          typename BatchDone>
+void run_pipeline(ReadLine read_line, Prepare prepare,
+                  const filter_cache_type& filters,
+                  const pipeline_config& config, Consume consume,
+                  BatchDone batch_done, stage_stats& read_stats,
+                  stage_stats& filter_stats, stage_stats& consume_stats) {
+  using flt::util::bounded_queue;
+  auto read_queue = bounded_queue<line_batch>(config.queue_size);
+  auto filtered_queue = bounded_queue<line_batch>(config.queue_size);
+  auto error = std::exception_ptr{};
+  auto error_mutex = std::mutex{};
+  auto failed = std::atomic<bool>{false};
+  const auto set_error = [&] {
+    auto lock = std::lock_guard{error_mutex};
+    if (!error)
+      error = std::current_exception();
+    failed = true;
+  };
+
+  auto reader = std::thread{[&] {
+    const auto cpu_start = flt::util::thread_cpu_seconds();
+    auto batch = line_batch{};
+    auto t_start = clock_type::now();
+    try {
+      auto logline = std::string_view{};
+      for (auto status = read_line(logline);
+           status != read_status::end && !failed;
+           status = read_line(logline)) {
+        if (status == read_status::line) {
+          ++read_stats.lines;
+          read_stats.bytes += logline.size() + 1;
+          batch.lines.emplace_back(logline);
+        }
+        // Idle batches are passed on even if empty, so batch_done keeps
+        // being called while no lines arrive
+        if (batch.lines.size() == config.batch_size ||
+            status == read_status::idle) {
+          read_stats.busy_seconds += seconds_since(t_start);
+          auto seq = batch.seq;
+          read_stats.waits += read_queue.push(std::move(batch));
+          read_stats.max_queued =
+              std::max(read_stats.max_queued, read_queue.size());
+          batch = line_batch{seq + 1, false, {}};
+          batch.lines.reserve(config.batch_size);
+          t_start = clock_type::now();
+        }
+      }
+    } catch (...) {
+      set_error();
+    }
+    read_stats.busy_seconds += seconds_since(t_start);
+    if (!batch.lines.empty() && !failed)
+      read_stats.waits += read_queue.push(std::move(batch));
+    for (auto i = 0u; i < config.filter_threads; ++i)
+      read_stats.waits += read_queue.push(line_batch{0, true, {}});
+    read_stats.cpu_seconds = flt::util::thread_cpu_seconds() - cpu_start;
+  }};
+
+  auto thread_stats = std::vector<stage_stats>(config.filter_threads);
+  auto filter_workers = std::vector<std::thread>{};
+  for (auto i = 0u; i < config.filter_threads; ++i) {
+    filter_workers.emplace_back([&, &stats = thread_stats[i]] {
+      const auto cpu_start = flt::util::thread_cpu_seconds();
+      auto batch = line_batch{};
+      for (;;) {
+        stats.waits += read_queue.pop(batch);
+        if (batch.last)
+          break;
+        auto t_start = clock_type::now();
+        try {
+          for (auto& logline : batch.lines) {
+            if (failed)
+              break;
+            stats.bytes += logline.size() + 1;
+            prepare(logline);
+            // Filters only count the lines missing the cache
+            if (config.collect_stats)
+              stats.changed += filters.filter_into_by(
+                  logline, logline,
+                  [&](const std::string& line, std::string& res) {
+                    return filters.filters().filter_and_count(
+                        line, res, stats.hits, &stats.skips);
+                  });
+            else
+              filters.filter_into(logline, logline);
+          }
+        } catch (...) {
+          set_error();
+        }
+        stats.lines += batch.lines.size();
+        stats.busy_seconds += seconds_since(t_start);
+        stats.waits += filtered_queue.push(std::move(batch));
+      }
+      stats.waits += filtered_queue.push(std::move(batch));
+      stats.cpu_seconds = flt::util::thread_cpu_seconds() - cpu_start;
+    });
+  }
+
+  const auto cpu_start = flt::util::thread_cpu_seconds();
+  auto pending = std::map<std::size_t, line_batch>{};
+  auto next_seq = std::size_t{0};
+  auto batch = line_batch{};
+  for (auto num_last = 0u; num_last < config.filter_threads;) {
+    consume_stats.waits += filtered_queue.pop(batch);
+    if (batch.last) {
+      ++num_last;
+      continue;
+    }
+    // Batches are only drained after an error
+    if (failed)
+      continue;
+    pending.emplace(batch.seq, std::move(batch));
+    auto t_start = clock_type::now();
+    try {
+      for (auto next = pending.begin();
+           next != pending.end() && next->first == next_seq;
+           next = pending.erase(next), ++next_seq) {
+        for (const auto& logline : next->second.lines) {
+          consume_stats.bytes += logline.size() + 1;
+          consume(logline);
+        }
+        consume_stats.lines += next->second.lines.size();
+        batch_done();
+      }
+    } catch (...) {
+      set_error();
+    }
+    consume_stats.busy_seconds += seconds_since(t_start);
+  }
+  consume_stats.cpu_seconds += flt::util::thread_cpu_seconds() - cpu_start;
+
+  reader.join();
+  for (auto& filter_worker : filter_workers)
+    filter_worker.join();
+  for (const auto& stats : thread_stats)
+    filter_stats += stats;
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Stage throughput is given per second of busy time of all its threads, i.e.
+// the rate the stage could sustain if it never waited on its neighbours.
+void print_stage_stats(std::ostream& out, const std::string& name,
+                       unsigned int threads, const stage_stats& stats) {
+  const auto busy = stats.busy_seconds / threads;
+  out << std::left << std::setw(10) << name << std::right
+      << std::setw(8) << threads << std::setw(12) << stats.lines
+      << std::setw(12) << std::fixed << std::setprecision(3) << busy
+      << std::setw(14) << std::setprecision(0)
+      << (busy > 0 ? stats.lines / busy : 0.) << std::setw(10)
+      << stats.waits << '\n';
+}
+
+struct stage_report {
+  std::string name;
+  unsigned int threads;
+  stage_stats stats;
+};
+
+struct filter_report {
+  std::string name;
+  std::uint64_t hits;
+  std::uint64_t skips;
+};
+
+struct run_report {
+  std::string source;
+  std::string mode;
+  double wall_seconds;
+  double cpu_seconds;
+  std::size_t peak_rss_bytes;
+  std::uint64_t lines;
+  // Within the dedup window when streaming
+  std::uint64_t unique_lines;
+  std::uint64_t templates;
+  std::vector<stage_report> stages;
+  // Lines changed by the filters, and by filter in the order they are
+  // applied, with the lines each filter was skipped for
+  std::uint64_t filtered_lines;
+  std::vector<filter_report> filters;
+  flt::parameter_filter::filter_cache_stats filter_cache;
+};
+
+double per_second(double amount, double seconds) {
+  return seconds > 0 ? amount / seconds : 0.;
+}
+
+void print_report(std::ostream& out, const run_report& report) {
+  out << "Stage      Threads       Lines        MB  Busy [s]   CPU [s]"
+         "     Lines/s      MB/s\n";
+  for (const auto& [name, threads, stats] : report.stages) {
+    const auto busy = stats.busy_seconds / threads;
+    const auto megabytes = stats.bytes / 1e6;
+    out << std::left << std::setw(10) << name << std::right
+        << std::setw(8) << threads << std::setw(12) << stats.lines
+        << std::fixed << std::setprecision(1) << std::setw(10)
+        << megabytes << std::setprecision(3) << std::setw(10) << busy
+        << std::setw(10) << stats.cpu_seconds << std::setprecision(0)
+        << std::setw(12) << per_second(stats.lines, busy)
+        << std::setprecision(1) << std::setw(10)
+        << per_second(megabytes, busy) << '\n';
+  }
+  out << report.lines << " lines, " << report.unique_lines
+      << " unique lines, " << report.templates << " templates\n"
+      << std::setprecision(1) << "Filter hit rate "
+      << 100. * per_second(report.filtered_lines, report.lines) << " %";
+  for (const auto& [name, hits, skips] : report.filters)
+    if (hits > 0)
+      out << ", " << name << ' ' << hits;
+  for (auto i = std::size_t{0}; i < report.filters.size(); ++i)
+    out << (i ? ", " : "\nFilters skipped ") << report.filters[i].name
+        << ' ' << 100. * per_second(report.filters[i].skips, report.lines)
+        << " %";
+  const auto& cache = report.filter_cache;
+  if (cache.hits + cache.misses > 0)
+    out << "\nFilter cache hit rate " << 100. * cache.hit_rate() << " %, "
+        << cache.evictions << " evictions";
+  out << std::setprecision(3) << "\nWall time " << report.wall_seconds
+      << " s, CPU time " << report.cpu_seconds << " s, peak RSS "
+      << std::setprecision(1) << report.peak_rss_bytes / 1048576.
+      << " MiB" << std::endl;
+}
+
+std::string json_string(const std::string& str) {
+  auto res = std::string{"\""};
+  for (auto c : str) {
+    if (c == '"' || c == '\\') {
+      res += '\\';
+      res += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+      res += escaped;
+    } else {
+      res += c;
+    }
+  }
+  return res + '"';
+}
+
+void write_report_json(std::ostream& out, const run_report& report) {
+  out << std::setprecision(6) << "{\n  \"source\": "
+      << json_string(report.source)
+      << ",\n  \"mode\": " << json_string(report.mode)
+      << ",\n  \"wall_seconds\": " << report.wall_seconds
+      << ",\n  \"cpu_seconds\": " << report.cpu_seconds
+      << ",\n  \"peak_rss_bytes\": " << report.peak_rss_bytes
+      << ",\n  \"lines\": " << report.lines
+      << ",\n  \"unique_lines\": " << report.unique_lines
+      << ",\n  \"templates\": " << report.templates
+      << ",\n  \"filter_hit_rate\": "
+      << per_second(report.filtered_lines, report.lines)
+      << ",\n  \"filters\": [";
+  for (auto i = std::size_t{0}; i < report.filters.size(); ++i)
+    out << (i ? ",\n" : "\n") << "    {\"name\": "
+        << json_string(report.filters[i].name)
+        << ", \"hits\": " << report.filters[i].hits
+        << ", \"skipped\": " << report.filters[i].skips << '}';
+  out << "\n  ],\n  \"filter_cache\": {\"hits\": " << report.filter_cache.hits
+      << ", \"misses\": " << report.filter_cache.misses
+      << ", \"evictions\": " << report.filter_cache.evictions << '}'
+      << ",\n  \"stages\": [";
+  for (auto i = std::size_t{0}; i < report.stages.size(); ++i) {
+    const auto& [name, threads, stats] = report.stages[i];
+    const auto busy = stats.busy_seconds / threads;
+    out << (i ? ",\n" : "\n") << "    {\"name\": " << json_string(name)
+        << ", \"threads\": " << threads << ", \"lines\": " << stats.lines
+        << ", \"bytes\": " << stats.bytes
+        << ", \"busy_seconds\": " << busy
+        << ", \"cpu_seconds\": " << stats.cpu_seconds
+        << ", \"lines_per_second\": " << per_second(stats.lines, busy)
+        << ", \"bytes_per_second\": " << per_second(stats.bytes, busy)
+        << '}';
+  }
+  out << "\n  ]\n}" << std::endl;
+}
+
+// The templates are written to temporary files first and renamed, readers
+// never see partially written files. Returns the bytes written.
+std::uint64_t write_templs(
+    const flt::templating::online_templater<std::string>& templater,
+    const std::string& filename) {
+  auto bytes = std::uint64_t{0};
+  for (auto save_params : {false, true}) {
+    const auto target = save_params ? filename + "_pars" : filename;
+    const auto tmp = target + ".tmp";
+    {
+      auto fout = std::ofstream{tmp};
+      templater.save_templs(fout, save_params);
+      bytes += std::uint64_t(std::max<std::streamoff>(fout.tellp(), 0));
+    }
+    std::rename(tmp.c_str(), target.c_str());
+  }
+  return bytes;
+}
+
+std::atomic<bool> stop_requested{false};
+
+void request_stop(int) { stop_requested = true; }
+
+// Reads lines from a file follower or syslog receiver until a stop is
+// requested. Lines are batched while more are available, a partial batch is
+// passed on as soon as the source has no more lines.
+template <typename Source> auto make_live_reader(Source& source) {
+  return [&source, caught_up = true](std::string_view& logline) mutable {
+    if (stop_requested)
+      return read_status::end;
+    const auto timeout = std::chrono::milliseconds{caught_up ? 250 : 0};
+    caught_up = !source.next(logline, timeout);
+    return caught_up ? read_status::idle : read_status::line;
+  };
+}
+
+// Passes on events joined from continuation lines if an assembler is given.
+// A pending event is passed on at the end of the input, or once the source
+// stayed idle twice in a row, so live sources don't hold back the last event.
+template <typename ReadLine>
+auto assemble_events(ReadLine read_line,
+                     std::optional<flt::logline::event_assembler>& assembler) {
+  return [read_line, &assembler,
+          idle = false](std::string_view& logline) mutable {
+    if (!assembler)
+      return read_line(logline);
+    for (;;) {
+      const auto status = read_line(logline);
+      if (status == read_status::line) {
+        idle = false;
+        if (!assembler->push(logline))
+          continue;
+        logline = assembler->event();
+        return read_status::line;
+      }
+      if ((status == read_status::end || idle) && assembler->flush()) {
+        logline = assembler->event();
+        return read_status::line;
+      }
+      idle = status == read_status::idle;
+      return status;
+    }
+  };
+}
+
+using templater_type = flt::templating::online_templater<std::string>;
+
+templater_type make_templater() { return templater_type(0.34, true); }
+
+// Parses I/N
+std::pair<std::size_t, std::size_t> parse_part(const std::string& part) {
+  const auto slash = part.find('/');
+  if (slash == std::string::npos)
+    throw std::invalid_argument{"part " + part};
+  const auto index = std::stoull(part.substr(0, slash));
+  const auto num_parts = std::stoull(part.substr(slash + 1));
+  if (index >= num_parts)
+    throw std::invalid_argument{"part " + part};
+  return {index, num_parts};
+}
+
+#ifdef FLT_IO_HAVE_WORKER_STATES
+// The states are merged in the order of their parts, so the templates only
+// depend on how the log was split and not on which worker finished first.
+template <typename Stop>
+int merge_worker_states(flt::io::state_collector& collector,
+                        std::size_t num_parts,
+                        const std::string& templates_file, Stop stop) {
+  const auto t_start = clock_type::now();
+  auto states = std::vector<flt::io::worker_state>{};
+  try {
+    states = collector.collect(num_parts, stop);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  const auto wait_seconds = seconds_since(t_start);
+  const auto t_merge = clock_type::now();
+  auto templater = make_templater();
+  auto num_lines = std::uint64_t{0};
+  for (const auto& state : states) {
+    auto part_templater = make_templater();
+    auto in = std::istringstream{state.state};
+    try {
+      part_templater.load_state(in);
+    } catch (const std::exception& e) {
+      std::cerr << "Part " << state.part << ": " << e.what() << std::endl;
+      return -1;
+    }
+    templater.merge(part_templater);
+    num_lines += state.num_lines;
+  }
+  templater.split_templs();
+  write_templs(templater, templates_file);
+  std::cout << "Merged the templates of " << num_parts << " parts with "
+            << num_lines << " lines into " << templater.get_stats().templates
+            << " templates in " << std::fixed << std::setprecision(3)
+            << seconds_since(t_merge) << " s, waited " << wait_seconds
+            << " s for the workers" << std::endl;
+  return 0;
+}
+#endif
+
+#ifdef FLT_HAVE_LOCAL_WORKERS
+// Runs this program once per part as a worker sending its state over a Unix
+// socket in a temporary directory. The coordinator gives up as soon as a
+// worker fails.
+int run_local_workers(const std::string& program,
+                      const std::vector<std::string>& worker_args,
+                      std::size_t num_workers, const std::string& log_file,
+                      const std::string& templates_file) {
+  const auto* tmp_dir = std::getenv("TMPDIR");
+  auto dir = std::string{tmp_dir && *tmp_dir ? tmp_dir : "/tmp"} +
+             "/flt-templater-XXXXXX";
+  if (!::mkdtemp(dir.data())) {
+    std::cerr << "Couldn't create a temporary directory" << std::endl;
+    return -1;
+  }
+  auto result = -1;
+  {
+    auto collector = std::optional<flt::io::state_collector>{};
+    try {
+      collector.emplace("unix:" + dir + "/coordinator");
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      ::rmdir(dir.c_str());
+      return -1;
+    }
+
+    auto workers = std::vector<pid_t>{};
+    auto running = std::vector<bool>{};
+    auto failed = false;
+    for (auto part = std::size_t{0}; part < num_workers && !failed; ++part) {
+      auto args = std::vector<std::string>{program};
+      args.insert(args.end(), worker_args.begin(), worker_args.end());
+      args.insert(args.end(),
+                  {"--part",
+                   std::to_string(part) + '/' + std::to_string(num_workers),
+                   "--send-state", collector->address(), log_file});
+      auto argv = std::vector<char*>{};
+      for (auto& arg : args)
+        argv.push_back(arg.data());
+      argv.push_back(nullptr);
+      auto pid = pid_t{};
+      if (const auto error = ::posix_spawnp(&pid, program.c_str(), nullptr,
+                                            nullptr, argv.data(), environ);
+          error != 0) {
+        std::cerr << "Couldn't start worker: " << std::strerror(error)
+                  << std::endl;
+        failed = true;
+        break;
+      }
+      workers.push_back(pid);
+      running.push_back(true);
+    }
+
+    const auto reap = [&](int options) {
+      for (auto i = std::size_t{0}; i < workers.size(); ++i) {
+        auto status = 0;
+        if (running[i] && ::waitpid(workers[i], &status, options) > 0) {
+          running[i] = false;
+          failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+      }
+      return failed;
+    };
+    const auto stop = [&] { return stop_requested || reap(WNOHANG); };
+    if (!failed)
+      result = merge_worker_states(*collector, num_workers, templates_file,
+                                   stop);
+    if (result != 0)
+      for (auto i = std::size_t{0}; i < workers.size(); ++i)
+        if (running[i])
+          ::kill(workers[i], SIGTERM);
+    if (reap(0)) {
+      std::cerr << "A worker failed" << std::endl;
+      result = -1;
+    }
+  }
+  ::rmdir(dir.c_str());
+  return result;
+}
+#endif
+
+void print_usage() {
+  std::cerr << "Usage: online_templater [--filter-threads N] [--batch-size N] "
+               "[--queue-size N] [--filter-cache N] [--stream] "
+               "[--dedup-window N]\n"
+               "                        [--write-interval N] "
+               "[--write-seconds N] [--max-memory BYTES] [--follow]\n"
+               "                        [--udp [HOST:]PORT] "
+               "[--tcp [HOST:]PORT] [--syslog-format F]\n"
+               "                        [--receive-buffer BYTES] [--workers N] "
+               "[--part I/N]\n"
+               "                        [--send-state ADDRESS] "
+               "[--coordinate ADDRESS]\n"
+               "                        [--events RULE] [--stats] "
+               "[--stats-json FILE]\n"
+               "                        [<log file>] [<templates file>]\n"
+               "  A log file of - reads from stdin, gzip and zstd compressed "
+               "input is\n"
+               "  decompressed on the fly\n"
+               "  --filter-threads N  Threads running the parameter filters "
+               "(default\n"
+               "                      number of cores minus two, at least "
+               "one)\n"
+               "  --batch-size N      Lines per batch passed between threads "
+               "(default\n"
+               "                      1024)\n"
+               "  --queue-size N      Batches queued between two stages "
+               "(default 64)\n"
+               "  --filter-cache N    Cache the filtered lines of up to N "
+               "distinct lines,\n"
+               "                      which repeated lines are taken from, 0 "
+               "disables\n"
+               "                      (default 0). Filter hits are only "
+               "counted for\n"
+               "                      lines not found in the cache\n"
+               "  --stream            Template line by line instead of "
+               "collecting\n"
+               "                      the unique lines of the whole log "
+               "first\n"
+               "  --events RULE       Join continuation lines like stack "
+               "traces to the\n"
+               "                      line starting their event. RULE gives "
+               "the lines\n"
+               "                      starting events: timestamp, indent or "
+               "syslog\n"
+               "  --stats             Report the throughput, wall and CPU "
+               "time of the\n"
+               "                      read, filter, dedup, template, split "
+               "and output\n"
+               "                      stages, the filter hit and skip "
+               "rates and the peak\n"
+               "                      memory\n"
+               "  --stats-json FILE   Write the report as JSON to FILE, - for "
+               "stdout, which\n"
+               "                      moves all other output to stderr\n"
+               "Options in streaming mode:\n"
+               "  --dedup-window N    Skip lines equal to one of the last N "
+               "distinct\n"
+               "                      lines, 0 disables (default 100000)\n"
+               "  --write-interval N  Write the templates every N lines and "
+               "at EOF,\n"
+               "                      0 only writes at EOF (default "
+               "1000000)\n"
+               "  --write-seconds N   Write the templates every N seconds if "
+               "lines were\n"
+               "                      templated since the last write, 0 "
+               "disables\n"
+               "                      (default 60 with --follow, else 0)\n"
+               "  --max-memory BYTES  Evict the least recently used templates "
+               "beyond\n"
+               "                      BYTES at every write, 0 disables "
+               "(default 0)\n"
+               "  --follow            Keep reading lines appended to the log "
+               "file, like\n"
+               "                      tail -F, until interrupted. Rotated "
+               "and truncated\n"
+               "                      log files are followed. Implies "
+               "--stream\n"
+               "  --udp [HOST:]PORT   Receive syslog messages over UDP "
+               "instead of reading\n"
+               "                      a log file, until interrupted. Implies "
+               "--stream\n"
+               "  --tcp [HOST:]PORT   Receive syslog messages over TCP, octet "
+               "counted or\n"
+               "                      newline framed. Implies --stream\n"
+               "  --syslog-format F   Format of received messages, the "
+               "message including\n"
+               "                      its tag is templated (default\n"
+               "                      \"<${PRIORITY}>${DATE} ${ORIGIN} "
+               "${MESSAGE}\")\n"
+               "  --receive-buffer BYTES\n"
+               "                      UDP socket receive buffer (default "
+               "8 MiB)\n"
+               "Distributed templating, addresses are [HOST:]PORT or "
+               "unix:PATH:\n"
+               "  --workers N         Template N parts of the log file in "
+               "as many worker\n"
+               "                      processes and merge their templates\n"
+               "  --part I/N          Only template the lines starting in "
+               "the I-th of N\n"
+               "                      equally sized parts of the log file, "
+               "counting from 0\n"
+               "  --send-state ADDRESS\n"
+               "                      Send the templates learned to a "
+               "coordinator instead\n"
+               "                      of writing them, no templates file is "
+               "given\n"
+               "  --coordinate ADDRESS\n"
+               "                      Merge the templates of the --workers N "
+               "parts sent\n"
+               "                      to ADDRESS, no log file is given. The "
+               "templates only\n"
+               "                      depend on the parts, not on the order "
+               "they arrive in\n"
+            << std::flush;
+}
+} // namespace
 
 int main(int argc, char** argv) {
+  auto stream = false;
+  auto follow = false;
+  auto dedup_window_size = std::size_t{100000};
+  auto write_interval = std::size_t{1000000};
+  auto write_seconds = std::optional<double>{};
+  auto max_memory = std::size_t{0};
+  auto filter_cache_size = std::size_t{0};
+  auto config = pipeline_config{
+      std::max(std::thread::hardware_concurrency(), 3u) - 2, 1024, 64};
+  auto receiver_config = flt::io::receiver_config{};
+  auto syslog_format = std::string{"<${PRIORITY}>${DATE} ${ORIGIN} ${MESSAGE}"};
+  auto num_workers = std::size_t{0};
+  auto part = std::pair<std::size_t, std::size_t>{0, 1};
+  auto send_address = std::string{};
+  auto coordinate_address = std::string{};
+  auto filter_threads_given = false;
+  auto print_stats = false;
+  auto stats_json = std::string{};
+  auto assembler = std::optional<flt::logline::event_assembler>{};
+  // Options passed on to local workers
+  auto worker_args = std::vector<std::string>{};
+  auto files = std::vector<std::string>{};
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      const auto arg = std::string{argv[i]};
+      const auto has_value = i + 1 < argc;
+      const auto first = i;
+      if (arg == "--workers" && has_value)
+        num_workers = std::stoull(argv[++i]);
+      else if (arg == "--part" && has_value)
+        part = parse_part(argv[++i]);
+      else if (arg == "--send-state" && has_value)
+        send_address = argv[++i];
+      else if (arg == "--coordinate" && has_value)
+        coordinate_address = argv[++i];
+      else if (arg == "--stream")
+        stream = true;
+      else if (arg == "--follow")
+        stream = follow = true;
+      else if (arg == "--dedup-window" && has_value)
+        dedup_window_size = std::stoull(argv[++i]);
+      else if (arg == "--write-interval" && has_value)
+        write_interval = std::stoull(argv[++i]);
+      else if (arg == "--write-seconds" && has_value)
+        write_seconds = std::stod(argv[++i]);
+      else if (arg == "--max-memory" && has_value)
+        max_memory = std::stoull(argv[++i]);
+      else if (arg == "--udp" && has_value)
+        receiver_config.udp_address = argv[++i];
+      else if (arg == "--tcp" && has_value)
+        receiver_config.tcp_address = argv[++i];
+      else if (arg == "--syslog-format" && has_value)
+        syslog_format = argv[++i];
+      else if (arg == "--receive-buffer" && has_value)
+        receiver_config.receive_buffer_size = std::stoi(argv[++i]);
+      else if (arg == "--filter-threads" && has_value) {
+        config.filter_threads = unsigned(std::stoul(argv[++i]));
+        filter_threads_given = true;
+      }
+      else if (arg == "--events" && has_value)
+        assembler.emplace(flt::logline::parse_event_start(argv[++i]));
+      else if (arg == "--stats")
+        print_stats = config.collect_stats = true;
+      else if (arg == "--stats-json" && has_value) {
+        stats_json = argv[++i];
+        config.collect_stats = true;
+      }
+      else if (arg == "--batch-size" && has_value)
+        config.batch_size = std::stoull(argv[++i]);
+      else if (arg == "--queue-size" && has_value)
+        config.queue_size = std::stoull(argv[++i]);
+      else if (arg == "--filter-cache" && has_value)
+        filter_cache_size = std::stoull(argv[++i]);
+      else if (arg.rfind("--", 0) == 0)
+        throw std::invalid_argument{arg};
+      else
+        files.push_back(arg);
+      // Workers print their statistics but don't write the coordinator's
+      if (arg.rfind("--", 0) == 0 && arg != "--workers" &&
+          arg != "--stats-json")
+        worker_args.insert(worker_args.end(), argv + first, argv + i + 1);
+    }
+    if (config.filter_threads == 0 || config.batch_size == 0 ||
+        config.queue_size == 0)
+      throw std::invalid_argument{"thread, batch and queue sizes must be > 0"};
+  } catch (const std::exception& e) {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    print_usage();
+    return -1;
+  }
 
-  if (argc != 3) {
-    std::cerr << "Invalid number of arguments. Need input log file, output "
-                 "templates file"
-              << std::endl;
+  const auto receive = !receiver_config.udp_address.empty() ||
+                       !receiver_config.tcp_address.empty();
+  const auto coordinate = !coordinate_address.empty();
+  const auto send_state = !send_address.empty();
+  const auto need_log = !receive && !coordinate;
+  const auto need_templates = !send_state;
+  if (files.size() != std::size_t(need_log) + need_templates) {
+    std::cerr << "Invalid number of arguments. Need "
+              << (need_log ? "input log file" : "")
+              << (need_log && need_templates ? ", " : "")
+              << (need_templates ? "output templates file" : "") << std::endl;
+    print_usage();
     return -1;
   }
+  const auto templates_file = need_templates ? files.back() : std::string{};
+  const auto source = receive ? std::string{"syslog messages"}
+                      : need_log ? files[0]
+                                 : std::string{};
+  stream = stream || receive;
 
-  auto is_log = std::ifstream{argv[1]};
-  if (!is_log) {
-    std::cerr << "Couldn't open log file " << argv[1] << std::endl;
+  const auto split = part.second > 1 || num_workers > 0;
+  if ((coordinate && (receive || follow || send_state || part.second > 1)) ||
+      (num_workers > 0 && (receive || follow || send_state)) ||
+      (split && (receive || follow || source == "-"))) {
+    std::cerr << "Only log files can be split into parts, workers and "
+                 "coordinators template nothing else"
+              << std::endl;
+    return -1;
+  }
+  if (coordinate && num_workers == 0) {
+    std::cerr << "Need the number of --workers to coordinate" << std::endl;
+    return -1;
+  }
+  if (num_workers > 0) {
+#ifdef FLT_IO_HAVE_WORKER_STATES
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+    if (coordinate) {
+      auto collector = std::optional<flt::io::state_collector>{};
+      try {
+        collector.emplace(coordinate_address);
+      } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+      }
+      std::cout << "Waiting for " << num_workers << " workers on "
+                << collector->address() << std::endl;
+      return merge_worker_states(*collector, num_workers, templates_file,
+                                 [] { return bool(stop_requested); });
+    }
+#endif
+#ifdef FLT_HAVE_LOCAL_WORKERS
+    // The cores are shared by the workers unless told otherwise
+    if (!filter_threads_given)
+      worker_args.insert(
+          worker_args.end(),
+          {"--filter-threads",
+           std::to_string(std::max<std::size_t>(
+               std::thread::hardware_concurrency() / num_workers, 2) -
+               1)});
+    return run_local_workers(argv[0], worker_args, num_workers, source,
+                             templates_file);
+#else
+    std::cerr << "Distributed templating is not supported here" << std::endl;
     return -1;
+#endif
   }
 
+  if (follow && receive) {
+    std::cerr << "Can either follow a log file or receive syslog messages"
+              << std::endl;
+    return -1;
+  }
+  if (follow && files[0] == "-") {
+    std::cerr << "Can only follow log files, not stdin" << std::endl;
+    return -1;
+  }
 
-  using namespace flt::parameter_filter::regex_filters;
-  using namespace flt::parameter_filter;
-
-  auto f1 = pointed_bracket_filter();
-  auto f2 = square_bracket_filter();
-  auto f3 = hexadec_constant_filter();
-  auto f4 = ipv4_address_filter();
-  auto f5 = mac_address_filter();
-  auto f6 = linux_netif_filter();
-  auto f7 = time_duration_filter();
-  auto f8 = data_size_filter();
-  auto f9 = linux_mem_size_filter();
-  auto f10 = linux_kernel_audit_filter();
-  auto f11 = ipv6_address_filter<>();
-  auto f12 = libvirtd_filter();
-  auto f13 = UUID_filter();
-  auto f14 = time_filter();
-  auto f15 = date_filter();
-  auto f16 = long_date_filter();
-  auto f17 = extended_date_filter();
-  auto f99 = number_constant_filter();
-  auto w = filter_array<std::vector<std::string>::iterator, std::string>{
-      f99, f1,  f2,  f3,  f4,  f5,  f6,  f7,  f8,
-      f9,  f10, f11, f12, f13, f14, f15, f16, f17};
-
-  std::cout << "Filtering log file: " << argv[1] << std::endl;
-  std::cout << "Templating log file: " << argv[1] << std::endl;
-  auto loglines = std::set<std::string>{};
-  auto logline = std::string{};
-  while (std::getline(is_log, logline))
-    loglines.insert(w(logline));
-
-  
-  std::cout << "Templating log file: " << argv[1] << std::endl;
-  using namespace flt::templating::online;
-  auto templater = online_templater<std::string>(0.34, true);
-  for (const auto& logline : loglines) {
-    templater(logline);
+  auto log_reader = std::optional<flt::io::line_reader>{};
+  auto log_follower = std::optional<flt::io::file_follower>{};
+  auto receiver = std::optional<flt::io::syslog_receiver>{};
+  auto parser = std::optional<flt::logline::logline_parser>{};
+  try {
+    if (receive) {
+      parser.emplace(syslog_format);
+      receiver.emplace(receiver_config);
+    } else if (follow) {
+      log_follower.emplace(files[0]);
+    } else {
+      log_reader.emplace(files[0]);
+      if (part.second > 1)
+        log_reader->select_part(part.first, part.second);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
   }
 
-  templater.split_templs();
+  const auto read_line = [&](std::string_view& logline) {
+    return log_reader->next(logline) ? read_status::line : read_status::end;
+  };
+
+  // Received messages are parsed on the filter threads, messages not
+  // matching the format are templated as they are
+  auto num_unparsed = std::atomic<std::uint64_t>{0};
+  const auto parse_message = [&](std::string& message) {
+    auto parsed = flt::logline::logline{};
+    auto in = std::istringstream{message};
+    try {
+      in >> (*parser)(parsed);
+      if (!in.fail()) {
+        message = parsed.get_full_message();
+        return;
+      }
+    } catch (const std::exception&) {
+    }
+    ++num_unparsed;
+  };
+  const auto keep_line = [](std::string&) {};
+
+  auto w = filter_cache_type{flt::parameter_filter::default_filters(),
+                             filter_cache_size};
+  auto templater = make_templater();
+  auto read_stats = stage_stats{};
+  auto filter_stats = stage_stats{};
+  auto consume_stats = stage_stats{};
+  auto dedup_stats = stage_stats{};
+  auto templ_stats = stage_stats{};
+  auto split_stats = stage_stats{};
+  auto output_stats = stage_stats{};
+  auto evict_stats = stage_stats{};
+  const auto t_start = clock_type::now();
+  const auto cpu_start = flt::util::process_cpu_seconds();
+
+  // Errors of the pipeline are reported like those of the other steps
+  const auto run_stages = [&](auto read_line, auto prepare, auto consume,
+                              auto batch_done) {
+    try {
+      run_pipeline(read_line, prepare, w, config, consume, batch_done,
+                   read_stats, filter_stats, consume_stats);
+      return true;
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+  };
+
+  const auto split_and_write = [&] {
+    time_stage(split_stats, [&] { templater.split_templs(); });
+    const auto num_templs = templater.get_stats().templates;
+    split_stats.lines += num_templs;
+    time_stage(output_stats, [&] {
+      output_stats.bytes += write_templs(templater, templates_file);
+      output_stats.lines += num_templs;
+    });
+  };
 
-  auto fout = std::ofstream{argv[2]};
-  templater.save_templs(fout);
-  fout.close();
+  // Workers send the templates learned instead of writing them, they are
+  // split by the coordinator after merging
+  const auto finish = [&] {
+    if (!send_state) {
+      split_and_write();
+      return;
+    }
+#ifdef FLT_IO_HAVE_WORKER_STATES
+    time_stage(output_stats, [&] {
+      auto out = std::ostringstream{};
+      templater.save_state(out);
+      output_stats.bytes += out.str().size();
+      flt::io::send_worker_state(send_address, {part.first, part.second,
+                                                read_stats.lines, out.str()});
+    });
+#else
+    throw std::runtime_error{"Sending templater states is not supported here"};
+#endif
+  };
 
-  auto fout_pars = std::ofstream{std::string{argv[2]} + "_pars"};
-  templater.save_templs(fout_pars, true);
-  fout_pars.close();
+  // A JSON report written to stdout is all that goes there
+  auto& info = stats_json == "-" ? std::cerr : std::cout;
+  if (stream) {
+    // Memory is bounded by the dedup window, the batches in flight and the
+    // templates, which can be limited with --max-memory
+    info << (receive  ? "Receiving"
+             : follow ? "Following"
+                      : "Streaming")
+         << (receive ? " " : " log file: ") << source << std::endl;
+    auto seen = dedup_window{dedup_window_size};
+    auto num_lines = std::size_t{0};
+    auto unwritten = false;
+    auto last_write = clock_type::now();
+    const auto write = [&] {
+      if (max_memory != 0)
+        time_stage(evict_stats, [&] {
+          if (templater.evict_templs(max_memory) > 0)
+            templater.compact_dictionary();
+        });
+      if (!send_state)
+        split_and_write();
+      unwritten = false;
+      last_write = clock_type::now();
+    };
+    const auto consume = [&](const std::string& logline) {
+      // Timing every line is only paid for with statistics
+      if (config.collect_stats) {
+        const auto t_dedup = clock_type::now();
+        const auto unique = seen.insert(logline);
+        const auto t_templ = clock_type::now();
+        dedup_stats.busy_seconds +=
+            std::chrono::duration<double>(t_templ - t_dedup).count();
+        ++dedup_stats.lines;
+        dedup_stats.bytes += logline.size() + 1;
+        if (unique) {
+          templater(logline);
+          templ_stats.busy_seconds += seconds_since(t_templ);
+          ++templ_stats.lines;
+          templ_stats.bytes += logline.size() + 1;
+        }
+      } else if (seen.insert(logline)) {
+        templater(logline);
+      }
+      unwritten = true;
+      if (write_interval != 0 && ++num_lines % write_interval == 0)
+        write();
+    };
+    // Writes split the templates, timed writes are off by default unless
+    // following, so the output of a log file doesn't depend on the timing
+    const auto write_period =
+        write_seconds.value_or(follow || receive ? 60. : 0.);
+    const auto batch_done = [&] {
+      if (unwritten && write_period > 0 &&
+          seconds_since(last_write) >= write_period)
+        write();
+    };
+    if (receive) {
+      std::signal(SIGINT, request_stop);
+      std::signal(SIGTERM, request_stop);
+      if (!run_stages(
+              assemble_events(make_live_reader(*receiver), assembler),
+              parse_message, consume, batch_done))
+        return -1;
+      const auto& stats = receiver->stats();
+      info << "Received " << stats.datagrams + stats.tcp_messages
+           << " messages (" << stats.datagrams << " datagrams, "
+           << stats.tcp_messages << " over " << stats.connections
+           << " TCP connections), " << stats.kernel_drops
+           << " dropped by the kernel, " << stats.truncated
+           << " truncated, " << stats.framing_errors
+           << " framing errors, " << num_unparsed << " not parsed, at "
+           << "most " << read_stats.max_queued
+           << " batches queued for filtering" << std::endl;
+    } else if (follow) {
+      std::signal(SIGINT, request_stop);
+      std::signal(SIGTERM, request_stop);
+      if (!run_stages(
+              assemble_events(make_live_reader(*log_follower), assembler),
+              keep_line, consume, batch_done))
+        return -1;
+      info << "Stopped following after " << log_follower->num_rotations()
+           << " rotations and " << log_follower->num_truncations()
+           << " truncations" << std::endl;
+    } else {
+      if (!run_stages(assemble_events(read_line, assembler), keep_line,
+                      consume, batch_done))
+        return -1;
+    }
+    if (config.collect_stats) {
+      // Lines aren't timed on the CPU clock, which is slower to read. The
+      // consuming thread's CPU time apart from writes and evictions is
+      // attributed to deduplication and templating by their share of its
+      // busy time.
+      const auto cpu =
+          std::max(consume_stats.cpu_seconds - split_stats.cpu_seconds -
+                       output_stats.cpu_seconds - evict_stats.cpu_seconds,
+                   0.);
+      const auto busy = dedup_stats.busy_seconds + templ_stats.busy_seconds;
+      dedup_stats.cpu_seconds =
+          cpu * per_second(dedup_stats.busy_seconds, busy);
+      templ_stats.cpu_seconds = cpu - dedup_stats.cpu_seconds;
+      templ_stats.busy_seconds += evict_stats.busy_seconds;
+      templ_stats.cpu_seconds += evict_stats.cpu_seconds;
+    }
+  } else {
+    info << "Filtering log file: " << files[0] << std::endl;
+    auto loglines = std::set<std::string>{};
+    if (!run_stages(
+            assemble_events(read_line, assembler), keep_line,
+            [&](const std::string& logline) { loglines.insert(logline); },
+            [] {}))
+      return -1;
+
+    dedup_stats = consume_stats;
+    info << "Templating log file: " << files[0] << std::endl;
+    time_stage(templ_stats, [&] {
+      for (const auto& logline : loglines) {
+        templater(logline);
+        templ_stats.bytes += logline.size() + 1;
+      }
+    });
+    templ_stats.lines = loglines.size();
+  }
+  if (assembler)
+    info << "Assembled " << assembler->num_events() << " events, "
+         << assembler->num_joined() << " continuation lines joined, "
+         << assembler->num_cut() << " starting a new event as theirs "
+         << "was too long" << std::endl;
+  try {
+    finish();
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+
+  const auto wall_seconds = seconds_since(t_start);
+  if (config.collect_stats) {
+    auto report = run_report{
+        source,
+        stream ? "stream" : "batch",
+        wall_seconds,
+        flt::util::process_cpu_seconds() - cpu_start,
+        flt::util::peak_rss_bytes(),
+        read_stats.lines,
+        templ_stats.lines,
+        templater.get_stats().templates,
+        {{"read", 1, read_stats},
+         {"filter", config.filter_threads, filter_stats},
+         {"dedup", 1, dedup_stats},
+         {"template", 1, templ_stats},
+         {"split", 1, split_stats},
+         {"output", 1, output_stats}},
+        filter_stats.changed,
+        {},
+        w.stats()};
+    const auto names = flt::parameter_filter::default_filter_names();
+    filter_stats.skips.resize(filter_stats.hits.size());
+    for (auto i = std::size_t{0}; i < filter_stats.hits.size(); ++i)
+      report.filters.push_back(
+          {i < names.size() ? names[i] : "filter " + std::to_string(i),
+           filter_stats.hits[i], filter_stats.skips[i]});
+    if (!stats_json.empty()) {
+      auto fout = std::ofstream{};
+      if (stats_json != "-")
+        fout.open(stats_json);
+      write_report_json(stats_json == "-" ? std::cout : fout, report);
+      if (stats_json != "-" && !fout) {
+        std::cerr << "Couldn't write " << stats_json << std::endl;
+        return -1;
+      }
+    }
+    if (print_stats) {
+      print_report(info, report);
+      return 0;
+    }
+  }
+  info << "Stage      Threads       Lines    Busy [s]       Lines/s"
+          "     Waits\n";
+  print_stage_stats(info, "read", 1, read_stats);
+  print_stage_stats(info, "filter", config.filter_threads, filter_stats);
+  print_stage_stats(info, stream ? "template" : "collect", 1, consume_stats);
+  info << "Wall time " << std::setprecision(3) << wall_seconds << " s, "
+       << std::setprecision(0) << read_stats.lines / wall_seconds
+       << " lines/s" << std::endl;
 
   return 0;
 }
@@ -0,0 +1,233 @@
+#include <flt/io/syslog_receiver.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef FLT_IO_HAVE_SYSLOG_RECEIVER
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+void print_usage() {
+  std::cerr << "Usage: syslog_sender [--tcp] [--octet-counting] [--count N] "
+               "[--rate N] [--batch N]\n"
+               "                    [--log <log file>] [<host>:]<port>\n"
+               "  Sends syslog messages to a local receiver such as "
+               "online_templater --udp,\n"
+               "  by default synthetic RFC 3164 messages, with --log the "
+               "lines of the log\n"
+               "  file over and over\n"
+               "  --tcp               Send over TCP instead of UDP, messages "
+               "are terminated\n"
+               "                      by line breaks\n"
+               "  --octet-counting    Frame the TCP messages with their "
+               "length instead\n"
+               "  --count N           Messages to send (default 1000000)\n"
+               "  --rate N            Messages per second, 0 sends as fast as "
+               "possible\n"
+               "                      (default 0)\n"
+               "  --batch N           Datagrams sent with one call (default "
+               "64)\n"
+            << std::flush;
+}
+
+class message_source {
+public:
+  explicit message_source(std::vector<std::string> lines)
+      : lines_(std::move(lines)) {}
+
+  std::string next() {
+    const auto i = num_++;
+    if (!lines_.empty())
+      return lines_[i % lines_.size()];
+    const auto seconds = (i / 1000) % 3600;
+    auto time = std::string{"10:00:00"};
+    time[3] = char('0' + seconds / 600);
+    time[4] = char('0' + seconds / 60 % 10);
+    time[6] = char('0' + seconds % 60 / 10);
+    time[7] = char('0' + seconds % 10);
+    const auto host = std::to_string(i % 13);
+    switch (i % 4) {
+    case 0:
+      return "<13>Oct 18 " + time + " host" + host + " app[" +
+             std::to_string(1000 + i % 17) + "]: request id=" +
+             std::to_string(i) + " user=user" + std::to_string(i % 31) +
+             " status=200";
+    case 1:
+      return "<38>Oct 18 " + time + " host" + host +
+             " sshd[42]: Accepted publickey for user" +
+             std::to_string(i % 31) + " from 10.0.0." +
+             std::to_string(i % 251) + " port " +
+             std::to_string(40000 + i % 20000) + " ssh2";
+    case 2:
+      return "<6>Oct 18 " + time + " host" + host +
+             " kernel: eth0: link up, speed " +
+             std::to_string(i % 3 ? 1000 : 100) + " Mbps";
+    default:
+      return "<11>Oct 18 " + time + " host" + host +
+             " app[7]: cache miss for key session:" + std::to_string(i % 1000);
+    }
+  }
+
+private:
+  std::vector<std::string> lines_;
+  std::uint64_t num_{0};
+};
+
+void send_all(int fd, const std::string& data) {
+  for (auto pos = std::size_t{0}; pos < data.size();) {
+    const auto num_sent = ::send(fd, data.data() + pos, data.size() - pos, 0);
+    if (num_sent < 0 && errno == EINTR)
+      continue;
+    if (num_sent <= 0)
+      throw std::system_error{errno, std::generic_category(), "send"};
+    pos += std::size_t(num_sent);
+  }
+}
+
+void send_datagrams(int fd, const std::vector<std::string>& messages) {
+#ifdef __linux__
+  auto iovecs = std::vector<iovec>(messages.size());
+  auto headers = std::vector<mmsghdr>(messages.size());
+  for (auto i = std::size_t{0}; i < messages.size(); ++i) {
+    iovecs[i].iov_base = const_cast<char*>(messages[i].data());
+    iovecs[i].iov_len = messages[i].size();
+    headers[i] = mmsghdr{};
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+  for (auto pos = std::size_t{0}; pos < headers.size();) {
+    const auto num_sent = ::sendmmsg(fd, headers.data() + pos,
+                                     unsigned(headers.size() - pos), 0);
+    if (num_sent < 0 && (errno == EINTR || errno == ENOBUFS))
+      continue;
+    if (num_sent < 0)
+      throw std::system_error{errno, std::generic_category(), "sendmmsg"};
+    pos += std::size_t(num_sent);
+  }
+#else
+  for (const auto& message : messages)
+    send_all(fd, message);
+#endif
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  auto tcp = false;
+  auto octet_counting = false;
+  auto count = std::uint64_t{1000000};
+  auto rate = std::uint64_t{0};
+  auto batch_size = std::size_t{64};
+  auto log_file = std::string{};
+  auto address = std::string{};
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      const auto arg = std::string{argv[i]};
+      const auto has_value = i + 1 < argc;
+      if (arg == "--tcp")
+        tcp = true;
+      else if (arg == "--octet-counting")
+        octet_counting = true;
+      else if (arg == "--count" && has_value)
+        count = std::stoull(argv[++i]);
+      else if (arg == "--rate" && has_value)
+        rate = std::stoull(argv[++i]);
+      else if (arg == "--batch" && has_value)
+        batch_size = std::stoull(argv[++i]);
+      else if (arg == "--log" && has_value)
+        log_file = argv[++i];
+      else if (arg.rfind("--", 0) == 0 || !address.empty())
+        throw std::invalid_argument{arg};
+      else
+        address = arg;
+    }
+    if (address.empty())
+      throw std::invalid_argument{"need a port"};
+    if (batch_size == 0)
+      throw std::invalid_argument{"batch size must be > 0"};
+    if (octet_counting && !tcp)
+      throw std::invalid_argument{"--octet-counting needs --tcp"};
+    if (address.find(':') == std::string::npos)
+      address = "127.0.0.1:" + address;
+  } catch (const std::exception& e) {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    print_usage();
+    return -1;
+  }
+
+  auto lines = std::vector<std::string>{};
+  if (!log_file.empty()) {
+    auto fin = std::ifstream{log_file};
+    if (!fin) {
+      std::cerr << "Couldn't open " << log_file << std::endl;
+      return -1;
+    }
+    for (auto line = std::string{}; std::getline(fin, line);)
+      if (!line.empty())
+        lines.push_back(std::move(line));
+    if (lines.empty()) {
+      std::cerr << "No lines in " << log_file << std::endl;
+      return -1;
+    }
+  }
+
+  auto source = message_source{std::move(lines)};
+  auto num_sent = std::uint64_t{0};
+  const auto t_start = clock_type::now();
+  try {
+    const auto fd = flt::io::detail::open_socket(
+        address, tcp ? SOCK_STREAM : SOCK_DGRAM, false);
+    auto batch = std::vector<std::string>{};
+    auto buffer = std::string{};
+    while (num_sent < count) {
+      batch.clear();
+      for (; batch.size() < batch_size && num_sent + batch.size() < count;)
+        batch.push_back(source.next());
+      if (tcp) {
+        buffer.clear();
+        for (const auto& message : batch) {
+          if (octet_counting)
+            buffer.append(std::to_string(message.size())).append(1, ' ');
+          buffer.append(message);
+          if (!octet_counting)
+            buffer += '\n';
+        }
+        send_all(fd, buffer);
+      } else {
+        send_datagrams(fd, batch);
+      }
+      num_sent += batch.size();
+      if (rate > 0)
+        std::this_thread::sleep_until(
+            t_start + std::chrono::duration<double>(double(num_sent) / rate));
+    }
+    ::close(fd);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  const auto seconds =
+      std::chrono::duration<double>(clock_type::now() - t_start).count();
+  std::cerr << num_sent << " messages sent to " << address << " in "
+            << std::fixed << std::setprecision(3) << seconds << " s, "
+            << std::setprecision(0) << (seconds > 0 ? num_sent / seconds : 0.)
+            << " messages/s" << std::endl;
+  return 0;
+}
+#else
+int main() {
+  std::cerr << "Sending syslog messages is not supported here" << std::endl;
+  return -1;
+}
+#endif
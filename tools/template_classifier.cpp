@@ -0,0 +1,293 @@
+#include <flt/io/line_reader.hpp>
+#include <flt/parameter_filter/default_filters.hpp>
+#include <flt/templating/template_catalog.hpp>
+#include <flt/util/bounded_queue.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+using clock_type = std::chrono::steady_clock;
+
+using params_type = std::vector<std::string>;
+
+struct line_batch {
+  std::size_t seq{0};
+  // Sent once per classifier thread after the last batch
+  bool last{false};
+  std::vector<std::string> lines;
+};
+
+struct classified_batch {
+  std::size_t seq{0};
+  bool last{false};
+  std::size_t num_lines{0};
+  std::size_t num_matched{0};
+  std::string output;
+};
+
+// Tabs, line breaks and backslashes within parameters are escaped, the output
+// has one line of tab separated fields per logline
+void append_escaped(std::string& out, std::string_view param) {
+  for (auto c : param) {
+    if (c == '\t')
+      out += "\\t";
+    else if (c == '\n')
+      out += "\\n";
+    else if (c == '\r')
+      out += "\\r";
+    else if (c == '\\')
+      out += "\\\\";
+    else
+      out += c;
+  }
+}
+
+void print_usage() {
+  std::cerr << "Usage: template_classifier [--threads N] [--batch-size N] "
+               "[--queue-size N] [--params]\n"
+               "                           <templates file> <log file> "
+               "[<output file>]\n"
+               "  Prints the id of the template matching each line of the log "
+               "file, one\n"
+               "  line per logline. Ids are the positions of the templates in "
+               "the templates\n"
+               "  file written by online_templater, starting at 0, lines "
+               "without a matching\n"
+               "  template get a -. Templates files ending in _pars are read "
+               "with their\n"
+               "  parameters. A log file of - reads from stdin, the output "
+               "goes to stdout\n"
+               "  unless an output file other than - is given\n"
+               "  --threads N         Threads filtering and classifying lines "
+               "(default\n"
+               "                      number of cores minus one, at least "
+               "one)\n"
+               "  --batch-size N      Lines per batch passed between threads "
+               "(default\n"
+               "                      1024)\n"
+               "  --queue-size N      Batches queued between two stages "
+               "(default 64)\n"
+               "  --params            Append the parameters of each line, "
+               "tab separated.\n"
+               "                      The tokens at the template's wildcards "
+               "come first,\n"
+               "                      followed by the values replaced by the "
+               "parameter\n"
+               "                      filters in the order of the filters\n"
+            << std::flush;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  auto with_params = false;
+  auto num_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  auto batch_size = std::size_t{1024};
+  auto queue_size = std::size_t{64};
+  auto files = std::vector<std::string>{};
+  try {
+    for (auto i = 1; i < argc; ++i) {
+      const auto arg = std::string{argv[i]};
+      const auto has_value = i + 1 < argc;
+      if (arg == "--params")
+        with_params = true;
+      else if (arg == "--threads" && has_value)
+        num_threads = unsigned(std::stoul(argv[++i]));
+      else if (arg == "--batch-size" && has_value)
+        batch_size = std::stoull(argv[++i]);
+      else if (arg == "--queue-size" && has_value)
+        queue_size = std::stoull(argv[++i]);
+      else if (arg.rfind("--", 0) == 0)
+        throw std::invalid_argument{arg};
+      else
+        files.push_back(arg);
+    }
+    if (num_threads == 0 || batch_size == 0 || queue_size == 0)
+      throw std::invalid_argument{"thread, batch and queue sizes must be > 0"};
+    if (files.size() < 2 || files.size() > 3)
+      throw std::invalid_argument{"need a templates file, a log file and at "
+                                  "most one output file"};
+  } catch (const std::exception& e) {
+    std::cerr << "Invalid argument: " << e.what() << std::endl;
+    print_usage();
+    return -1;
+  }
+
+  auto catalog = flt::templating::template_catalog{};
+  {
+    auto fin = std::ifstream{files[0]};
+    if (!fin) {
+      std::cerr << "Couldn't open " << files[0] << std::endl;
+      return -1;
+    }
+    const auto suffix = std::string_view{"_pars"};
+    const auto has_params =
+        files[0].size() >= suffix.size() &&
+        files[0].compare(files[0].size() - suffix.size(), suffix.size(),
+                         suffix) == 0;
+    catalog = flt::templating::template_catalog{fin, has_params};
+  }
+  auto log_reader = std::optional<flt::io::line_reader>{};
+  auto fout = std::optional<std::ofstream>{};
+  try {
+    log_reader.emplace(files[1]);
+    if (files.size() == 3 && files[2] != "-") {
+      fout.emplace(files[2], std::ios::binary);
+      if (!*fout)
+        throw std::runtime_error{"Couldn't open " + files[2]};
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  auto& out = fout ? *fout : std::cout;
+
+  const auto t_start = clock_type::now();
+  const auto filters = flt::parameter_filter::default_filters<
+      std::back_insert_iterator<params_type>>();
+  using flt::util::bounded_queue;
+  auto read_queue = bounded_queue<line_batch>(queue_size);
+  auto classified_queue = bounded_queue<classified_batch>(queue_size);
+  auto error = std::exception_ptr{};
+  auto error_mutex = std::mutex{};
+  const auto set_error = [&] {
+    auto lock = std::lock_guard{error_mutex};
+    if (!error)
+      error = std::current_exception();
+  };
+
+  auto reader = std::thread{[&] {
+    try {
+      auto batch = line_batch{};
+      for (auto logline = std::string_view{}; log_reader->next(logline);) {
+        batch.lines.emplace_back(logline);
+        if (batch.lines.size() == batch_size) {
+          auto seq = batch.seq;
+          read_queue.push(std::move(batch));
+          batch = line_batch{seq + 1, false, {}};
+          batch.lines.reserve(batch_size);
+        }
+      }
+      if (!batch.lines.empty())
+        read_queue.push(std::move(batch));
+    } catch (...) {
+      set_error();
+    }
+    for (auto i = 0u; i < num_threads; ++i)
+      read_queue.push(line_batch{0, true, {}});
+  }};
+
+  auto classifiers = std::vector<std::thread>{};
+  for (auto i = 0u; i < num_threads; ++i) {
+    classifiers.emplace_back([&] {
+      auto batch = line_batch{};
+      auto filter_params = params_type{};
+      auto wildcard_params = std::vector<std::string_view>{};
+      auto filtered = std::string{};
+      for (;;) {
+        read_queue.pop(batch);
+        if (batch.last)
+          break;
+        auto result = classified_batch{batch.seq, false, 0, 0, {}};
+        result.num_lines = batch.lines.size();
+        try {
+          for (const auto& logline : batch.lines) {
+            filter_params.clear();
+            wildcard_params.clear();
+            if (with_params)
+              filters.filter_into(logline, filtered,
+                                  std::back_inserter(filter_params));
+            else
+              filters.filter_into(logline, filtered);
+            const auto id = catalog.match(
+                filtered, with_params ? &wildcard_params : nullptr);
+            if (id) {
+              ++result.num_matched;
+              result.output += std::to_string(*id);
+            } else {
+              result.output += '-';
+            }
+            if (with_params) {
+              for (const auto& param : wildcard_params) {
+                result.output += '\t';
+                append_escaped(result.output, param);
+              }
+              for (const auto& param : filter_params) {
+                result.output += '\t';
+                append_escaped(result.output, param);
+              }
+            }
+            result.output += '\n';
+          }
+        } catch (...) {
+          set_error();
+        }
+        classified_queue.push(std::move(result));
+      }
+      classified_queue.push(classified_batch{0, true, 0, 0, {}});
+    });
+  }
+
+  auto pending = std::map<std::size_t, classified_batch>{};
+  auto next_seq = std::size_t{0};
+  auto num_lines = std::uint64_t{0};
+  auto num_matched = std::uint64_t{0};
+  auto result = classified_batch{};
+  for (auto num_last = 0u; num_last < num_threads;) {
+    classified_queue.pop(result);
+    if (result.last) {
+      ++num_last;
+      continue;
+    }
+    pending.emplace(result.seq, std::move(result));
+    for (auto next = pending.begin();
+         next != pending.end() && next->first == next_seq;
+         next = pending.erase(next), ++next_seq) {
+      out.write(next->second.output.data(),
+                std::streamsize(next->second.output.size()));
+      num_lines += next->second.num_lines;
+      num_matched += next->second.num_matched;
+    }
+  }
+  reader.join();
+  for (auto& classifier : classifiers)
+    classifier.join();
+  out.flush();
+
+  if (error) {
+    try {
+      std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+  }
+  if (!out) {
+    std::cerr << "Couldn't write the output" << std::endl;
+    return -1;
+  }
+  const auto seconds =
+      std::chrono::duration<double>(clock_type::now() - t_start).count();
+  std::cerr << num_lines << " lines classified against " << catalog.size()
+            << " templates, " << num_matched << " matched, in " << std::fixed
+            << std::setprecision(3) << seconds << " s, "
+            << std::setprecision(0) << (seconds > 0 ? num_lines / seconds : 0.)
+            << " lines/s" << std::endl;
+  return 0;
+}